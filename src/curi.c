@@ -49,6 +49,13 @@ void curi_default_settings(curi_settings* settings)
     settings->query_item_key_separator = '=';
 }
 
+#define LIMIT(settings, limit) ((settings)->limits ? (settings)->limits->limit : 0)
+
+static int is_over_limit(size_t value, size_t limit)
+{
+    return limit != 0 && value > limit;
+}
+
 static curi_status handle_str_callback(int (*callback)(void* userData, const char* str, size_t strLen), const char* str, size_t strLen, const curi_settings* settings, void* userData)
 {
     curi_status status = curi_status_success;
@@ -67,7 +74,14 @@ static curi_status handle_str_callback_url_decoded(int (*callback)(void* userDat
     {
         size_t allocationSize = (strLen+1) * sizeof(char);
         size_t urlDecodedStrLen;
-        char* urlDecodedStr = (char*)settings->allocate(userData, allocationSize);
+        char* urlDecodedStr;
+
+        if (is_over_limit(strLen, LIMIT(settings, max_decoded_length)))
+            return curi_status_limit_exceeded;
+
+        urlDecodedStr = (char*)settings->allocate(userData, allocationSize);
+        if (!urlDecodedStr)
+            return curi_status_error;
 
         status = curi_url_decode(str,strLen,urlDecodedStr,strLen+1,&urlDecodedStrLen);
 
@@ -81,11 +95,28 @@ static curi_status handle_str_callback_url_decoded(int (*callback)(void* userDat
     return status;
 }
 
+static int equals_ignore_case(const char* str, size_t len, const char* lowercaseStr)
+{
+    size_t i;
+    for (i = 0 ; i < len ; ++i)
+        if (lowercaseStr[i] == '\0' || tolower((unsigned char)str[i]) != lowercaseStr[i])
+            return 0;
+    return lowercaseStr[len] == '\0';
+}
+
 static curi_status handle_scheme(const char* scheme, size_t schemeLen, const curi_settings* settings, void* userData)
 {
     return handle_str_callback(settings->scheme_callback, scheme, schemeLen, settings, userData);
 }
 
+static curi_status handle_scheme_id(curi_scheme_id schemeId, const curi_settings* settings, void* userData)
+{
+    if (settings->scheme_id_callback && settings->scheme_id_callback(userData, schemeId) == 0)
+        return curi_status_canceled;
+
+    return curi_status_success;
+}
+
 static curi_status handle_userinfo(const char* userinfo, size_t userinfoLen, const curi_settings* settings, void* userData)
 {
     if (settings->url_decode == 0)
@@ -94,37 +125,133 @@ static curi_status handle_userinfo(const char* userinfo, size_t userinfoLen, con
         return handle_str_callback_url_decoded(settings->userinfo_callback, userinfo, userinfoLen, settings, userData);
 }
 
-static curi_status handle_host(const char* host, size_t hostLen, const curi_settings* settings, void* userData)
+// Enough for a DNS name decoded to UTF-8
+#define NORMALIZED_HOST_MAX_LENGTH 1024
+
+static curi_status host_table_intern(curi_host_table* table, const char* host, size_t hostLen, unsigned int* hostId, char* canonicalHost);
+
+static curi_status handle_host_str(const char* host, size_t hostLen, int isRegName, const curi_settings* settings, void* userData)
 {
-    if (settings->url_decode == 0)
-        return handle_str_callback(settings->host_callback, host, hostLen, settings, userData);
+    curi_status status = handle_str_callback(settings->host_callback, host, hostLen, settings, userData);
+
+    if (status == curi_status_success && isRegName && settings->public_suffix_list && settings->registrable_domain_callback)
+    {
+        size_t domainOffset;
+        size_t domainLen;
+
+        // Hosts without registrable domain, like public suffixes, are not reported
+        if (curi_registrable_domain(settings->public_suffix_list, host, hostLen, &domainOffset, &domainLen) == curi_status_success)
+            if (settings->registrable_domain_callback(userData, host + domainOffset, domainLen) == 0)
+                status = curi_status_canceled;
+    }
+
+    // Hosts too long to be interned are reported to host_callback only
+    if (status == curi_status_success && settings->host_table && settings->host_id_callback && hostLen <= CURI_HOST_TABLE_MAX_HOST_LENGTH)
+    {
+        char canonicalHost[CURI_HOST_TABLE_MAX_HOST_LENGTH];
+        unsigned int hostId;
+
+        status = host_table_intern(settings->host_table, host, hostLen, &hostId, canonicalHost);
+
+        if (status == curi_status_success && settings->host_id_callback(userData, hostId, canonicalHost, hostLen) == 0)
+            status = curi_status_canceled;
+    }
+
+    return status;
+}
+
+static curi_status handle_host_normalized(const char* host, size_t hostLen, const curi_settings* settings, void* userData)
+{
+    char normalizedHost[NORMALIZED_HOST_MAX_LENGTH];
+    size_t normalizedHostLen;
+    curi_status status;
+
+    if (settings->host_cache)
+        status = curi_host_cache_normalize(settings->host_cache, host, hostLen, settings->host_normalization, normalizedHost, NORMALIZED_HOST_MAX_LENGTH, &normalizedHostLen);
     else
-        return handle_str_callback_url_decoded(settings->host_callback, host, hostLen, settings, userData);
+        status = curi_normalize_host(host, hostLen, settings->host_normalization, normalizedHost, NORMALIZED_HOST_MAX_LENGTH, &normalizedHostLen);
+
+    if (status == curi_status_success && normalizedHostLen > 0)
+        status = handle_host_str(normalizedHost, normalizedHostLen, 1, settings, userData);
+
+    return status;
 }
 
-static curi_status handle_port(const char* portStr, size_t portStrLen, const curi_settings* settings, void* userData)
+static curi_status handle_host_decoded(const char* host, size_t hostLen, int isRegName, const curi_settings* settings, void* userData)
 {
-    curi_status status = handle_str_callback(settings->portStr_callback, portStr, portStrLen, settings, userData);
+    if (isRegName && settings->host_normalization != 0)
+        return handle_host_normalized(host, hostLen, settings, userData);
+    else if (hostLen > 0)
+        return handle_host_str(host, hostLen, isRegName, settings, userData);
+    else
+        return curi_status_success;
+}
 
-    if (status == curi_status_success)
+static curi_status handle_host(const char* host, size_t hostLen, int isRegName, const curi_settings* settings, void* userData)
+{
+    if (hostLen == 0 || (!settings->host_callback && !(settings->host_table && settings->host_id_callback) && !(settings->public_suffix_list && settings->registrable_domain_callback)))
+        return curi_status_success;
+
+    if (settings->url_decode == 0)
     {
-        if (portStrLen > 0 && settings->port_callback)
-        {
-            unsigned int value = atoi(portStr); // Should work because there is no number after the port in URIs
-            if(settings->port_callback(userData, value) == 0)
-                status =  curi_status_canceled;
-        }
+        return handle_host_decoded(host, hostLen, isRegName, settings, userData);
     }
+    else
+    {
+        curi_status status;
+        size_t allocationSize = (hostLen+1) * sizeof(char);
+        size_t urlDecodedHostLen;
+        char* urlDecodedHost;
+
+        if (is_over_limit(hostLen, LIMIT(settings, max_decoded_length)))
+            return curi_status_limit_exceeded;
+
+        urlDecodedHost = (char*)settings->allocate(userData, allocationSize);
+        if (!urlDecodedHost)
+            return curi_status_error;
+
+        status = curi_url_decode(host, hostLen, urlDecodedHost, hostLen+1, &urlDecodedHostLen);
 
-    return status ;
+        if (status == curi_status_success)
+            status = handle_host_decoded(urlDecodedHost, urlDecodedHostLen, isRegName, settings, userData);
+
+        settings->deallocate(userData, urlDecodedHost, allocationSize);
+
+        return status;
+    }
 }
 
-static curi_status handle_path(const char* path, size_t pathLen, const curi_settings* settings, void* userData)
+static curi_status handle_host_ipv4(unsigned long address, const curi_settings* settings, void* userData)
 {
-    if (settings->url_decode == 0)
-        return handle_str_callback(settings->path_callback, path, pathLen, settings, userData);
+    if (settings->host_ipv4_callback && settings->host_ipv4_callback(userData, address) == 0)
+        return curi_status_canceled;
     else
-        return handle_str_callback_url_decoded(settings->path_callback, path, pathLen, settings, userData);
+        return curi_status_success;
+}
+
+static curi_status handle_host_ipv6(const unsigned char* address, const curi_settings* settings, void* userData)
+{
+    if (settings->host_ipv6_callback && settings->host_ipv6_callback(userData, address) == 0)
+        return curi_status_canceled;
+    else
+        return curi_status_success;
+}
+
+#define MAX_PORT 65535
+
+static curi_status handle_port(const char* portStr, size_t portStrLen, unsigned long port, const curi_settings* settings, void* userData)
+{
+    curi_status status = handle_str_callback(settings->portStr_callback, portStr, portStrLen, settings, userData);
+
+    if (status == curi_status_success && portStrLen > 0)
+    {
+        if (port > MAX_PORT)
+            status = handle_str_callback(settings->invalid_port_callback, portStr, portStrLen, settings, userData);
+        else if (settings->port_callback && settings->port_callback(userData, (unsigned int)port) == 0)
+            status = curi_status_canceled;
+    }
+
+    return status;
 }
 
 static curi_status handle_path_segment(const char* pathSegment, size_t pathSegmentLen, const curi_settings* settings, void* userData)
@@ -135,6 +262,58 @@ static curi_status handle_path_segment(const char* pathSegment, size_t pathSegme
         return handle_str_callback_url_decoded(settings->path_segment_callback, pathSegment, pathSegmentLen, settings, userData);
 }
 
+static curi_status handle_path_normalized(const char* path, size_t pathLen, const curi_settings* settings, void* userData)
+{
+    // The segments of normalized paths are handled once the whole path is known
+    curi_status status;
+    size_t allocationSize = (pathLen+1) * sizeof(char);
+    size_t normalizedPathLen;
+    char* normalizedPath = (char*)settings->allocate(userData, allocationSize);
+
+    if (!normalizedPath)
+        return curi_status_error;
+
+    memcpy(normalizedPath, path, pathLen);
+    status = curi_normalize_path(normalizedPath, pathLen, settings->path_normalization, &normalizedPathLen);
+
+    if (status == curi_status_success && settings->path_segment_callback)
+    {
+        size_t segmentStart = (normalizedPathLen > 0 && normalizedPath[0] == '/') ? 1 : 0;
+
+        while (status == curi_status_success && segmentStart < normalizedPathLen)
+        {
+            size_t segmentEnd = segmentStart;
+            while (segmentEnd < normalizedPathLen && normalizedPath[segmentEnd] != '/')
+                ++segmentEnd;
+
+            status = handle_path_segment(normalizedPath + segmentStart, segmentEnd - segmentStart, settings, userData);
+            segmentStart = segmentEnd + 1;
+        }
+    }
+
+    if (status == curi_status_success)
+    {
+        if (settings->url_decode == 0)
+            status = handle_str_callback(settings->path_callback, normalizedPath, normalizedPathLen, settings, userData);
+        else
+            status = handle_str_callback_url_decoded(settings->path_callback, normalizedPath, normalizedPathLen, settings, userData);
+    }
+
+    settings->deallocate(userData, normalizedPath, allocationSize);
+
+    return status;
+}
+
+static curi_status handle_path(const char* path, size_t pathLen, const curi_settings* settings, void* userData)
+{
+    if (settings->path_normalization != 0 && pathLen > 0 && (settings->path_callback || settings->path_segment_callback))
+        return handle_path_normalized(path, pathLen, settings, userData);
+    else if (settings->url_decode == 0)
+        return handle_str_callback(settings->path_callback, path, pathLen, settings, userData);
+    else
+        return handle_str_callback_url_decoded(settings->path_callback, path, pathLen, settings, userData);
+}
+
 static curi_status handle_query(const char* query, size_t queryLen, const curi_settings* settings, void* userData)
 {
     if (settings->url_decode == 0)
@@ -200,7 +379,14 @@ static curi_status handle_query_item_decodedKey(const char* key, size_t keyLen,
 
             size_t valueAllocationSize = (valueLen+1) * sizeof(char);
             size_t urlDecodedValueLen = 0;
-            char* urlDecodedValue = (char*)settings->allocate(userData, valueAllocationSize);
+            char* urlDecodedValue;
+
+            if (is_over_limit(valueLen, LIMIT(settings, max_decoded_length)))
+                return curi_status_limit_exceeded;
+
+            urlDecodedValue = (char*)settings->allocate(userData, valueAllocationSize);
+            if (!urlDecodedValue)
+                return curi_status_error;
 
             status = curi_url_decode(value,valueLen,urlDecodedValue,valueLen+1,&urlDecodedValueLen);
 
@@ -230,7 +416,14 @@ static curi_status handle_query_item(const char* key, size_t keyLen, const char*
         {
             size_t keyAllocationSize = (keyLen+1) * sizeof(char);
             size_t urlDecodedKeyLen;
-            char* urlDecodedKey = (char*)settings->allocate(userData, keyAllocationSize);
+            char* urlDecodedKey;
+
+            if (is_over_limit(keyLen, LIMIT(settings, max_decoded_length)))
+                return curi_status_limit_exceeded;
+
+            urlDecodedKey = (char*)settings->allocate(userData, keyAllocationSize);
+            if (!urlDecodedKey)
+                return curi_status_error;
 
             status = curi_url_decode(key, keyLen, urlDecodedKey, keyLen+1, &urlDecodedKeyLen);
 
@@ -251,6 +444,33 @@ static curi_status handle_fragment(const char* fragment, size_t fragmentLen, con
         return handle_str_callback_url_decoded(settings->fragment_callback, fragment, fragmentLen, settings, userData);
 }
 
+typedef struct
+{
+    const curi_settings* settings;
+    void* userData;
+} url_rule_callback_data;
+
+static int url_rule_callback_visitor(void* data, size_t ruleId)
+{
+    const url_rule_callback_data* callbackData = (const url_rule_callback_data*)data;
+    return callbackData->settings->url_rule_callback(callbackData->userData, ruleId);
+}
+
+static curi_status url_matcher_visit(const curi_url_matcher* matcher, const char* host, size_t hostLen, const char* path, size_t pathLen, int (*visitor)(void* data, size_t ruleId), void* data);
+
+static curi_status handle_url_rules(const char* host, size_t hostLen, const char* path, size_t pathLen, const curi_settings* settings, void* userData)
+{
+    if (settings->url_matcher && settings->url_rule_callback)
+    {
+        url_rule_callback_data data;
+        data.settings = settings;
+        data.userData = userData;
+        return url_matcher_visit(settings->url_matcher, host, hostLen, path, pathLen, url_rule_callback_visitor, &data);
+    }
+    else
+        return curi_status_success;
+}
+
 static const char end = '\0';
 
 static const char* read_char(const char* uri, size_t len, size_t* offset)
@@ -264,6 +484,32 @@ static const char* read_char(const char* uri, size_t len, size_t* offset)
     return c;
 }
 
+static char peek_char(const char* str, size_t len, size_t offset)
+{
+    return offset < len ? str[offset] : '\0';
+}
+
+static void set_error(curi_error_rule rule, const char* uri, size_t len, size_t offset, curi_error* error)
+{
+    // Keeping the furthest error, the first one found at a given offset being the most specific
+    if (error && (error->rule == curi_error_none || offset > error->offset))
+    {
+        error->rule = rule;
+        error->offset = offset;
+        error->character = peek_char(uri, len, offset);
+    }
+}
+
+static void reset_error(curi_error* error)
+{
+    if (error)
+    {
+        error->rule = curi_error_none;
+        error->offset = 0;
+        error->character = '\0';
+    }
+}
+
 #define TRY(status, offset, parse_fun_call) \
 { \
     size_t __TRY_initialOffset = *(offset); \
@@ -274,6 +520,55 @@ static const char* read_char(const char* uri, size_t len, size_t* offset)
         status = __TRY_tryStatus; \
 } \
 
+// Character classes of the RFC-3986 grammar, indexed by byte value
+#define CHAR_CLASS_ALPHA 0x01
+#define CHAR_CLASS_DIGIT 0x02
+#define CHAR_CLASS_HEXDIGIT 0x04
+#define CHAR_CLASS_UNRESERVED 0x08
+#define CHAR_CLASS_SUB_DELIMS 0x10
+#define CHAR_CLASS_PCHAR_NO_PCT 0x20
+#define CHAR_CLASS_QUERY_FRAGMENT_CHAR_NO_PCT 0x40
+#define CHAR_CLASS_SCHEME 0x80
+
+#define A CHAR_CLASS_ALPHA
+#define D CHAR_CLASS_DIGIT
+#define H CHAR_CLASS_HEXDIGIT
+#define U CHAR_CLASS_UNRESERVED
+#define S CHAR_CLASS_SUB_DELIMS
+#define P CHAR_CLASS_PCHAR_NO_PCT
+#define Q CHAR_CLASS_QUERY_FRAGMENT_CHAR_NO_PCT
+#define C CHAR_CLASS_SCHEME
+
+static const unsigned char char_classes[256] =
+{
+    0, 0, 0, 0, 0, 0, 0, 0, // 0x00-0x07
+    0, 0, 0, 0, 0, 0, 0, 0, // 0x08-0x0F
+    0, 0, 0, 0, 0, 0, 0, 0, // 0x10-0x17
+    0, 0, 0, 0, 0, 0, 0, 0, // 0x18-0x1F
+    0, S|P|Q, 0, 0, S|P|Q, 0, S|P|Q, S|P|Q, // 0x20-0x27
+    S|P|Q, S|P|Q, S|P|Q, S|P|Q|C, S|P|Q, U|P|Q|C, U|P|Q|C, Q, // 0x28-0x2F
+    D|H|U|P|Q|C, D|H|U|P|Q|C, D|H|U|P|Q|C, D|H|U|P|Q|C, D|H|U|P|Q|C, D|H|U|P|Q|C, D|H|U|P|Q|C, D|H|U|P|Q|C, // 0x30-0x37
+    D|H|U|P|Q|C, D|H|U|P|Q|C, P|Q, S|P|Q, 0, S|P|Q, 0, Q, // 0x38-0x3F
+    P|Q, A|H|U|P|Q|C, A|H|U|P|Q|C, A|H|U|P|Q|C, A|H|U|P|Q|C, A|H|U|P|Q|C, A|H|U|P|Q|C, A|U|P|Q|C, // 0x40-0x47
+    A|U|P|Q|C, A|U|P|Q|C, A|U|P|Q|C, A|U|P|Q|C, A|U|P|Q|C, A|U|P|Q|C, A|U|P|Q|C, A|U|P|Q|C, // 0x48-0x4F
+    A|U|P|Q|C, A|U|P|Q|C, A|U|P|Q|C, A|U|P|Q|C, A|U|P|Q|C, A|U|P|Q|C, A|U|P|Q|C, A|U|P|Q|C, // 0x50-0x57
+    A|U|P|Q|C, A|U|P|Q|C, A|U|P|Q|C, 0, 0, 0, 0, U|P|Q, // 0x58-0x5F
+    0, A|H|U|P|Q|C, A|H|U|P|Q|C, A|H|U|P|Q|C, A|H|U|P|Q|C, A|H|U|P|Q|C, A|H|U|P|Q|C, A|U|P|Q|C, // 0x60-0x67
+    A|U|P|Q|C, A|U|P|Q|C, A|U|P|Q|C, A|U|P|Q|C, A|U|P|Q|C, A|U|P|Q|C, A|U|P|Q|C, A|U|P|Q|C, // 0x68-0x6F
+    A|U|P|Q|C, A|U|P|Q|C, A|U|P|Q|C, A|U|P|Q|C, A|U|P|Q|C, A|U|P|Q|C, A|U|P|Q|C, A|U|P|Q|C, // 0x70-0x77
+    A|U|P|Q|C, A|U|P|Q|C, A|U|P|Q|C, 0, 0, 0, U|P|Q, 0, // 0x78-0x7F
+    // 0x80-0xFF are all zero
+};
+
+#undef A
+#undef D
+#undef H
+#undef U
+#undef S
+#undef P
+#undef Q
+#undef C
+
 #define CASE_ALPHA \
     case 'A': \
     case 'B': \
@@ -340,7 +635,7 @@ static const char* read_char(const char* uri, size_t len, size_t* offset)
     case '8': \
     case '9'
 
-static curi_status parse_digit(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData)
+static curi_status parse_digit(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData, curi_error* error)
 {
     switch (*read_char(uri,len,offset))
     {
@@ -351,7 +646,7 @@ static curi_status parse_digit(const char* uri, size_t len, size_t* offset, cons
     }
 }
 
-static curi_status parse_char(char c, const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userDatat)
+static curi_status parse_char(char c, const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData, curi_error* error)
 {
     if (*read_char(uri,len,offset) == c)
         return curi_status_success;
@@ -359,7 +654,7 @@ static curi_status parse_char(char c, const char* uri, size_t len, size_t* offse
         return curi_status_error;
 }
 
-static curi_status parse_scheme(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData)
+static curi_status parse_scheme(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData, curi_error* error)
 {
     // scheme = ALPHA *( ALPHA / DIGIT / "+" / "-" / ".")
     const size_t schemeStartOffset = *offset;
@@ -413,7 +708,7 @@ static curi_status parse_scheme(const char* uri, size_t len, size_t* offset, con
     case '_': \
     case '~'
 
-static curi_status parse_unreserved(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData)
+static curi_status parse_unreserved(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData, curi_error* error)
 {
     // unreserved = ALPHA / DIGIT / "-" / "." / "_" / "~"
     switch (*read_char(uri,len,offset))
@@ -440,7 +735,7 @@ static curi_status parse_unreserved(const char* uri, size_t len, size_t* offset,
     case 'e': \
     case 'f'
 
-static curi_status parse_hexdigit(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData)
+static curi_status parse_hexdigit(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData, curi_error* error)
 {
     switch (*read_char(uri,len,offset))
     {
@@ -451,14 +746,18 @@ static curi_status parse_hexdigit(const char* uri, size_t len, size_t* offset, c
     }
 }
 
-static curi_status parse_h8(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData)
+static curi_status parse_h8(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData, curi_error* error)
 {
     // h8 = HEXDIG HEXDIG
+    // Always following a '%', which isn't valid anywhere else, its failure is reported.
+    const size_t percentOffset = *offset - 1;
+
     switch (*read_char(uri,len,offset))
     {
         CASE_HEXDIGIT:
             break;
         default:
+            set_error(curi_error_percent_encoding, uri, len, percentOffset, error);
             return curi_status_error;
     }
 
@@ -467,11 +766,12 @@ static curi_status parse_h8(const char* uri, size_t len, size_t* offset, const c
         CASE_HEXDIGIT:
             return curi_status_success;
         default:
+            set_error(curi_error_percent_encoding, uri, len, percentOffset, error);
             return curi_status_error;
     }
 }
 
-static curi_status parse_percent_encoded(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData)
+static curi_status parse_percent_encoded(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData, curi_error* error)
 {
     // percent-encoded = "%" h8
     switch (*read_char(uri,len,offset))
@@ -482,7 +782,7 @@ static curi_status parse_percent_encoded(const char* uri, size_t len, size_t* of
             return curi_status_error;
     }
 
-    return parse_h8(uri,len,offset,settings,userData);
+    return parse_h8(uri, len, offset, settings, userData, error);
 }
 
 #define CASE_SUB_DELIMS \
@@ -498,7 +798,7 @@ static curi_status parse_percent_encoded(const char* uri, size_t len, size_t* of
     case ';': \
     case '='
 
-static curi_status parse_sub_delims(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData)
+static curi_status parse_sub_delims(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData, curi_error* error)
 {
     //sub-delims    = "!" / "$" / "&" / "'" / "(" / ")"
     //             / "*" / "+" / "," / ";" / "="
@@ -511,7 +811,7 @@ static curi_status parse_sub_delims(const char* uri, size_t len, size_t* offset,
     }
 }
 
-static curi_status parse_userinfo_and_at(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData)
+static curi_status parse_userinfo_and_at(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData, curi_error* error)
 {
     // userinfo_and_at = userinfo "@"
     // userinfo = *( unreserved / "%" h8 / sub-delims / ":" )
@@ -527,7 +827,7 @@ static curi_status parse_userinfo_and_at(const char* uri, size_t len, size_t* of
             CASE_UNRESERVED:
                 break;
             case '%':
-                status = parse_h8(uri, len, offset, settings, userData);
+                status = parse_h8(uri, len, offset, settings, userData, error);
                 break;
             CASE_SUB_DELIMS:
             case ':':
@@ -541,7 +841,7 @@ static curi_status parse_userinfo_and_at(const char* uri, size_t len, size_t* of
 
     userinfoEndOffset = *offset;
 
-    status = parse_char('@', uri, len, offset, settings, userData);
+    status = parse_char('@', uri, len, offset, settings, userData, error);
 
     if (status == curi_status_success)
         status = handle_userinfo(uri + userinfoStartOffset, userinfoEndOffset - userinfoStartOffset, settings, userData);
@@ -549,7 +849,7 @@ static curi_status parse_userinfo_and_at(const char* uri, size_t len, size_t* of
     return status;
 }
 
-static curi_status parse_reg_name(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData)
+static curi_status parse_reg_name(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData, curi_error* error)
 {
     // reg-name = *( unreserved / "%" h8 / sub-delims )
     curi_status status = curi_status_success;
@@ -562,7 +862,7 @@ static curi_status parse_reg_name(const char* uri, size_t len, size_t* offset, c
             CASE_UNRESERVED:
                 break;
             case '%':
-                status = parse_h8(uri, len, offset, settings, userData);
+                status = parse_h8(uri, len, offset, settings, userData, error);
                 break;
             CASE_SUB_DELIMS:
                 break;
@@ -576,122 +876,117 @@ static curi_status parse_reg_name(const char* uri, size_t len, size_t* offset, c
     return curi_status_success;
 }
 
-static curi_status parse_dec_octet(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData)
+static int is_reg_name_char(const char* uri, size_t len, size_t offset)
+{
+    const char c = *read_char(uri, len, &offset);
+    return c == '%' || (char_classes[(unsigned char)c] & (CHAR_CLASS_UNRESERVED | CHAR_CLASS_SUB_DELIMS));
+}
+
+static curi_status parse_dec_octet(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData, curi_error* error, unsigned long* octet)
 {
     // dec-octet = DIGIT                 ; 0-9
     //           / %x31-39 DIGIT         ; 10-99
     //           / "1" 2DIGIT            ; 100-199
     //           / "2" %x30-34 DIGIT     ; 200-249
     //           / "25" %x30-35          ; 250-255
-    int number;
-    char numberStr[4] = {'\0', '\0', '\0', '\0'};
-    size_t previousOffset;
-    size_t i;
+    // That is to say 1 to 3 digits, without leading zero, up to 255.
+    // The value is accumulated while scanning, only digits are consumed.
+    const size_t initialOffset = *offset;
+    unsigned long value = 0;
+    size_t digitCount;
 
-    for (i = 0 ; i < 3 ; ++i)
+    for (digitCount = 0 ; digitCount < 3 ; ++digitCount)
     {
-        previousOffset = *offset;
-        if (parse_digit(uri, len, offset, settings, userData) !=  curi_status_success)
+        const size_t previousOffset = *offset;
+        const unsigned int digit = (unsigned int)((unsigned char)*read_char(uri, len, offset) - '0');
+
+        if (digit > 9)
         {
             *offset = previousOffset;
             break;
         }
-        numberStr[i] = uri[previousOffset];
+
+        value = value * 10 + digit;
     }
 
-    number = atoi(numberStr);
-    if (number >= 0 && number <= 255)
-        return curi_status_success;
-    else
+    if (digitCount == 0 || value > 255 || (digitCount > 1 && uri[initialOffset] == '0'))
         return curi_status_error;
+
+    *octet = value;
+    return curi_status_success;
 }
 
-static curi_status parse_IPv4address(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData)
+static curi_status parse_IPv4address(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData, curi_error* error, unsigned long* address)
 {
     // IPv4address = dec-octet "." dec-octet "." dec-octet "." dec-octet
-    curi_status status = curi_status_success;
-
-    if (status == curi_status_success)
-        status = parse_dec_octet(uri, len, offset, settings, userData);
-
-    if (status == curi_status_success)
-        status = parse_char('.', uri, len, offset, settings, userData);
+    // On error, only digits and dots have been consumed.
+    size_t i;
 
-    if (status == curi_status_success)
-        status = parse_dec_octet(uri, len, offset, settings, userData);
+    *address = 0;
 
-    if (status == curi_status_success)
-        status = parse_char('.', uri, len, offset, settings, userData);
+    for (i = 0 ; i < 4 ; ++i)
+    {
+        unsigned long octet;
 
-    if (status == curi_status_success)
-        status = parse_dec_octet(uri, len, offset, settings, userData);
+        if (i > 0)
+        {
+            if (*read_char(uri, len, offset) != '.')
+            {
+                --(*offset);
+                return curi_status_error;
+            }
+        }
 
-    if (status == curi_status_success)
-        status = parse_char('.', uri, len, offset, settings, userData);
+        if (parse_dec_octet(uri, len, offset, settings, userData, error, &octet) != curi_status_success)
+            return curi_status_error;
 
-    if (status == curi_status_success)
-        status = parse_dec_octet(uri, len, offset, settings, userData);
+        *address = (*address << 8) | octet;
+    }
 
-    return status;
+    return curi_status_success;
 }
 
-static curi_status parse_h16(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData)
+static int hexdigit_value(char c)
 {
-    // h16 = 1*4HEXDIG
-    curi_status status = curi_status_success;
-    size_t i;
-
-    if (status == curi_status_success)
-        status = parse_hexdigit(uri, len, offset, settings, userData);
-
-    for (i = 0 ; i < 3 ; ++i)
-        TRY(status,offset,parse_hexdigit(uri, len, offset, settings, userData));
-
-    return status;
+    switch (c)
+    {
+        CASE_DIGIT:
+            return c - '0';
+        case 'A': case 'B': case 'C': case 'D': case 'E': case 'F':
+            return c - 'A' + 10;
+        case 'a': case 'b': case 'c': case 'd': case 'e': case 'f':
+            return c - 'a' + 10;
+        default:
+            return -1;
+    }
 }
 
-static curi_status parse_h16_and_colon(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData)
+static size_t parse_h16(const char* uri, size_t len, size_t* offset, unsigned int* value)
 {
-    // h16_and_colon = h16 ":"
-    curi_status status = curi_status_success;
-
-    if (status == curi_status_success)
-        status = parse_h16(uri, len, offset, settings, userData);
-
-    if (status == curi_status_success)
-        status = parse_char(':', uri, len, offset, settings, userData);
-
-    return status;
-}
+    // h16 = 1*4HEXDIG
+    // Returns the number of digits read, stopping before the first non-hexdigit.
+    size_t digitCount;
 
-static curi_status parse_ls32(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData)
-{
-    // ls32 = ( h16_and_colon h16 ) / IPv4address
-    curi_status status = curi_status_error;
+    *value = 0;
 
-    if (status == curi_status_error)
+    for (digitCount = 0 ; digitCount < 4 ; ++digitCount)
     {
-        size_t initialOffset = *offset;
-        curi_status tryStatus = curi_status_success;
+        const size_t previousOffset = *offset;
+        const int digitValue = hexdigit_value(*read_char(uri, len, offset));
 
-        if (tryStatus == curi_status_success)
-            tryStatus = parse_h16_and_colon(uri, len, offset, settings, userData);
-        if (tryStatus == curi_status_success)
-            tryStatus = parse_h16(uri, len, offset, settings, userData);
+        if (digitValue < 0)
+        {
+            *offset = previousOffset;
+            break;
+        }
 
-        if (tryStatus == curi_status_error)
-            *offset = initialOffset;
-        else
-            status = tryStatus;
+        *value = (*value << 4) | (unsigned int)digitValue;
     }
 
-    if (status == curi_status_error)
-        TRY(status,offset,parse_IPv4address(uri, len, offset, settings, userData));
-
-    return status;
+    return digitCount;
 }
 
-static curi_status parse_IPv6address(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData)
+static curi_status parse_IPv6address(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData, curi_error* error, unsigned char* address)
 {
     // IPv6address =                            6( h16 ":" ) ls32
     //             /                       "::" 5( h16 ":" ) ls32
@@ -702,98 +997,145 @@ static curi_status parse_IPv6address(const char* uri, size_t len, size_t* offset
     //             / [ *4( h16 ":" ) h16 ] "::"              ls32
     //             / [ *5( h16 ":" ) h16 ] "::"              h16
     //             / [ *6( h16 ":" ) h16 ] "::"
+    // ls32        = ( h16 ":" h16 ) / IPv4address
+
+    // All the alternatives boil down to a list of h16 separated by ":", where
+    // - at most one separator is a "::" (the compression),
+    // - an IPv4address can replace the last two h16,
+    // - there is exactly 8 h16 without compression and at most 7 with it.
+    // It is thus recognized in a single pass, without backtracking.
+
+    unsigned int groups[8];
+    size_t groupCount = 0;
+    size_t compressionIndex = 0;
+    int compressed = 0;
+    size_t i;
 
-    // Let's simplify it to [ (":" / 1*7(h16_and_colon)) ":"] ( (0*6(h16_and_colon) ls32) / h16 )
-
-    curi_status status = curi_status_success;
-
-    if (status == curi_status_success)
+    // Leading "::"
+    if (*read_char(uri, len, offset) == ':')
     {
-        size_t initialOffset = *offset;
-        curi_status tryStatus = curi_status_error;
+        if (parse_char(':', uri, len, offset, settings, userData, error) != curi_status_success)
+            return curi_status_error;
+        compressed = 1;
+    }
+    else
+    {
+        --(*offset);
+    }
 
-        if (tryStatus == curi_status_error)
-            TRY(tryStatus,offset,parse_char(':', uri, len, offset, settings, userData));
+    for ( ; ; )
+    {
+        const size_t groupOffset = *offset;
+        unsigned int value;
+        size_t previousOffset;
+        char c;
 
-        if (tryStatus == curi_status_error)
+        if (parse_h16(uri, len, offset, &value) == 0)
         {
-            size_t i;
-            tryStatus = curi_status_success;
+            // Only allowed right after the compression, ending the address
+            if (compressed && compressionIndex == groupCount)
+                break;
+            else
+                return curi_status_error;
+        }
 
-            if (tryStatus == curi_status_success)
-                tryStatus = parse_h16_and_colon(uri, len, offset, settings, userData);
+        previousOffset = *offset;
+        c = *read_char(uri, len, offset);
 
-            for (i = 0 ; i < 6 ; ++i)
-                TRY(tryStatus,offset,parse_h16_and_colon(uri, len, offset, settings, userData));
+        if (c == '.')
+        {
+            // ls32 as an IPv4address, ending the address
+            unsigned long ipv4Address;
+            *offset = groupOffset;
+            if (groupCount > 6 || parse_IPv4address(uri, len, offset, settings, userData, error, &ipv4Address) != curi_status_success)
+                return curi_status_error;
+            groups[groupCount++] = (unsigned int)(ipv4Address >> 16);
+            groups[groupCount++] = (unsigned int)(ipv4Address & 0xFFFF);
+            break;
         }
 
-        if (tryStatus == curi_status_success)
-            tryStatus = parse_char(':', uri, len, offset, settings, userData);
+        if (groupCount == 8)
+            return curi_status_error;
+        groups[groupCount++] = value;
 
-        if (tryStatus == curi_status_error)
-            *offset = initialOffset;
+        if (c != ':')
+        {
+            *offset = previousOffset;
+            break;
+        }
+
+        previousOffset = *offset;
+        if (*read_char(uri, len, offset) == ':')
+        {
+            if (compressed)
+                return curi_status_error; // Only one compression allowed
+            compressed = 1;
+            compressionIndex = groupCount;
+        }
         else
-            status = tryStatus;
+        {
+            *offset = previousOffset;
+        }
     }
 
-    if (status == curi_status_success)
-    {
-        status = curi_status_error;
+    if (compressed ? groupCount > 7 : groupCount != 8)
+        return curi_status_error;
 
-        if (status == curi_status_error)
-        {
-            size_t initialOffset = *offset;
-            curi_status tryStatus = curi_status_success;
-            size_t i;
-            for (i = 0 ; i < 6 ; ++i)
-                TRY(tryStatus,offset,parse_h16_and_colon(uri, len, offset, settings, userData));
-
-            if (tryStatus == curi_status_success)
-                tryStatus = parse_ls32(uri, len, offset, settings, userData);
-
-            if (tryStatus == curi_status_error)
-                *offset = initialOffset;
-            else
-                status = tryStatus;
-        }
+    if (!compressed)
+        compressionIndex = 8;
 
-        if (status == curi_status_error)
-            TRY(status,offset,parse_h16(uri, len, offset, settings, userData));
+    // Expanding the compression
+    for (i = 0 ; i < 8 ; ++i)
+    {
+        unsigned int value = 0;
+        if (i < compressionIndex)
+            value = groups[i];
+        else if (i >= compressionIndex + 8 - groupCount)
+            value = groups[i - (8 - groupCount)];
+        address[2 * i] = (unsigned char)(value >> 8);
+        address[2 * i + 1] = (unsigned char)(value & 0xFF);
     }
 
-    return status;
+    return curi_status_success;
 }
 
-static curi_status parse_IPvFuture(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData)
+static curi_status parse_IPvFuture(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData, curi_error* error)
 {
     // IPvFuture     = "v" 1*HEXDIG "." 1*( unreserved / sub-delims / ":" )
     curi_status status = curi_status_success;
 
     if (status == curi_status_success)
-        status = parse_char('v', uri, len, offset, settings, userData);
+        status = parse_char('v', uri, len, offset, settings, userData, error);
     if (status == curi_status_success)
-        status = parse_hexdigit(uri, len, offset, settings, userData);
+        status = parse_hexdigit(uri, len, offset, settings, userData, error);
+    if (status == curi_status_success)
+    {
+        size_t previousOffset = *offset;
+        while (parse_hexdigit(uri, len, offset, settings, userData, error) == curi_status_success)
+            previousOffset = *offset;
+        *offset = previousOffset;
+    }
     if (status == curi_status_success)
-        status = parse_char('.', uri, len, offset, settings, userData);
+        status = parse_char('.', uri, len, offset, settings, userData, error);
     if (status == curi_status_success)
     {
         status = curi_status_error;
         if (status == curi_status_error)
-            TRY(status,offset,parse_unreserved(uri, len, offset, settings, userData));
+            TRY(status,offset,parse_unreserved(uri, len, offset, settings, userData, error));
         if (status == curi_status_error)
-            TRY(status,offset,parse_sub_delims(uri, len, offset, settings, userData));
+            TRY(status,offset,parse_sub_delims(uri, len, offset, settings, userData, error));
         if (status == curi_status_error)
-            TRY(status,offset,parse_char(':', uri, len, offset, settings, userData));
+            TRY(status,offset,parse_char(':', uri, len, offset, settings, userData, error));
 
         while(status == curi_status_success)
         {
             status = curi_status_error;
             if (status == curi_status_error)
-                TRY(status,offset,parse_unreserved(uri, len, offset, settings, userData));
+                TRY(status,offset,parse_unreserved(uri, len, offset, settings, userData, error));
             if (status == curi_status_error)
-                TRY(status,offset,parse_sub_delims(uri, len, offset, settings, userData));
+                TRY(status,offset,parse_sub_delims(uri, len, offset, settings, userData, error));
             if (status == curi_status_error)
-                TRY(status,offset,parse_char(':', uri, len, offset, settings, userData));
+                TRY(status,offset,parse_char(':', uri, len, offset, settings, userData, error));
             if (status == curi_status_error)
             {
                 status = curi_status_success;
@@ -806,97 +1148,157 @@ static curi_status parse_IPvFuture(const char* uri, size_t len, size_t* offset,
     return status;
 }
 
-static curi_status parse_IP_literal(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData)
+static curi_status parse_IP_literal(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData, curi_error* error, unsigned char* ipv6Address, int* isIPv6)
 {
     // IP-literal    = "[" ( IPv6address / IPvFuture  ) "]"
+    const size_t initialOffset = *offset;
     curi_status status = curi_status_success;
 
     if (status == curi_status_success)
-        status = parse_char('[', uri, len, offset, settings, userData);
+        status = parse_char('[', uri, len, offset, settings, userData, error);
+
+    if (status == curi_status_error)
+        return status;
 
     if (status == curi_status_success)
     {
         status = curi_status_error;
 
         if (status == curi_status_error)
-            TRY(status, offset, parse_IPv6address(uri, len, offset, settings, userData));
+        {
+            TRY(status, offset, parse_IPv6address(uri, len, offset, settings, userData, error, ipv6Address));
+            *isIPv6 = (status == curi_status_success);
+        }
 
         if (status == curi_status_error)
-            TRY(status, offset, parse_IPvFuture(uri, len, offset, settings, userData));
+            TRY(status, offset, parse_IPvFuture(uri, len, offset, settings, userData, error));
     }
 
     if (status == curi_status_success)
-        status = parse_char(']', uri, len, offset, settings, userData);
+        status = parse_char(']', uri, len, offset, settings, userData, error);
+
+    // As '[' only starts IP literals, the failure is reported
+    if (status == curi_status_error)
+        set_error(curi_error_ip_literal, uri, len, initialOffset, error);
 
     return status;
 }
 
-static curi_status parse_host(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData)
+static curi_status parse_host(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData, curi_error* error)
 {
     // host = IP-literal / IPv4address / reg-name
     const size_t initialOffset = *offset;
     curi_status status = curi_status_error;
+    unsigned long ipv4Address;
+    unsigned char ipv6Address[16];
+    int isIPv4 = 0;
+    int isIPv6 = 0;
+    int isRegName = 0;
 
     if (status == curi_status_error)
-        TRY(status, offset, parse_IP_literal(uri, len, offset, settings, userData));
-
-    if (status == curi_status_error)
-        TRY(status, offset, parse_IPv4address(uri, len, offset, settings, userData));
+    {
+        TRY(status, offset, parse_IP_literal(uri, len, offset, settings, userData, error, ipv6Address, &isIPv6));
+        if (status == curi_status_error)
+            isIPv6 = 0;
+    }
 
     if (status == curi_status_error)
-        TRY(status, offset, parse_reg_name(uri, len, offset, settings, userData));
+    {
+        // The host is an IPv4address only if it is not followed by other reg-name characters.
+        // Otherwise, as digits and dots are valid reg-name characters, the reg-name parsing
+        // resumes where the IPv4address parsing stopped.
+        if (parse_IPv4address(uri, len, offset, settings, userData, error, &ipv4Address) == curi_status_success && !is_reg_name_char(uri, len, *offset))
+            isIPv4 = 1;
+        else
+        {
+            parse_reg_name(uri, len, offset, settings, userData, error);
+            isRegName = 1;
+        }
+        status = curi_status_success;
+    }
 
     if (status == curi_status_success)
-        status = handle_host(uri + initialOffset, *offset - initialOffset, settings, userData);
+        status = handle_host(uri + initialOffset, *offset - initialOffset, isRegName, settings, userData);
+
+    if (status == curi_status_success && isIPv4)
+        status = handle_host_ipv4(ipv4Address, settings, userData);
+
+    if (status == curi_status_success && isIPv6)
+        status = handle_host_ipv6(ipv6Address, settings, userData);
 
     return status;
 }
 
-static curi_status parse_port(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData)
+static curi_status parse_port(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData, curi_error* error)
 {
     // port = *DIGIT
     const size_t initialOffset = *offset;
+    unsigned long port = 0;
 
     for ( ; ; )
     {
         size_t subOffset = *offset;
-        curi_status subStatus = parse_digit(uri, len, &subOffset, settings, userData);
+        curi_status subStatus = parse_digit(uri, len, &subOffset, settings, userData, error);
 
         if (subStatus == curi_status_success)
+        {
+            // Accumulating while scanning, once above the maximum port the value can only grow
+            if (port <= MAX_PORT)
+                port = port * 10 + (unsigned long)(uri[*offset] - '0');
             *offset = subOffset;
+        }
         else
             break;
     }
 
-    return handle_port(uri + initialOffset, *offset - initialOffset, settings, userData);
+    return handle_port(uri + initialOffset, *offset - initialOffset, port, settings, userData);
 }
 
-static curi_status parse_authority(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData)
+static curi_status parse_authority(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData, curi_error* error, size_t* hostOffset, size_t* hostLen)
 {
     // authority = [ userinfo_and_at ] host [ ":" port ]
 
     curi_status status = curi_status_success;
 
     if (status == curi_status_success)
-        TRY(status, offset, parse_userinfo_and_at(uri, len, offset, settings, userData));
+        TRY(status, offset, parse_userinfo_and_at(uri, len, offset, settings, userData, error));
+
+    *hostOffset = *offset;
 
     if (status == curi_status_success)
-        status = parse_host(uri, len, offset, settings, userData);
+        status = parse_host(uri, len, offset, settings, userData, error);
+
+    *hostLen = *offset - *hostOffset;
 
     if (status == curi_status_success)
     {
         size_t initialOffset = *offset;
         curi_status subStatus = curi_status_success;
         if (subStatus == curi_status_success)
-            subStatus = parse_char(':', uri, len, offset, settings, userData);
+            subStatus = parse_char(':', uri, len, offset, settings, userData, error);
         if (subStatus == curi_status_success)
-            subStatus = parse_port(uri, len, offset, settings, userData);
+            subStatus = parse_port(uri, len, offset, settings, userData, error);
         if (subStatus == curi_status_error)
             *offset = initialOffset;
         else
             status = subStatus;
     }
 
+    if (status == curi_status_success && error)
+    {
+        // Only a path-abempty, a query or a fragment can follow an authority
+        switch (peek_char(uri, len, *offset))
+        {
+            case '/':
+            case '?':
+            case '#':
+            case '\0':
+                break;
+            default:
+                set_error(curi_error_authority, uri, len, *offset, error);
+        }
+    }
+
     return status;
 }
 
@@ -906,7 +1308,7 @@ static curi_status parse_authority(const char* uri, size_t len, size_t* offset,
     case ':': \
     case '@'
 
-static curi_status parse_pchar(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData)
+static curi_status parse_pchar(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData, curi_error* error)
 {
     // pchar = unreserved / "%" h8 / sub-delims / ":" / "@"
     switch (*read_char(uri,len,offset))
@@ -914,13 +1316,13 @@ static curi_status parse_pchar(const char* uri, size_t len, size_t* offset, cons
         CASE_PCHAR_NO_PCT:
             return curi_status_success;
         case '%':
-            return parse_h8(uri, len, offset, settings, userData);
+            return parse_h8(uri, len, offset, settings, userData, error);
         default:
             return curi_status_error;
     }
 }
 
-static curi_status parse_pchars(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData)
+static curi_status parse_pchars(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData, curi_error* error)
 {
     // pchars = *pchar
 
@@ -929,7 +1331,7 @@ static curi_status parse_pchars(const char* uri, size_t len, size_t* offset, con
     while (status == curi_status_success)
     {
         size_t subOffset = *offset;
-        curi_status subStatus = parse_pchar(uri, len, &subOffset, settings, userData);
+        curi_status subStatus = parse_pchar(uri, len, &subOffset, settings, userData, error);
 
         if (subStatus == curi_status_success)
         {
@@ -944,40 +1346,70 @@ static curi_status parse_pchars(const char* uri, size_t len, size_t* offset, con
 }
 
 
-static curi_status parse_segment(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData, int notEmpty)
+static void reset_path_segment_count(curi_path_segments* segments)
+{
+    // Called at the start of each path production, before their segments are parsed
+    if (segments)
+        segments->count = 0;
+}
+
+static curi_status end_segment(const char* uri, size_t segmentOffset, size_t segmentEndOffset, const curi_settings* settings, void* userData, curi_path_segments* segments, size_t segmentIndex)
+{
+    // Recording the span of the parsed segment before calling back with it
+    if (segments)
+    {
+        // Without an array, its capacity is ignored
+        if (segments->spans && segmentIndex < segments->capacity)
+        {
+            segments->spans[segmentIndex].offset = segmentOffset;
+            segments->spans[segmentIndex].len = segmentEndOffset - segmentOffset;
+        }
+        segments->count = segmentIndex + 1;
+    }
+
+    if (settings->path_normalization == 0)
+        return handle_path_segment(uri + segmentOffset, segmentEndOffset - segmentOffset, settings, userData);
+
+    return curi_status_success;
+}
+
+static curi_status parse_segment(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData, curi_error* error, curi_path_segments* segments, int notEmpty, size_t segmentIndex)
 {
     // segment = pchars
     // segment-not-empty = pchar pchars
     const size_t initialOffset = *offset;
     curi_status status = curi_status_success;
 
+    if (is_over_limit(segmentIndex + 1, LIMIT(settings, max_path_segments)))
+        status = curi_status_limit_exceeded;
+
     if (notEmpty && status == curi_status_success)
-        status = parse_pchar(uri, len, offset, settings, userData);
+        status = parse_pchar(uri, len, offset, settings, userData, error);
 
     if (status == curi_status_success)
-        status = parse_pchars(uri, len, offset, settings, userData);
+        status = parse_pchars(uri, len, offset, settings, userData, error);
 
     if (status == curi_status_success)
-        status = handle_path_segment(uri + initialOffset, *offset - initialOffset, settings, userData);
+        status = end_segment(uri, initialOffset, *offset, settings, userData, segments, segmentIndex);
 
     return status;
 }
 
-static curi_status parse_segments(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData)
+static curi_status parse_segments(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData, curi_error* error, curi_path_segments* segments, size_t segmentCount)
 {
     // segments  = *( "/" segment )
     curi_status status = curi_status_success;
 
-    for ( ; ; )
+    while (status == curi_status_success)
     {
         size_t initialOffset = *offset;
         curi_status tryStatus = curi_status_success;
 
         if (tryStatus == curi_status_success)
-            tryStatus = parse_char('/', uri, len, offset, settings, userData);
+            tryStatus = parse_char('/', uri, len, offset, settings, userData, error);
 
         if (tryStatus == curi_status_success)
-            tryStatus = parse_segment(uri, len, offset, settings, userData, 0);
+            tryStatus = parse_segment(uri, len, offset, settings, userData, error, segments, 0, segmentCount++);
 
         if (tryStatus == curi_status_error)
         {
@@ -991,12 +1423,15 @@ static curi_status parse_segments(const char* uri, size_t len, size_t* offset, c
     return status;
 }
 
-static curi_status parse_path_absolute_or_empty(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData)
+static curi_status parse_path_absolute_or_empty(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData, curi_error* error, curi_path_segments* segments)
 {
     // path-absolute-or-empty  = segments
     const size_t initialOffset = *offset;
+    curi_status status;
 
-    curi_status status = parse_segments(uri, len, offset, settings, userData);
+    reset_path_segment_count(segments);
+
+    status = parse_segments(uri, len, offset, settings, userData, error, segments, 0);
 
     if (status == curi_status_success)
         status = handle_path(uri + initialOffset, *offset - initialOffset, settings, userData);
@@ -1004,14 +1439,16 @@ static curi_status parse_path_absolute_or_empty(const char* uri, size_t len, siz
     return status;
 }
 
-static curi_status parse_path_absolute(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData)
+static curi_status parse_path_absolute(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData, curi_error* error, curi_path_segments* segments)
 {
     // path-absolute = "/" [ segment-not-empty segments ]
     const size_t initialOffset = *offset;
     curi_status status = curi_status_success;
 
+    reset_path_segment_count(segments);
+
     if (status == curi_status_success)
-        status = parse_char('/', uri, len, offset, settings, userData);
+        status = parse_char('/', uri, len, offset, settings, userData, error);
 
     if (status == curi_status_success)
     {
@@ -1019,10 +1456,10 @@ static curi_status parse_path_absolute(const char* uri, size_t len, size_t* offs
         curi_status tryStatus = curi_status_success;
 
         if (tryStatus == curi_status_success)
-            tryStatus = parse_segment(uri, len, offset, settings, userData, 1);
+            tryStatus = parse_segment(uri, len, offset, settings, userData, error, segments, 1, 0);
 
         if (tryStatus == curi_status_success)
-            tryStatus = parse_segments(uri, len, offset, settings, userData);
+            tryStatus = parse_segments(uri, len, offset, settings, userData, error, segments, 1);
 
         if (tryStatus == curi_status_error)
             *offset = initialOffset;
@@ -1036,22 +1473,24 @@ static curi_status parse_path_absolute(const char* uri, size_t len, size_t* offs
     return status;
 }
 
-static curi_status parse_path_relative(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData)
+static curi_status parse_path_relative(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData, curi_error* error, curi_path_segments* segments)
 {
     // path-relative = segment-not-empty segments
     const size_t initialOffset = *offset;
     curi_status status = curi_status_success;
 
+    reset_path_segment_count(segments);
+
     if (status == curi_status_success)
     {
         size_t initialOffset = *offset;
         curi_status tryStatus = curi_status_success;
 
         if (tryStatus == curi_status_success)
-            tryStatus = parse_segment(uri, len, offset, settings, userData, 1);
+            tryStatus = parse_segment(uri, len, offset, settings, userData, error, segments, 1, 0);
 
         if (tryStatus == curi_status_success)
-            tryStatus = parse_segments(uri, len, offset, settings, userData);
+            tryStatus = parse_segments(uri, len, offset, settings, userData, error, segments, 1);
 
         if (tryStatus == curi_status_error)
             *offset = initialOffset;
@@ -1065,13 +1504,59 @@ static curi_status parse_path_relative(const char* uri, size_t len, size_t* offs
     return status;
 }
 
-static curi_status parse_path_empty(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData)
+static curi_status parse_path_noscheme(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData, curi_error* error, curi_path_segments* segments, size_t checkedOffset)
+{
+    // path-noscheme = segment-nz-nc segments
+    // segment-nz-nc = 1*( unreserved / pct-encoded / sub-delims / "@" ), the characters before checkedOffset being already checked
+    // falling back to path-empty when the first segment is empty
+    const size_t initialOffset = *offset;
+    curi_status status = curi_status_success;
+
+    reset_path_segment_count(segments);
+
+    if (is_over_limit(1, LIMIT(settings, max_path_segments)))
+        return curi_status_limit_exceeded;
+
+    *offset = checkedOffset;
+    while (peek_char(uri, len, *offset) != ':')
+    {
+        const size_t charOffset = *offset;
+        if (parse_pchar(uri, len, offset, settings, userData, error) != curi_status_success)
+        {
+            *offset = charOffset;
+            break;
+        }
+    }
+
+    if (peek_char(uri, len, *offset) == ':')
+    {
+        // the first segment can't have a colon, it would be a scheme
+        set_error(curi_error_scheme, uri, len, *offset, error);
+        return curi_status_error;
+    }
+
+    if (*offset == initialOffset)
+        return curi_status_success;
+
+    if (status == curi_status_success)
+        status = end_segment(uri, initialOffset, *offset, settings, userData, segments, 0);
+
+    if (status == curi_status_success)
+        status = parse_segments(uri, len, offset, settings, userData, error, segments, 1);
+
+    if (status == curi_status_success)
+        status = handle_path(uri + initialOffset, *offset - initialOffset, settings, userData);
+
+    return status;
+}
+
+static curi_status parse_path_empty(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData, curi_error* error)
 {
     // path-empty = ""
     return curi_status_success;
 }
 
-static curi_status parse_path(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData)
+static curi_status parse_path(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData, curi_error* error, curi_path_segments* segments)
 {
     // path = path-absolute
     //      / path-relative
@@ -1079,18 +1564,61 @@ static curi_status parse_path(const char* uri, size_t len, size_t* offset, const
     curi_status status = curi_status_error;
 
     if (status == curi_status_error)
-        TRY(status,offset,parse_path_absolute(uri, len, offset, settings, userData));
+        TRY(status,offset,parse_path_absolute(uri, len, offset, settings, userData, error, segments));
 
     if (status == curi_status_error)
-        TRY(status,offset,parse_path_relative(uri, len, offset, settings, userData));
+        TRY(status,offset,parse_path_relative(uri, len, offset, settings, userData, error, segments));
 
     if (status == curi_status_error)
-        TRY(status,offset,parse_path_empty(uri, len, offset, settings, userData));
+        TRY(status,offset,parse_path_empty(uri, len, offset, settings, userData, error));
+
+    return status;
+}
+
+#define AUTHORITY_COMPONENTS (curi_component_userinfo | curi_component_host | curi_component_port)
+
+static curi_status check_components(int parsedComponents, const char* followers, const char* uri, size_t len, size_t offset, const curi_settings* settings)
+{
+    // Stopping once all the requested components have been parsed, provided the following character can end them
+    char c;
+
+    if (settings->components == 0 || (settings->components & ~parsedComponents) != 0)
+        return curi_status_success;
+
+    c = peek_char(uri, len, offset);
+    if (followers && c != '\0' && !strchr(followers, c))
+        return curi_status_success;
+
+    return curi_status_partial;
+}
+
+static curi_status parse_authority_path_abempty(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData, curi_error* error, curi_path_segments* segments)
+{
+    // authority-path-abempty = authority path-abempty, following "//"
+    curi_status status = curi_status_success;
+    size_t hostOffset = 0;
+    size_t hostLen = 0;
+    size_t pathOffset = 0;
+
+    if (status == curi_status_success)
+        status = parse_authority(uri, len, offset, settings, userData, error, &hostOffset, &hostLen);
+
+    if (status == curi_status_success)
+        status = check_components(curi_component_scheme | AUTHORITY_COMPONENTS, "/?#", uri, len, *offset, settings);
+
+    if (status == curi_status_success)
+    {
+        pathOffset = *offset;
+        status = parse_path_absolute_or_empty(uri, len, offset, settings, userData, error, segments);
+    }
+
+    if (status == curi_status_success)
+        status = handle_url_rules(uri + hostOffset, hostLen, uri + pathOffset, *offset - pathOffset, settings, userData);
 
     return status;
 }
 
-static curi_status parse_hier_part(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData)
+static curi_status parse_hier_part(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData, curi_error* error, curi_path_segments* segments)
 {
     // hier-part = "//" authority path-absolute-or-empty
     //             / path
@@ -1101,13 +1629,11 @@ static curi_status parse_hier_part(const char* uri, size_t len, size_t* offset,
         size_t initialOffset = *offset;
         curi_status tryStatus = curi_status_success;
         if (tryStatus == curi_status_success)
-            tryStatus = parse_char('/', uri, len, offset, settings, userData);
+            tryStatus = parse_char('/', uri, len, offset, settings, userData, error);
         if (tryStatus == curi_status_success)
-            tryStatus = parse_char('/', uri, len, offset, settings, userData);
+            tryStatus = parse_char('/', uri, len, offset, settings, userData, error);
         if (tryStatus == curi_status_success)
-            tryStatus = parse_authority(uri, len, offset, settings, userData);
-        if (tryStatus == curi_status_success)
-            tryStatus = parse_path_absolute_or_empty(uri, len, offset, settings, userData);
+            tryStatus = parse_authority_path_abempty(uri, len, offset, settings, userData, error, segments);
         if (tryStatus == curi_status_error)
             *offset = initialOffset;
         else
@@ -1115,7 +1641,12 @@ static curi_status parse_hier_part(const char* uri, size_t len, size_t* offset,
     }
 
     if (status == curi_status_error)
-        TRY(status,offset,parse_path(uri, len, offset, settings, userData));
+    {
+        const size_t pathOffset = *offset;
+        TRY(status,offset,parse_path(uri, len, offset, settings, userData, error, segments));
+        if (status == curi_status_success)
+            status = handle_url_rules(uri, 0, uri + pathOffset, *offset - pathOffset, settings, userData);
+    }
 
     return status;
 }
@@ -1125,7 +1656,7 @@ static curi_status parse_hier_part(const char* uri, size_t len, size_t* offset,
     case '/': \
     case '?'
 
-static curi_status parse_query_fragment_char(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData)
+static curi_status parse_query_fragment_char(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData, curi_error* error)
 {
     // query_fragment_char = pchar / "/" / "?"
 
@@ -1135,7 +1666,7 @@ static curi_status parse_query_fragment_char(const char* uri, size_t len, size_t
             return curi_status_success;
             break;
         case '%':
-            return parse_h8(uri, len, offset, settings, userData);
+            return parse_h8(uri, len, offset, settings, userData, error);
             break;
         default:
             return curi_status_error;
@@ -1143,109 +1674,163 @@ static curi_status parse_query_fragment_char(const char* uri, size_t len, size_t
     }
 }
 
-static curi_status parse_query_item(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData)
+// Classes of the characters found in query items, compiled from the settings separators
+#define QUERY_ITEM_CLASS_KEY_CHAR 0x01
+#define QUERY_ITEM_CLASS_VALUE_CHAR 0x02
+#define QUERY_ITEM_CLASS_PERCENT 0x04
+#define QUERY_ITEM_CLASS_ITEM_SEPARATOR 0x08
+#define QUERY_ITEM_CLASS_KEY_SEPARATOR 0x10
+
+static void add_query_item_separators(unsigned char* itemClasses, char separator, const char* separators, unsigned char separatorClass, unsigned char excludedClasses)
 {
-    // query_item = query_item_key [query_item_key_separator query_item_value]
-    // query_item_key = *query_fragment_char (but no query_item_separator or query_item_key_separator)
-    // query_item_separator = settings->query_item_separator (default is "&")
-    // query_item_key_separator = settings->query_item_key_separator (default is "=")
-    // query_item_value = *query_fragment_char (but no query_item_separator)
+    if (separators)
+    {
+        for ( ; *separators != '\0' ; ++separators)
+            itemClasses[(unsigned char)*separators] = (itemClasses[(unsigned char)*separators] & ~excludedClasses) | separatorClass;
+    }
+    else if (separator != '\0')
+    {
+        itemClasses[(unsigned char)separator] = (itemClasses[(unsigned char)separator] & ~excludedClasses) | separatorClass;
+    }
+}
 
-    const size_t keyStartOffset = *offset;
-    size_t keyEndOffset;
+static void compile_query_item_classes(unsigned char* itemClasses, const curi_settings* settings)
+{
+    size_t i;
 
-    curi_status status = curi_status_success;
-    while (status == curi_status_success)
+    for (i = 0 ; i < 256 ; ++i)
+        itemClasses[i] = (char_classes[i] & CHAR_CLASS_QUERY_FRAGMENT_CHAR_NO_PCT) ? (QUERY_ITEM_CLASS_KEY_CHAR | QUERY_ITEM_CLASS_VALUE_CHAR) : 0;
+    itemClasses['%'] = QUERY_ITEM_CLASS_PERCENT;
+
+    // Key separators are forbidden in keys, item separators are forbidden everywhere and take precedence.
+    add_query_item_separators(itemClasses, settings->query_item_key_separator, settings->query_item_key_separators,
+        QUERY_ITEM_CLASS_KEY_SEPARATOR, QUERY_ITEM_CLASS_KEY_CHAR | QUERY_ITEM_CLASS_PERCENT);
+    add_query_item_separators(itemClasses, settings->query_item_separator, settings->query_item_separators,
+        QUERY_ITEM_CLASS_ITEM_SEPARATOR, QUERY_ITEM_CLASS_KEY_CHAR | QUERY_ITEM_CLASS_VALUE_CHAR | QUERY_ITEM_CLASS_PERCENT | QUERY_ITEM_CLASS_KEY_SEPARATOR);
+}
+
+#define K (QUERY_ITEM_CLASS_KEY_CHAR | QUERY_ITEM_CLASS_VALUE_CHAR)
+#define V QUERY_ITEM_CLASS_VALUE_CHAR
+#define X QUERY_ITEM_CLASS_PERCENT
+#define I QUERY_ITEM_CLASS_ITEM_SEPARATOR
+#define E QUERY_ITEM_CLASS_KEY_SEPARATOR
+
+// Classes compiled from the default separators, '&' and '='
+static const unsigned char default_query_item_classes[256] =
+{
+    0, 0, 0, 0, 0, 0, 0, 0, // 0x00-0x07
+    0, 0, 0, 0, 0, 0, 0, 0, // 0x08-0x0F
+    0, 0, 0, 0, 0, 0, 0, 0, // 0x10-0x17
+    0, 0, 0, 0, 0, 0, 0, 0, // 0x18-0x1F
+    0, K, 0, 0, K, X, I, K, // 0x20-0x27
+    K, K, K, K, K, K, K, K, // 0x28-0x2F
+    K, K, K, K, K, K, K, K, // 0x30-0x37
+    K, K, K, K, 0, E|V, 0, K, // 0x38-0x3F
+    K, K, K, K, K, K, K, K, // 0x40-0x47
+    K, K, K, K, K, K, K, K, // 0x48-0x4F
+    K, K, K, K, K, K, K, K, // 0x50-0x57
+    K, K, K, 0, 0, 0, 0, K, // 0x58-0x5F
+    0, K, K, K, K, K, K, K, // 0x60-0x67
+    K, K, K, K, K, K, K, K, // 0x68-0x6F
+    K, K, K, K, K, K, K, K, // 0x70-0x77
+    K, K, K, 0, 0, 0, K, 0, // 0x78-0x7F
+    // 0x80-0xFF are all zero
+};
+
+#undef K
+#undef V
+#undef X
+#undef I
+#undef E
+
+void curi_compile_query_grammar(curi_query_grammar* grammar, const curi_settings* settings)
+{
+    compile_query_item_classes(grammar->classes, settings);
+}
+
+static const unsigned char* query_item_classes(const curi_settings* settings, unsigned char* compiledClasses)
+{
+    if (settings->query_grammar)
+        return settings->query_grammar->classes;
+
+    if (settings->query_item_separator == '&' && settings->query_item_key_separator == '=' && !settings->query_item_separators && !settings->query_item_key_separators)
+        return default_query_item_classes;
+
+    // Custom separators without a compiled grammar
+    compile_query_item_classes(compiledClasses, settings);
+    return compiledClasses;
+}
+
+static curi_status parse_query_item_chars(const char* uri, size_t len, size_t* offset, const unsigned char* itemClasses, unsigned char charClass, size_t maxLength, const curi_settings* settings, void* userData, curi_error* error)
+{
+    // query_item_chars = *( char of class charClass / "%" h8 )
+    const size_t startOffset = *offset;
+
+    for ( ; ; )
     {
         size_t previousOffset = *offset;
+        unsigned char itemClass = itemClasses[(unsigned char)*read_char(uri, len, offset)];
 
-        char c = *read_char(uri, len, offset);
-        if (c == settings->query_item_separator)
-            status = curi_status_error;
-        else if (c == settings->query_item_key_separator)
-            status = curi_status_error;
-        else
+        if (!(itemClass & charClass) && (!(itemClass & QUERY_ITEM_CLASS_PERCENT) || parse_h8(uri, len, offset, settings, userData, error) != curi_status_success))
         {
-            switch (c)
-            {
-                CASE_QUERY_FRAGMENT_CHAR_NO_PCT:
-                    status = curi_status_success;
-                    break;
-                case '%':
-                    status = parse_h8(uri, len, offset, settings, userData);
-                    break;
-                default:
-                    status = curi_status_error;
-                    break;
-            }
+            *offset = previousOffset;
+            return curi_status_success;
         }
 
-        if (status != curi_status_success)
-            *offset = previousOffset;
-    };
+        // Stopping as soon as the limit is crossed, without scanning the rest of the item
+        if (is_over_limit(*offset - startOffset, maxLength))
+            return curi_status_limit_exceeded;
+    }
+}
 
-    keyEndOffset = *offset;
+static curi_status parse_query_item(const char* uri, size_t len, size_t* offset, const unsigned char* itemClasses, const curi_settings* settings, void* userData, curi_error* error)
+{
+    // query_item = query_item_key [query_item_key_separator query_item_value]
+    // query_item_key = *query_fragment_char (but no query_item_separator or query_item_key_separator)
+    // query_item_separator = settings->query_item_separator or one of settings->query_item_separators (default is "&")
+    // query_item_key_separator = settings->query_item_key_separator or one of settings->query_item_key_separators (default is "=")
+    // query_item_value = *query_fragment_char (but no query_item_separator)
 
-    status = parse_char(settings->query_item_key_separator, uri, len, offset, settings, userData);
+    const size_t keyStartOffset = *offset;
+    size_t keyEndOffset;
 
-    if (status == curi_status_success)
+    if (parse_query_item_chars(uri, len, offset, itemClasses, QUERY_ITEM_CLASS_KEY_CHAR, LIMIT(settings, max_query_item_key_length), settings, userData, error) != curi_status_success)
+        return curi_status_limit_exceeded;
+
+    keyEndOffset = *offset;
+
+    if (itemClasses[(unsigned char)*read_char(uri, len, offset)] & QUERY_ITEM_CLASS_KEY_SEPARATOR)
     {
         // There is a value
         const size_t valueStartOffset = *offset;
 
-        while (status == curi_status_success)
-        {
-            size_t previousOffset = *offset;
-
-            char c = *read_char(uri, len, offset);
-            if (c == settings->query_item_separator)
-                status = curi_status_error;
-            else
-            {
-                switch (c)
-                {
-                    CASE_QUERY_FRAGMENT_CHAR_NO_PCT:
-                        status = curi_status_success;
-                        break;
-                    case '%':
-                        status = parse_h8(uri, len, offset, settings, userData);
-                        break;
-                    default:
-                        status = curi_status_error;
-                        break;
-                }
-            }
-
-            if (status != curi_status_success)
-                *offset = previousOffset;
-        }
+        if (parse_query_item_chars(uri, len, offset, itemClasses, QUERY_ITEM_CLASS_VALUE_CHAR, LIMIT(settings, max_query_item_value_length), settings, userData, error) != curi_status_success)
+            return curi_status_limit_exceeded;
 
-        status = handle_query_item(uri + keyStartOffset, keyEndOffset - keyStartOffset, uri + valueStartOffset, *offset - valueStartOffset, settings, userData);
+        return handle_query_item(uri + keyStartOffset, keyEndOffset - keyStartOffset, uri + valueStartOffset, *offset - valueStartOffset, settings, userData);
     }
     else
     {
         *offset = keyEndOffset;
         // There is no value
-        status = handle_query_item(uri + keyStartOffset, keyEndOffset - keyStartOffset, 0, 0, settings, userData);
+        return handle_query_item(uri + keyStartOffset, keyEndOffset - keyStartOffset, 0, 0, settings, userData);
     }
-
-    return status;
 }
 
-static curi_status parse_query(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData, int parseSeparator)
+static curi_status parse_query(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData, curi_error* error, int parseSeparator)
 {
     // If not interested in individual items,
     //      query = "?" *query_fragment_char
     // if interested,
     //      query = "?" query_item *(query_item_separator query_item)
-    //      query_item_separator = settings->query_item_separator (default is "&")
+    //      query_item_separator = settings->query_item_separator or one of settings->query_item_separators (default is "&")
 
     curi_status status = curi_status_success;
 
     size_t queryStartOffset;
 
     if (parseSeparator && status == curi_status_success)
-        status = parse_char('?', uri, len, offset, settings, userData);
+        status = parse_char('?', uri, len, offset, settings, userData, error);
 
     queryStartOffset = *offset;
 
@@ -1257,7 +1842,7 @@ static curi_status parse_query(const char* uri, size_t len, size_t* offset, cons
             {
                 size_t previousOffset = *offset;
 
-                status = parse_query_fragment_char(uri, len, offset, settings, userData);
+                status = parse_query_fragment_char(uri, len, offset, settings, userData, error);
 
                 if (status != curi_status_success)
                     *offset = previousOffset;
@@ -1267,24 +1852,28 @@ static curi_status parse_query(const char* uri, size_t len, size_t* offset, cons
         }
         else
         {
-            status = parse_query_item(uri, len, offset, settings, userData);
-
-            if (status == curi_status_success)
-            {
-                curi_status tryStatus = curi_status_success;
-                while (tryStatus == curi_status_success)
-                {
-                    size_t previousOffset = *offset;
+            const size_t maxItems = LIMIT(settings, max_query_items);
+            size_t itemCount = 1;
+            unsigned char compiledClasses[256];
+            const unsigned char* itemClasses = query_item_classes(settings, compiledClasses);
 
-                    tryStatus = parse_char(settings->query_item_separator, uri, len, offset, settings, userData);
+            status = parse_query_item(uri, len, offset, itemClasses, settings, userData, error);
 
-                    if (tryStatus == curi_status_success)
-                        tryStatus = parse_query_item(uri, len, offset, settings, userData);
+            while (status == curi_status_success)
+            {
+                size_t previousOffset = *offset;
 
-                    if (tryStatus == curi_status_error)
-                        *offset = previousOffset;
+                if (itemClasses[(unsigned char)*read_char(uri, len, offset)] & QUERY_ITEM_CLASS_ITEM_SEPARATOR)
+                {
+                    if (is_over_limit(++itemCount, maxItems))
+                        status = curi_status_limit_exceeded;
                     else
-                        status = tryStatus;
+                        status = parse_query_item(uri, len, offset, itemClasses, settings, userData, error);
+                }
+                else
+                {
+                    *offset = previousOffset;
+                    break;
                 }
             }
         }
@@ -1296,14 +1885,14 @@ static curi_status parse_query(const char* uri, size_t len, size_t* offset, cons
     return status;
 }
 
-static curi_status parse_fragment(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData)
+static curi_status parse_fragment(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData, curi_error* error)
 {
     // fragment = "#" *query_fragment_char
     curi_status status = curi_status_success;
     size_t fragmentStartOffset;
 
     if (status == curi_status_success)
-        status = parse_char('#', uri, len, offset, settings, userData);
+        status = parse_char('#', uri, len, offset, settings, userData, error);
 
     fragmentStartOffset = *offset;
 
@@ -1313,7 +1902,7 @@ static curi_status parse_fragment(const char* uri, size_t len, size_t* offset, c
         {
             size_t previousOffset = *offset;
 
-            status = parse_query_fragment_char(uri, len, offset, settings, userData);
+            status = parse_query_fragment_char(uri, len, offset, settings, userData, error);
 
             if (status != curi_status_success)
                 *offset = previousOffset;
@@ -1327,199 +1916,3927 @@ static curi_status parse_fragment(const char* uri, size_t len, size_t* offset, c
     return status;
 }
 
-static curi_status parse_full_uri(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData)
+static curi_status parse_query_and_fragment(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData, curi_error* error)
 {
-    // URI = scheme ":" hier-part [ query ] [ fragment ]
+    // query-and-fragment = [ "?" query ] [ "#" fragment ], following the path
     curi_status status = curi_status_success;
 
     if (status == curi_status_success)
-        status = parse_scheme(uri, len, offset, settings, userData);
+        status = check_components(curi_component_scheme | AUTHORITY_COMPONENTS | curi_component_path, "?#", uri, len, *offset, settings);
 
     if (status == curi_status_success)
-        status = parse_char(':', uri, len, offset, settings, userData);
+        TRY(status, offset, parse_query(uri, len, offset, settings, userData, error, 1));
 
     if (status == curi_status_success)
-        status = parse_hier_part(uri, len, offset, settings, userData);
+        status = check_components(curi_component_scheme | AUTHORITY_COMPONENTS | curi_component_path | curi_component_query, "#", uri, len, *offset, settings);
 
     if (status == curi_status_success)
-        TRY(status, offset, parse_query(uri, len, offset, settings, userData, 1));
-
-    if (status == curi_status_success)
-        TRY(status, offset, parse_fragment(uri, len, offset, settings, userData));
+        TRY(status, offset, parse_fragment(uri, len, offset, settings, userData, error));
 
     return status;
 }
 
-curi_status curi_parse_full_uri(const char* uri, size_t len, const curi_settings* settings /*= 0*/, void* userData /*= 0*/)
+static curi_status parse_hier_part_query_fragment(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData, curi_error* error, curi_path_segments* segments)
 {
-    size_t offset = 0;
-    curi_status status;
+    // hier-part-query-fragment = hier-part [ "?" query ] [ "#" fragment ]
+    // also matching relative-part [ "?" query ] [ "#" fragment ] once path-noscheme is checked
+    curi_status status = curi_status_success;
 
-    if (settings)
-    {
-        // parsing with the given settings
-        status = parse_full_uri(uri, len, &offset, settings, userData);
-    }
-    else
+    if (status == curi_status_success)
     {
-        curi_settings defaultSettings;
-        curi_default_settings(&defaultSettings);
-        // parsing with default settings
-        status = parse_full_uri(uri, len, &offset, &defaultSettings, userData);
+        // without a following "//", the URI has no authority
+        int parsedComponents = curi_component_scheme;
+        if (peek_char(uri, len, *offset) != '/' || peek_char(uri, len, *offset + 1) != '/')
+            parsedComponents |= AUTHORITY_COMPONENTS;
+        status = check_components(parsedComponents, 0, uri, len, *offset, settings);
     }
 
-    if (status == curi_status_success && *read_char(uri,len,&offset) != '\0')
-        // the URI weren't fully consumed
-        // TODO: set an error string somewhere
-        status = curi_status_error;
+    if (status == curi_status_success)
+        status = parse_hier_part(uri, len, offset, settings, userData, error, segments);
+
+    if (status == curi_status_success)
+        status = parse_query_and_fragment(uri, len, offset, settings, userData, error);
 
     return status;
 }
 
-curi_status curi_parse_full_uri_nt(const char* uri, const curi_settings* settings /*= 0*/, void* userData /*= 0*/)
+static const char* const known_schemes[] = {"http", "https", "ws", "wss"};
+static const unsigned int known_scheme_default_ports[] = {80, 443, 80, 443};
+
+static int match_prefix(const char* str, size_t len, size_t offset, const char* prefix)
 {
-    return curi_parse_full_uri(uri, SIZE_MAX, settings, userData);
+    // Comparing one character at a time, never reading past a mismatch, and thus past a NULL-character
+    for ( ; *prefix != '\0' ; ++prefix, ++offset)
+        if (peek_char(str, len, offset) != *prefix)
+            return 0;
+    return 1;
 }
 
-curi_status curi_parse_path(const char* path, size_t len, const curi_settings* settings /*= 0*/, void* userData /*= 0*/)
+static curi_scheme_id match_known_scheme(const char* uri, size_t len, size_t offset, size_t* schemeLen)
 {
-    size_t offset = 0;
-    curi_status status;
+    // Lowercase well-known schemes followed by "://"
+    const char c = peek_char(uri, len, offset);
+    size_t i;
 
-    if (settings)
-    {
-        // parsing with the given settings
-        status = parse_path(path, len, &offset, settings, userData);
-    }
-    else
+    for (i = 0 ; i < sizeof(known_schemes) / sizeof(known_schemes[0]) ; ++i)
     {
-        curi_settings defaultSettings;
-        curi_default_settings(&defaultSettings);
-        // parsing with default settings
-        status = parse_path(path, len, &offset, &defaultSettings, userData);
+        if (known_schemes[i][0] == c && match_prefix(uri, len, offset, known_schemes[i]))
+        {
+            *schemeLen = strlen(known_schemes[i]);
+            if (match_prefix(uri, len, offset + *schemeLen, "://"))
+                return (curi_scheme_id)(curi_scheme_http + i);
+        }
     }
 
-    if (status == curi_status_success && *read_char(path, len, &offset) != '\0')
-        // the imput weren't fully consumed
-        // TODO: set an error string somewhere
+    return curi_scheme_unknown;
+}
+
+curi_scheme_id curi_scheme_lookup(const char* scheme, size_t schemeLen)
+{
+    size_t i;
+
+    for (i = 0 ; i < sizeof(known_schemes) / sizeof(known_schemes[0]) ; ++i)
+        if (equals_ignore_case(scheme, schemeLen, known_schemes[i]))
+            return (curi_scheme_id)(curi_scheme_http + i);
+
+    return curi_scheme_unknown;
+}
+
+unsigned int curi_scheme_default_port(curi_scheme_id schemeId)
+{
+    // Values outside the enumeration, from casts or newer headers, have no default port
+    if (schemeId < curi_scheme_http || schemeId > curi_scheme_wss)
+        return 0;
+
+    return known_scheme_default_ports[schemeId - curi_scheme_http];
+}
+
+static curi_status parse_after_scheme(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData, curi_error* error, curi_path_segments* segments, size_t schemeStartOffset)
+{
+    // hier-part [ "?" query ] [ "#" fragment ], following the scheme and its ":"
+    curi_status status = curi_status_success;
+
+    if (status == curi_status_success && settings->scheme_id_callback)
+        status = handle_scheme_id(curi_scheme_lookup(uri + schemeStartOffset, *offset - schemeStartOffset - 1), settings, userData);
+
+    if (status == curi_status_success)
+        status = parse_hier_part_query_fragment(uri, len, offset, settings, userData, error, segments);
+
+    return status;
+}
+
+static curi_status parse_full_uri(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData, curi_error* error, curi_path_segments* segments)
+{
+    // URI = scheme ":" hier-part [ query ] [ fragment ]
+    const size_t schemeStartOffset = *offset;
+    size_t schemeLen = 0;
+    const curi_scheme_id schemeId = match_known_scheme(uri, len, *offset, &schemeLen);
+    curi_status status = curi_status_success;
+
+    if (schemeId != curi_scheme_unknown)
+    {
+        // Well-known scheme, an authority is required and the path fallback of hier-part is skipped
+        *offset += schemeLen + 3;
+
+        if (status == curi_status_success)
+            status = handle_scheme(uri + schemeStartOffset, schemeLen, settings, userData);
+
+        if (status == curi_status_success)
+            status = handle_scheme_id(schemeId, settings, userData);
+
+        if (status == curi_status_success)
+            status = check_components(curi_component_scheme, 0, uri, len, *offset, settings);
+
+        if (status == curi_status_success)
+            status = parse_authority_path_abempty(uri, len, offset, settings, userData, error, segments);
+
+        if (status == curi_status_success)
+            status = parse_query_and_fragment(uri, len, offset, settings, userData, error);
+    }
+    else
+    {
+        if (status == curi_status_success)
+            status = parse_scheme(uri, len, offset, settings, userData, error);
+
+        if (status == curi_status_success)
+            status = parse_char(':', uri, len, offset, settings, userData, error);
+
+        if (status == curi_status_error)
+            set_error(curi_error_scheme, uri, len, *offset - 1, error);
+
+        if (status == curi_status_success)
+            status = parse_after_scheme(uri, len, offset, settings, userData, error, segments, schemeStartOffset);
+    }
+
+    return status;
+}
+
+static curi_status parse_uri_reference(const char* uri, size_t len, size_t* offset, const curi_settings* settings, void* userData, curi_error* error, curi_reference_form* form)
+{
+    // URI-reference = URI / relative-ref
+    // relative-ref  = relative-part [ "?" query ] [ "#" fragment ]
+    // relative-part = "//" authority path-abempty / path-absolute / path-noscheme / path-empty
+    const size_t initialOffset = *offset;
+    size_t i = initialOffset;
+    int schemeChars;
+    curi_status status = curi_status_success;
+    char c = peek_char(uri, len, i);
+
+    // Reading, without calling back, the characters that may start a scheme
+    switch (c)
+    {
+        CASE_ALPHA:
+            schemeChars = 1;
+            break;
+        default:
+            schemeChars = 0;
+    }
+
+    while (schemeChars)
+    {
+        switch (c = peek_char(uri, len, ++i))
+        {
+            CASE_ALPHA:
+            CASE_DIGIT:
+            case '+':
+            case '-':
+            case '.':
+                break;
+            default:
+                schemeChars = 0;
+        }
+    }
+
+    if (c == ':' && i > initialOffset)
+    {
+        // the scheme is known to be valid, the hier-part follows its ":"
+        *form = curi_reference_uri;
+        *offset = i + 1;
+
+        if (status == curi_status_success)
+            status = handle_scheme(uri + initialOffset, i - initialOffset, settings, userData);
+
+        if (status == curi_status_success)
+            status = parse_after_scheme(uri, len, offset, settings, userData, error, 0, initialOffset);
+
+        return status;
+    }
+
+    if (i == initialOffset && (c == '\0' || c == '/' || c == '?' || c == '#'))
+    {
+        // empty first segment, nothing was read
+        if (c != '/')
+            *form = curi_reference_relative_path;
+        else if (peek_char(uri, len, i + 1) == '/')
+            *form = curi_reference_network_path;
+        else
+            *form = curi_reference_absolute_path;
+
+        return parse_hier_part_query_fragment(uri, len, offset, settings, userData, error, 0);
+    }
+
+    // path-noscheme, its first segment being read on from the scheme characters, all of them being pchars
+    *form = curi_reference_relative_path;
+
+    if (status == curi_status_success)
+        status = check_components(curi_component_scheme | AUTHORITY_COMPONENTS, 0, uri, len, *offset, settings);
+
+    if (status == curi_status_success)
+        status = parse_path_noscheme(uri, len, offset, settings, userData, error, 0, i);
+
+    if (status == curi_status_success)
+        status = handle_url_rules(uri, 0, uri + initialOffset, *offset - initialOffset, settings, userData);
+
+    if (status == curi_status_success)
+        status = parse_query_and_fragment(uri, len, offset, settings, userData, error);
+
+    return status;
+}
+
+static curi_status check_length_limit(const char* str, size_t len, const curi_settings* settings)
+{
+    // Looking for the end of the string without reading further than the limit
+    const size_t maxLength = LIMIT(settings, max_length);
+    size_t i;
+
+    if (maxLength == 0 || len <= maxLength)
+        return curi_status_success;
+
+    for (i = 0 ; i <= maxLength ; ++i)
+        if (str[i] == '\0')
+            return curi_status_success;
+
+    return curi_status_limit_exceeded;
+}
+
+curi_status curi_parse_full_uri(const char* uri, size_t len, const curi_settings* settings /*= 0*/, void* userData /*= 0*/)
+{
+    return curi_parse_full_uri_with_error(uri, len, 0, settings, userData);
+}
+
+curi_status curi_parse_full_uri_with_error(const char* uri, size_t len, curi_error* error /*= 0*/, const curi_settings* settings /*= 0*/, void* userData /*= 0*/)
+{
+    return curi_parse_full_uri_with_spans(uri, len, 0, error, settings, userData);
+}
+
+curi_status curi_parse_full_uri_with_spans(const char* uri, size_t len, curi_path_segments* segments /*= 0*/, curi_error* error /*= 0*/, const curi_settings* settings /*= 0*/, void* userData /*= 0*/)
+{
+    size_t offset = 0;
+    curi_status status;
+
+    reset_error(error);
+
+    if (settings)
+    {
+        status = check_length_limit(uri, len, settings);
+        if (status != curi_status_success)
+            return status;
+
+        // parsing with the given settings
+        status = parse_full_uri(uri, len, &offset, settings, userData, error, segments);
+    }
+    else
+    {
+        curi_settings defaultSettings;
+        curi_default_settings(&defaultSettings);
+        // parsing with default settings
+        status = parse_full_uri(uri, len, &offset, &defaultSettings, userData, error, segments);
+    }
+
+    if (status == curi_status_partial && peek_char(uri, len, offset) == '\0')
+        // nothing was left unchecked
+        status = curi_status_success;
+
+    if (status == curi_status_success && *read_char(uri,len,&offset) != '\0')
+    {
+        // the URI weren't fully consumed
+        set_error(curi_error_trailing_characters, uri, len, offset - 1, error);
+        status = curi_status_error;
+    }
+
+    // Errors recorded while trying alternatives don't apply to a successful parsing
+    if (status != curi_status_error)
+        reset_error(error);
+
+    return status;
+}
+
+curi_status curi_parse_full_uri_nt(const char* uri, const curi_settings* settings /*= 0*/, void* userData /*= 0*/)
+{
+    return curi_parse_full_uri(uri, SIZE_MAX, settings, userData);
+}
+
+curi_status curi_parse_uri_reference(const char* uri, size_t len, curi_reference_form* form /*= 0*/, curi_error* error /*= 0*/, const curi_settings* settings /*= 0*/, void* userData /*= 0*/)
+{
+    size_t offset = 0;
+    curi_reference_form parsedForm = curi_reference_relative_path;
+    curi_status status;
+
+    reset_error(error);
+
+    if (settings)
+    {
+        status = check_length_limit(uri, len, settings);
+        if (status != curi_status_success)
+            return status;
+
+        // parsing with the given settings
+        status = parse_uri_reference(uri, len, &offset, settings, userData, error, &parsedForm);
+    }
+    else
+    {
+        curi_settings defaultSettings;
+        curi_default_settings(&defaultSettings);
+        // parsing with default settings
+        status = parse_uri_reference(uri, len, &offset, &defaultSettings, userData, error, &parsedForm);
+    }
+
+    if (status == curi_status_partial && peek_char(uri, len, offset) == '\0')
+        // nothing was left unchecked
+        status = curi_status_success;
+
+    if (status == curi_status_success && *read_char(uri,len,&offset) != '\0')
+    {
+        // the reference weren't fully consumed
+        set_error(curi_error_trailing_characters, uri, len, offset - 1, error);
+        status = curi_status_error;
+    }
+
+    if (form)
+        *form = parsedForm;
+
+    // Errors recorded while trying alternatives don't apply to a successful parsing
+    if (status != curi_status_error)
+        reset_error(error);
+
+    return status;
+}
+
+curi_status curi_parse_uri_reference_nt(const char* uri, curi_reference_form* form /*= 0*/, curi_error* error /*= 0*/, const curi_settings* settings /*= 0*/, void* userData /*= 0*/)
+{
+    return curi_parse_uri_reference(uri, SIZE_MAX, form, error, settings, userData);
+}
+
+curi_status curi_parse_path(const char* path, size_t len, const curi_settings* settings /*= 0*/, void* userData /*= 0*/)
+{
+    return curi_parse_path_with_error(path, len, 0, settings, userData);
+}
+
+curi_status curi_parse_path_with_error(const char* path, size_t len, curi_error* error /*= 0*/, const curi_settings* settings /*= 0*/, void* userData /*= 0*/)
+{
+    return curi_parse_path_with_spans(path, len, 0, error, settings, userData);
+}
+
+curi_status curi_parse_path_with_spans(const char* path, size_t len, curi_path_segments* segments /*= 0*/, curi_error* error /*= 0*/, const curi_settings* settings /*= 0*/, void* userData /*= 0*/)
+{
+    size_t offset = 0;
+    curi_status status;
+
+    reset_error(error);
+
+    if (settings)
+    {
+        status = check_length_limit(path, len, settings);
+        if (status != curi_status_success)
+            return status;
+
+        // parsing with the given settings
+        status = parse_path(path, len, &offset, settings, userData, error, segments);
+    }
+    else
+    {
+        curi_settings defaultSettings;
+        curi_default_settings(&defaultSettings);
+        // parsing with default settings
+        status = parse_path(path, len, &offset, &defaultSettings, userData, error, segments);
+    }
+
+    if (status == curi_status_success && *read_char(path, len, &offset) != '\0')
+    {
+        // the imput weren't fully consumed
+        set_error(curi_error_trailing_characters, path, len, offset - 1, error);
+        status = curi_status_error;
+    }
+
+    // Errors recorded while trying alternatives don't apply to a successful parsing
+    if (status != curi_status_error)
+        reset_error(error);
+
+    return status;
+}
+
+
+curi_status curi_parse_path_nt(const char* path, const curi_settings* settings /*= 0*/, void* userData /*= 0*/)
+{
+    return curi_parse_path(path, SIZE_MAX, settings, userData);
+}
+
+curi_status curi_parse_query(const char* query, size_t len, const curi_settings* settings /*= 0*/, void* userData /*= 0*/)
+{
+    return curi_parse_query_with_error(query, len, 0, settings, userData);
+}
+
+curi_status curi_parse_query_with_error(const char* query, size_t len, curi_error* error /*= 0*/, const curi_settings* settings /*= 0*/, void* userData /*= 0*/)
+{
+    size_t offset = 0;
+    curi_status status;
+
+    reset_error(error);
+
+    if (settings)
+    {
+        status = check_length_limit(query, len, settings);
+        if (status != curi_status_success)
+            return status;
+
+        // parsing with the given settings
+        status = parse_query(query, len, &offset, settings, userData, error, 0);
+    }
+    else
+    {
+        curi_settings defaultSettings;
+        curi_default_settings(&defaultSettings);
+        // parsing with default settings
+        status = parse_query(query, len, &offset, &defaultSettings, userData, error, 0);
+    }
+
+    if (status == curi_status_success && *read_char(query, len, &offset) != '\0')
+    {
+        // the imput weren't fully consumed
+        set_error(curi_error_trailing_characters, query, len, offset - 1, error);
         status = curi_status_error;
+    }
+
+    // Errors recorded while trying alternatives don't apply to a successful parsing
+    if (status != curi_status_error)
+        reset_error(error);
+
+    return status;
+}
+
+curi_status curi_parse_query_nt(const char* query, const curi_settings* settings /*= 0*/, void* userData /*= 0*/)
+{
+    return curi_parse_query(query, SIZE_MAX, settings, userData);
+}
+
+static const char* const method_names[] = {"GET", "HEAD", "POST", "PUT", "DELETE", "CONNECT", "OPTIONS", "TRACE", "PATCH"};
+
+static int is_tchar(char c)
+{
+    // tchar = "!" / "#" / "$" / "%" / "&" / "'" / "*" / "+" / "-" / "." / "^" / "_" / "`" / "|" / "~" / DIGIT / ALPHA
+    switch (c)
+    {
+        CASE_ALPHA:
+        CASE_DIGIT:
+        case '!':
+        case '#':
+        case '$':
+        case '%':
+        case '&':
+        case '\'':
+        case '*':
+        case '+':
+        case '-':
+        case '.':
+        case '^':
+        case '_':
+        case '`':
+        case '|':
+        case '~':
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static curi_status parse_method(const char* line, size_t len, size_t* offset, const curi_settings* settings, curi_error* error, curi_request_line* requestLine)
+{
+    // method = token
+    const size_t methodStartOffset = *offset;
+    size_t i;
+
+    while (is_tchar(peek_char(line, len, *offset)))
+        ++*offset;
+
+    requestLine->methodName = line + methodStartOffset;
+    requestLine->methodNameLen = *offset - methodStartOffset;
+    requestLine->method = curi_method_unknown;
+
+    if (requestLine->methodNameLen == 0 || peek_char(line, len, *offset) != ' ')
+    {
+        set_error(curi_error_method, line, len, *offset, error);
+        return curi_status_error;
+    }
+
+    for (i = 0 ; i < sizeof(method_names) / sizeof(method_names[0]) ; ++i)
+    {
+        if (strlen(method_names[i]) == requestLine->methodNameLen && memcmp(method_names[i], requestLine->methodName, requestLine->methodNameLen) == 0)
+        {
+            requestLine->method = (curi_method)(curi_method_get + i);
+            break;
+        }
+    }
+
+    return curi_status_success;
+}
+
+static curi_status parse_target_query(const char* line, size_t len, size_t* offset, const curi_settings* settings, void* userData, curi_error* error)
+{
+    // [ "?" query ], following the path of a request target, ended by a space
+    curi_status status = curi_status_success;
+
+    if (status == curi_status_success)
+        status = check_components(curi_component_scheme | AUTHORITY_COMPONENTS | curi_component_path, "? ", line, len, *offset, settings);
+
+    if (status == curi_status_success)
+        TRY(status, offset, parse_query(line, len, offset, settings, userData, error, 1));
+
+    if (status == curi_status_success)
+        status = check_components(curi_component_scheme | AUTHORITY_COMPONENTS | curi_component_path | curi_component_query, " ", line, len, *offset, settings);
+
+    return status;
+}
+
+static curi_status parse_request_target(const char* line, size_t len, size_t* offset, const curi_settings* settings, void* userData, curi_error* error, curi_request_line* requestLine)
+{
+    // request-target = origin-form / absolute-form / authority-form / asterisk-form
+    const size_t targetStartOffset = *offset;
+    curi_status status = curi_status_success;
+
+    if (requestLine->method == curi_method_connect)
+    {
+        // authority-form = authority
+        size_t hostOffset = 0;
+        size_t hostLen = 0;
+        requestLine->targetForm = curi_request_target_authority;
+        status = parse_authority(line, len, offset, settings, userData, error, &hostOffset, &hostLen);
+        if (status == curi_status_success && hostLen == 0)
+        {
+            // the authority form requires a host, the space ending the authority being expected
+            reset_error(error);
+            set_error(curi_error_authority, line, len, hostOffset, error);
+            status = curi_status_error;
+        }
+    }
+    else if (peek_char(line, len, *offset) == '*' && peek_char(line, len, *offset + 1) == ' ')
+    {
+        // asterisk-form = "*"
+        requestLine->targetForm = curi_request_target_asterisk;
+        ++*offset;
+    }
+    else if (peek_char(line, len, *offset) == '/')
+    {
+        // origin-form = absolute-path [ "?" query ]
+        requestLine->targetForm = curi_request_target_origin;
+        status = check_components(curi_component_scheme | AUTHORITY_COMPONENTS, 0, line, len, *offset, settings);
+        if (status == curi_status_success)
+            status = parse_path_absolute_or_empty(line, len, offset, settings, userData, error, 0);
+        if (status == curi_status_success)
+            status = parse_target_query(line, len, offset, settings, userData, error);
+    }
+    else
+    {
+        // absolute-form = scheme ":" hier-part [ "?" query ]
+        requestLine->targetForm = curi_request_target_absolute;
+        status = parse_scheme(line, len, offset, settings, userData, error);
+        if (status == curi_status_success)
+            status = parse_char(':', line, len, offset, settings, userData, error);
+        if (status == curi_status_error)
+            set_error(curi_error_scheme, line, len, *offset - 1, error);
+        if (status == curi_status_success)
+            status = parse_hier_part(line, len, offset, settings, userData, error, 0);
+        if (status == curi_status_success)
+            status = parse_target_query(line, len, offset, settings, userData, error);
+    }
+
+    requestLine->target = line + targetStartOffset;
+    requestLine->targetLen = *offset - targetStartOffset;
+
+    return status;
+}
+
+static curi_status parse_http_version(const char* line, size_t len, size_t* offset, const curi_settings* settings, curi_error* error, curi_request_line* requestLine)
+{
+    // HTTP-version = "HTTP/" DIGIT "." DIGIT
+    const char* prefix = "HTTP/";
+    const size_t versionStartOffset = *offset;
+    char major;
+    char minor;
+
+    while (*prefix != '\0' && peek_char(line, len, *offset) == *prefix)
+    {
+        ++prefix;
+        ++*offset;
+    }
+
+    if (*prefix != '\0')
+        major = '\0';
+    else
+        major = *read_char(line, len, offset);
+
+    if (major < '0' || major > '9' || *read_char(line, len, offset) != '.')
+        minor = '\0';
+    else
+        minor = *read_char(line, len, offset);
+
+    if (minor < '0' || minor > '9')
+    {
+        set_error(curi_error_http_version, line, len, versionStartOffset, error);
+        return curi_status_error;
+    }
+
+    requestLine->versionMajor = (unsigned int)(major - '0');
+    requestLine->versionMinor = (unsigned int)(minor - '0');
+
+    return curi_status_success;
+}
+
+static curi_status parse_request_line(const char* line, size_t len, size_t* offset, const curi_settings* settings, void* userData, curi_error* error, curi_request_line* requestLine)
+{
+    // request-line = method SP request-target SP HTTP-version [ CRLF ]
+    curi_status status = curi_status_success;
+
+    if (status == curi_status_success)
+        status = parse_method(line, len, offset, settings, error, requestLine);
+
+    if (status == curi_status_success)
+    {
+        ++*offset;
+        status = parse_request_target(line, len, offset, settings, userData, error, requestLine);
+    }
+
+    if (status == curi_status_success && *read_char(line, len, offset) != ' ')
+    {
+        // the request target weren't fully consumed
+        set_error(curi_error_trailing_characters, line, len, *offset - 1, error);
+        status = curi_status_error;
+    }
+
+    if (status == curi_status_success)
+        status = parse_http_version(line, len, offset, settings, error, requestLine);
+
+    if (status == curi_status_success && peek_char(line, len, *offset) == '\r' && peek_char(line, len, *offset + 1) == '\n')
+        *offset += 2;
+
+    return status;
+}
+
+curi_status curi_parse_request_line(const char* line, size_t len, curi_request_line* requestLine /*= 0*/, curi_error* error /*= 0*/, const curi_settings* settings /*= 0*/, void* userData /*= 0*/)
+{
+    size_t offset = 0;
+    curi_request_line parsedRequestLine;
+    curi_status status;
+
+    memset(&parsedRequestLine, 0, sizeof(curi_request_line));
+
+    reset_error(error);
+
+    if (settings)
+    {
+        status = check_length_limit(line, len, settings);
+        if (status != curi_status_success)
+            return status;
+
+        // parsing with the given settings
+        status = parse_request_line(line, len, &offset, settings, userData, error, &parsedRequestLine);
+    }
+    else
+    {
+        curi_settings defaultSettings;
+        curi_default_settings(&defaultSettings);
+        // parsing with default settings
+        status = parse_request_line(line, len, &offset, &defaultSettings, userData, error, &parsedRequestLine);
+    }
+
+    if (status == curi_status_success && *read_char(line, len, &offset) != '\0')
+    {
+        // the line weren't fully consumed
+        set_error(curi_error_trailing_characters, line, len, offset - 1, error);
+        status = curi_status_error;
+    }
+
+    if (requestLine)
+        *requestLine = parsedRequestLine;
+
+    // Errors recorded while trying alternatives don't apply to a successful parsing
+    if (status != curi_status_error)
+        reset_error(error);
+
+    return status;
+}
+
+curi_status curi_parse_request_line_nt(const char* line, curi_request_line* requestLine /*= 0*/, curi_error* error /*= 0*/, const curi_settings* settings /*= 0*/, void* userData /*= 0*/)
+{
+    return curi_parse_request_line(line, SIZE_MAX, requestLine, error, settings, userData);
+}
+
+// Values of the base64 characters, indexed by byte value
+#define BASE64_INVALID 0x80
+#define BASE64_PADDING 0x40
+
+#define X BASE64_INVALID
+#define P BASE64_PADDING
+
+static const unsigned char base64_values[256] =
+{
+    X, X, X, X, X, X, X, X, // 0x00-0x07
+    X, X, X, X, X, X, X, X, // 0x08-0x0F
+    X, X, X, X, X, X, X, X, // 0x10-0x17
+    X, X, X, X, X, X, X, X, // 0x18-0x1F
+    X, X, X, X, X, X, X, X, // 0x20-0x27
+    X, X, X, 62, X, X, X, 63, // 0x28-0x2F
+    52, 53, 54, 55, 56, 57, 58, 59, // 0x30-0x37
+    60, 61, X, X, X, P, X, X, // 0x38-0x3F
+    X, 0, 1, 2, 3, 4, 5, 6, // 0x40-0x47
+    7, 8, 9, 10, 11, 12, 13, 14, // 0x48-0x4F
+    15, 16, 17, 18, 19, 20, 21, 22, // 0x50-0x57
+    23, 24, 25, X, X, X, X, X, // 0x58-0x5F
+    X, 26, 27, 28, 29, 30, 31, 32, // 0x60-0x67
+    33, 34, 35, 36, 37, 38, 39, 40, // 0x68-0x6F
+    41, 42, 43, 44, 45, 46, 47, 48, // 0x70-0x77
+    49, 50, 51, X, X, X, X, X, // 0x78-0x7F
+    X, X, X, X, X, X, X, X, // 0x80-0x87
+    X, X, X, X, X, X, X, X, // 0x88-0x8F
+    X, X, X, X, X, X, X, X, // 0x90-0x97
+    X, X, X, X, X, X, X, X, // 0x98-0x9F
+    X, X, X, X, X, X, X, X, // 0xA0-0xA7
+    X, X, X, X, X, X, X, X, // 0xA8-0xAF
+    X, X, X, X, X, X, X, X, // 0xB0-0xB7
+    X, X, X, X, X, X, X, X, // 0xB8-0xBF
+    X, X, X, X, X, X, X, X, // 0xC0-0xC7
+    X, X, X, X, X, X, X, X, // 0xC8-0xCF
+    X, X, X, X, X, X, X, X, // 0xD0-0xD7
+    X, X, X, X, X, X, X, X, // 0xD8-0xDF
+    X, X, X, X, X, X, X, X, // 0xE0-0xE7
+    X, X, X, X, X, X, X, X, // 0xE8-0xEF
+    X, X, X, X, X, X, X, X, // 0xF0-0xF7
+    X, X, X, X, X, X, X, X  // 0xF8-0xFF
+};
+
+#undef X
+#undef P
+
+static size_t skip_tchars(const char* str, size_t len, size_t offset)
+{
+    while (is_tchar(peek_char(str, len, offset)))
+        ++offset;
+    return offset;
+}
+
+curi_status curi_parse_data_uri(const char* uri, size_t len, curi_data_uri* dataUri /*= 0*/, char* output /*= 0*/, size_t outputCapacity /*= 0*/, size_t* outputLen /*= 0*/)
+{
+    // dataurl   = "data:" [ mediatype ] [ ";base64" ] "," data
+    // mediatype = [ type "/" subtype ] *( ";" parameter )
+    // parameter = attribute "=" value
+    curi_data_uri parsedDataUri;
+    curi_status status = curi_status_success;
+    size_t offset = 0;
+    size_t parametersOffset;
+    size_t parametersEndOffset;
+
+    memset(&parsedDataUri, 0, sizeof(curi_data_uri));
+
+    while (status == curi_status_success && offset < 5)
+    {
+        if (tolower((unsigned char)*read_char(uri, len, &offset)) != "data:"[offset - 1])
+            status = curi_status_error;
+    }
+
+    if (status == curi_status_success && is_tchar(peek_char(uri, len, offset)))
+    {
+        // type "/" subtype
+        parsedDataUri.mediaType = uri + offset;
+        offset = skip_tchars(uri, len, offset);
+        if (*read_char(uri, len, &offset) != '/' || !is_tchar(peek_char(uri, len, offset)))
+            status = curi_status_error;
+        offset = skip_tchars(uri, len, offset);
+        parsedDataUri.mediaTypeLen = (size_t)(uri + offset - parsedDataUri.mediaType);
+    }
+
+    parametersOffset = offset;
+    parametersEndOffset = offset;
+
+    while (status == curi_status_success && peek_char(uri, len, offset) == ';')
+    {
+        const size_t attributeOffset = ++offset;
+        offset = skip_tchars(uri, len, offset);
+
+        if (offset > attributeOffset && peek_char(uri, len, offset) == '=')
+        {
+            // value, a token possibly percent encoded
+            const size_t valueOffset = ++offset;
+            offset = skip_tchars(uri, len, offset);
+            if (offset == valueOffset)
+                status = curi_status_error;
+            parametersEndOffset = offset;
+        }
+        else if (peek_char(uri, len, offset) == ',' && equals_ignore_case(uri + attributeOffset, offset - attributeOffset, "base64"))
+            parsedDataUri.base64 = 1;
+        else
+            status = curi_status_error;
+    }
+
+    if (status == curi_status_success && *read_char(uri, len, &offset) != ',')
+        status = curi_status_error;
+
+    if (status == curi_status_success)
+    {
+        if (parametersEndOffset > parametersOffset)
+        {
+            parsedDataUri.parameters = uri + parametersOffset + 1;
+            parsedDataUri.parametersLen = parametersEndOffset - parametersOffset - 1;
+        }
+
+        parsedDataUri.data = uri + offset;
+        while (offset < len && uri[offset] != '\0')
+            ++offset;
+        parsedDataUri.dataLen = (size_t)(uri + offset - parsedDataUri.data);
+    }
+
+    if (status == curi_status_success && output)
+    {
+        curi_data_decoder decoder;
+        curi_data_decoder_init(&decoder, parsedDataUri.base64);
+        status = curi_data_decoder_decode(&decoder, parsedDataUri.data, parsedDataUri.dataLen, output, outputCapacity, outputLen);
+        if (status == curi_status_success)
+            status = curi_data_decoder_finish(&decoder);
+    }
+
+    if (dataUri)
+        *dataUri = parsedDataUri;
+
+    return status;
+}
+
+void curi_data_decoder_init(curi_data_decoder* decoder, int base64)
+{
+    memset(decoder, 0, sizeof(curi_data_decoder));
+    decoder->base64 = base64;
+}
+
+static curi_status decode_base64(curi_data_decoder* decoder, const char* data, size_t dataLen, char* output, size_t outputCapacity, size_t* outputOffset)
+{
+    size_t i = 0;
+    size_t o = *outputOffset;
+    curi_status status = curi_status_success;
+
+    while (status == curi_status_success && i < dataLen)
+    {
+        if (decoder->bitCount == 0 && !decoder->padding)
+        {
+            // Decoding whole quartets until a padding or an invalid character
+            while (i + 4 <= dataLen && o + 3 <= outputCapacity)
+            {
+                const unsigned char a = base64_values[(unsigned char)data[i]];
+                const unsigned char b = base64_values[(unsigned char)data[i + 1]];
+                const unsigned char c = base64_values[(unsigned char)data[i + 2]];
+                const unsigned char d = base64_values[(unsigned char)data[i + 3]];
+                unsigned long quartet;
+
+                if ((a | b | c | d) & (BASE64_INVALID | BASE64_PADDING))
+                    break;
+
+                quartet = ((unsigned long)a << 18) | ((unsigned long)b << 12) | ((unsigned long)c << 6) | (unsigned long)d;
+                output[o] = (char)((quartet >> 16) & 0xFF);
+                output[o + 1] = (char)((quartet >> 8) & 0xFF);
+                output[o + 2] = (char)(quartet & 0xFF);
+                i += 4;
+                o += 3;
+            }
+
+            if (i == dataLen)
+                break;
+        }
+
+        {
+            // One character at a time, for the quartets split between chunks and the padding
+            const unsigned char value = base64_values[(unsigned char)data[i++]];
+
+            if (value == BASE64_PADDING && (decoder->bitCount == 2 || decoder->bitCount == 4))
+            {
+                decoder->bitCount -= 2;
+                decoder->padding = 1;
+            }
+            else if (value & (BASE64_INVALID | BASE64_PADDING) || decoder->padding)
+                status = curi_status_error;
+            else
+            {
+                decoder->bits = ((decoder->bits << 6) | value) & 0xFFF;
+                decoder->bitCount += 6;
+                if (decoder->bitCount >= 8)
+                {
+                    decoder->bitCount -= 8;
+                    if (o < outputCapacity)
+                        output[o++] = (char)((decoder->bits >> decoder->bitCount) & 0xFF);
+                    else
+                        status = curi_status_error;
+                }
+            }
+        }
+    }
+
+    *outputOffset = o;
+
+    return status;
+}
+
+static curi_status decode_percent(curi_data_decoder* decoder, const char* data, size_t dataLen, char* output, size_t outputCapacity, size_t* outputOffset)
+{
+    size_t i;
+    size_t o = *outputOffset;
+    curi_status status = curi_status_success;
+
+    for (i = 0 ; status == curi_status_success && i < dataLen ; ++i)
+    {
+        const char c = data[i];
+
+        if (decoder->percent > 0)
+        {
+            const int digit = hexdigit_value(c);
+            if (digit < 0)
+                status = curi_status_error;
+            else if (decoder->percent == 1)
+            {
+                decoder->bits = (unsigned long)digit;
+                decoder->percent = 2;
+            }
+            else if (o < outputCapacity)
+            {
+                output[o++] = (char)((decoder->bits << 4) | (unsigned long)digit);
+                decoder->percent = 0;
+            }
+            else
+                status = curi_status_error;
+        }
+        else if (c == '%')
+            decoder->percent = 1;
+        else if (!(char_classes[(unsigned char)c] & CHAR_CLASS_QUERY_FRAGMENT_CHAR_NO_PCT))
+            status = curi_status_error;
+        else if (o < outputCapacity)
+            output[o++] = c;
+        else
+            status = curi_status_error;
+    }
+
+    *outputOffset = o;
+
+    return status;
+}
+
+curi_status curi_data_decoder_decode(curi_data_decoder* decoder, const char* data, size_t dataLen, char* output, size_t outputCapacity, size_t* outputLen /*= 0*/)
+{
+    size_t outputOffset = 0;
+    curi_status status;
+
+    if (decoder->base64)
+        status = decode_base64(decoder, data, dataLen, output, outputCapacity, &outputOffset);
+    else
+        status = decode_percent(decoder, data, dataLen, output, outputCapacity, &outputOffset);
+
+    if (outputLen)
+        *outputLen = outputOffset;
+
+    return status;
+}
+
+curi_status curi_data_decoder_finish(const curi_data_decoder* decoder)
+{
+    // A single base64 character can't make a byte, a padded quartet must be complete
+    if (decoder->bitCount == 6 || (decoder->padding && decoder->bitCount != 0) || decoder->percent > 0)
+        return curi_status_error;
+
+    return curi_status_success;
+}
+
+static size_t skip_chars(const char* str, size_t len, size_t offset, unsigned char charClass, char extraChar)
+{
+    // *( char of class charClass / extraChar / "%" h8 ), the character classes of '\0' being empty
+    for ( ; ; )
+    {
+        char c;
+
+        while (offset < len && ((char_classes[(unsigned char)str[offset]] & charClass) || (str[offset] == extraChar && extraChar != '\0')))
+            ++offset;
+
+        c = peek_char(str, len, offset);
+        if (c == '%'
+            && (char_classes[(unsigned char)peek_char(str, len, offset + 1)] & CHAR_CLASS_HEXDIGIT)
+            && (char_classes[(unsigned char)peek_char(str, len, offset + 2)] & CHAR_CLASS_HEXDIGIT))
+            offset += 3;
+        else
+            return offset;
+    }
+}
+
+static curi_status validate_error(size_t offset, size_t* errorOffset)
+{
+    if (errorOffset)
+        *errorOffset = offset;
+    return curi_status_error;
+}
+
+static curi_status validate_end(const char* str, size_t len, size_t offset, size_t* errorOffset)
+{
+    if (peek_char(str, len, offset) == '\0')
+        return curi_status_success;
+    else
+        return validate_error(offset, errorOffset);
+}
+
+curi_status curi_validate_full_uri(const char* uri, size_t len, size_t* errorOffset /*= 0*/)
+{
+    // Same grammar as parse_full_uri, the callbacks aside:
+    // - as the authority can be empty, "//" always starts it,
+    // - the path alternatives boil down to the longest sequence of pchar and "/".
+    size_t offset = 0;
+
+    // scheme ":"
+    if (!(char_classes[(unsigned char)peek_char(uri, len, 0)] & CHAR_CLASS_ALPHA))
+        return validate_error(0, errorOffset);
+    offset = skip_chars(uri, len, 1, CHAR_CLASS_SCHEME, '\0');
+    if (peek_char(uri, len, offset) != ':')
+        return validate_error(offset, errorOffset);
+    ++offset;
+
+    if (peek_char(uri, len, offset) == '/' && peek_char(uri, len, offset + 1) == '/')
+    {
+        // "//" [ userinfo "@" ] host [ ":" port ] path-abempty
+        size_t userinfoEndOffset;
+
+        offset += 2;
+        userinfoEndOffset = skip_chars(uri, len, offset, CHAR_CLASS_UNRESERVED | CHAR_CLASS_SUB_DELIMS, ':');
+        if (peek_char(uri, len, userinfoEndOffset) == '@')
+            offset = userinfoEndOffset + 1;
+
+        if (peek_char(uri, len, offset) == '[')
+        {
+            size_t literalOffset = offset;
+            unsigned char ipv6Address[16];
+            int isIPv6 = 0;
+            // The IP literal rules don't use the settings
+            if (parse_IP_literal(uri, len, &literalOffset, 0, 0, 0, ipv6Address, &isIPv6) != curi_status_success)
+                return validate_error(offset, errorOffset);
+            offset = literalOffset;
+        }
+        else
+        {
+            offset = skip_chars(uri, len, offset, CHAR_CLASS_UNRESERVED | CHAR_CLASS_SUB_DELIMS, '\0');
+        }
+
+        if (peek_char(uri, len, offset) == ':')
+            offset = skip_chars(uri, len, offset + 1, CHAR_CLASS_DIGIT, '\0');
+
+        if (peek_char(uri, len, offset) == '/')
+            offset = skip_chars(uri, len, offset, CHAR_CLASS_PCHAR_NO_PCT, '/');
+    }
+    else
+    {
+        offset = skip_chars(uri, len, offset, CHAR_CLASS_PCHAR_NO_PCT, '/');
+    }
+
+    if (peek_char(uri, len, offset) == '?')
+        offset = skip_chars(uri, len, offset + 1, CHAR_CLASS_QUERY_FRAGMENT_CHAR_NO_PCT, '\0');
+
+    if (peek_char(uri, len, offset) == '#')
+        offset = skip_chars(uri, len, offset + 1, CHAR_CLASS_QUERY_FRAGMENT_CHAR_NO_PCT, '\0');
+
+    return validate_end(uri, len, offset, errorOffset);
+}
+
+curi_status curi_validate_path(const char* path, size_t len, size_t* errorOffset /*= 0*/)
+{
+    // A path starting with "//" only has its first "/" accepted by parse_path
+    if (peek_char(path, len, 0) == '/' && peek_char(path, len, 1) == '/')
+        return validate_error(1, errorOffset);
+
+    return validate_end(path, len, skip_chars(path, len, 0, CHAR_CLASS_PCHAR_NO_PCT, '/'), errorOffset);
+}
+
+curi_status curi_validate_query(const char* query, size_t len, size_t* errorOffset /*= 0*/)
+{
+    return validate_end(query, len, skip_chars(query, len, 0, CHAR_CLASS_QUERY_FRAGMENT_CHAR_NO_PCT, '\0'), errorOffset);
+}
+
+static int is_iter_end(const char* str, size_t len, size_t offset)
+{
+    return offset >= len || str[offset] == '\0';
+}
+
+void curi_segment_iter_init(curi_segment_iter* iter, const char* path, size_t len)
+{
+    iter->path = path;
+    iter->len = len;
+    iter->offset = 0;
+    if (!is_iter_end(path, len, 0) && path[0] == '/')
+        iter->offset = 1;
+    iter->done = is_iter_end(path, len, iter->offset);
+}
+
+int curi_segment_iter_next(curi_segment_iter* iter, const char** segment, size_t* segmentLen)
+{
+    size_t offset = iter->offset;
+
+    if (iter->done)
+        return 0;
+
+    while (!is_iter_end(iter->path, iter->len, offset) && iter->path[offset] != '/')
+        ++offset;
+
+    *segment = iter->path + iter->offset;
+    *segmentLen = offset - iter->offset;
+
+    // A separator is always followed by a segment, possibly empty
+    if (is_iter_end(iter->path, iter->len, offset))
+        iter->done = 1;
+    else
+        iter->offset = offset + 1;
+
+    return 1;
+}
+
+static int is_query_separator(char c, char separator, const char* separators)
+{
+    if (separators)
+        return c != '\0' && strchr(separators, c) != 0;
+    else
+        return c != '\0' && c == separator;
+}
+
+void curi_query_iter_init(curi_query_iter* iter, const char* query, size_t len, const curi_settings* settings /*= 0*/)
+{
+    iter->query = query;
+    iter->len = len;
+    iter->offset = 0;
+    iter->item_separator = settings ? settings->query_item_separator : '&';
+    iter->key_separator = settings ? settings->query_item_key_separator : '=';
+    iter->item_separators = settings ? settings->query_item_separators : 0;
+    iter->key_separators = settings ? settings->query_item_key_separators : 0;
+}
+
+int curi_query_iter_next(curi_query_iter* iter, curi_query_item* item)
+{
+    const char* query = iter->query;
+
+    // Skipping empty items
+    while (!is_iter_end(query, iter->len, iter->offset) && is_query_separator(query[iter->offset], iter->item_separator, iter->item_separators))
+        ++iter->offset;
+
+    if (is_iter_end(query, iter->len, iter->offset))
+        return 0;
+
+    item->key = query + iter->offset;
+    item->value = 0;
+    item->valueLen = 0;
+
+    while (!is_iter_end(query, iter->len, iter->offset) && !is_query_separator(query[iter->offset], iter->item_separator, iter->item_separators))
+    {
+        if (!item->value && is_query_separator(query[iter->offset], iter->key_separator, iter->key_separators))
+        {
+            item->keyLen = (size_t)(query + iter->offset - item->key);
+            item->value = query + iter->offset + 1;
+        }
+        ++iter->offset;
+    }
+
+    if (item->value)
+        item->valueLen = (size_t)(query + iter->offset - item->value);
+    else
+        item->keyLen = (size_t)(query + iter->offset - item->key);
+
+    return 1;
+}
+
+typedef struct
+{
+    size_t schemeLen; // 0 for relative references, the scheme starting at offset 0
+    int hasAuthority;
+    size_t authorityOffset;
+    size_t authorityLen;
+    size_t pathOffset;
+    size_t pathLen;
+    int hasQuery;
+    size_t queryOffset;
+    size_t queryLen;
+    int hasFragment;
+    size_t fragmentOffset;
+    size_t fragmentLen;
+} uri_components;
+
+static curi_status split_uri_reference(const char* uri, size_t len, uri_components* components)
+{
+    // URI-reference = URI / relative-ref
+    // relative-ref  = relative-part [ "?" query ] [ "#" fragment ]
+    // relative-part = "//" authority path-abempty / path-absolute / path-noscheme / path-empty
+    curi_settings settings;
+    size_t offset = 0;
+    curi_status status = curi_status_error;
+
+    curi_default_settings(&settings);
+    memset(components, 0, sizeof(uri_components));
+
+    {
+        curi_status tryStatus = parse_scheme(uri, len, &offset, &settings, 0, 0);
+        if (tryStatus == curi_status_success)
+            tryStatus = parse_char(':', uri, len, &offset, &settings, 0, 0);
+        if (tryStatus == curi_status_success)
+            components->schemeLen = offset - 1;
+        else
+            offset = 0;
+    }
+
+    {
+        size_t initialOffset = offset;
+        curi_status tryStatus = curi_status_success;
+        if (tryStatus == curi_status_success)
+            tryStatus = parse_char('/', uri, len, &offset, &settings, 0, 0);
+        if (tryStatus == curi_status_success)
+            tryStatus = parse_char('/', uri, len, &offset, &settings, 0, 0);
+        if (tryStatus == curi_status_success)
+        {
+            size_t hostOffset;
+            size_t hostLen;
+            components->authorityOffset = offset;
+            tryStatus = parse_authority(uri, len, &offset, &settings, 0, 0, &hostOffset, &hostLen);
+            components->authorityLen = offset - components->authorityOffset;
+        }
+        if (tryStatus == curi_status_success)
+        {
+            components->hasAuthority = 1;
+            components->pathOffset = offset;
+            tryStatus = parse_path_absolute_or_empty(uri, len, &offset, &settings, 0, 0, 0);
+        }
+        if (tryStatus == curi_status_error)
+        {
+            offset = initialOffset;
+            components->hasAuthority = 0;
+        }
+        else
+            status = tryStatus;
+    }
+
+    if (status == curi_status_error)
+    {
+        components->pathOffset = offset;
+        TRY(status, &offset, parse_path(uri, len, &offset, &settings, 0, 0, 0));
+    }
+
+    components->pathLen = offset - components->pathOffset;
+
+    if (status == curi_status_success && components->schemeLen == 0 && !components->hasAuthority)
+    {
+        // path-noscheme, the first segment can't have a colon
+        size_t i;
+        for (i = components->pathOffset ; i < offset && uri[i] != '/' ; ++i)
+            if (uri[i] == ':')
+                status = curi_status_error;
+    }
+
+    if (status == curi_status_success)
+    {
+        const size_t queryOffset = offset;
+        TRY(status, &offset, parse_query(uri, len, &offset, &settings, 0, 0, 1));
+        if (status == curi_status_success && offset > queryOffset)
+        {
+            components->hasQuery = 1;
+            components->queryOffset = queryOffset + 1;
+            components->queryLen = offset - queryOffset - 1;
+        }
+    }
+
+    if (status == curi_status_success)
+    {
+        const size_t fragmentOffset = offset;
+        TRY(status, &offset, parse_fragment(uri, len, &offset, &settings, 0, 0));
+        if (status == curi_status_success && offset > fragmentOffset)
+        {
+            components->hasFragment = 1;
+            components->fragmentOffset = fragmentOffset + 1;
+            components->fragmentLen = offset - fragmentOffset - 1;
+        }
+    }
+
+    if (status == curi_status_success && *read_char(uri, len, &offset) != '\0')
+        // the input weren't fully consumed
+        status = curi_status_error;
+
+    return status;
+}
+
+static int write_str(const char* str, size_t strLen, char* output, size_t outputCapacity, size_t* outputOffset)
+{
+    if (*outputOffset + strLen > outputCapacity)
+        return 0;
+
+    memcpy(output + *outputOffset, str, strLen);
+    *outputOffset += strLen;
+    return 1;
+}
+
+curi_status curi_resolve(const char* base, size_t baseLen, const char* reference, size_t referenceLen, char* output, size_t outputCapacity, size_t* outputLen /*=0*/)
+{
+    // Strict reference resolution (RFC-3986 section 5.2.2), directly recomposed (section 5.3) in the output
+    uri_components baseComponents;
+    uri_components referenceComponents;
+    const char* scheme = base;
+    size_t schemeLen;
+    const char* query = 0;
+    size_t queryLen = 0;
+    size_t outputOffset = 0;
+    size_t pathOffset;
+    int removeDotSegments = 1;
+    int written = 1;
+
+    if (split_uri_reference(base, baseLen, &baseComponents) != curi_status_success || baseComponents.schemeLen == 0)
+        return curi_status_error;
+
+    if (split_uri_reference(reference, referenceLen, &referenceComponents) != curi_status_success)
+        return curi_status_error;
+
+    schemeLen = baseComponents.schemeLen;
+    if (referenceComponents.schemeLen > 0)
+    {
+        scheme = reference;
+        schemeLen = referenceComponents.schemeLen;
+    }
+
+    written = written && write_str(scheme, schemeLen, output, outputCapacity, &outputOffset);
+    written = written && write_str(":", 1, output, outputCapacity, &outputOffset);
+
+    if (referenceComponents.schemeLen > 0 || referenceComponents.hasAuthority)
+    {
+        if (referenceComponents.hasAuthority)
+        {
+            written = written && write_str("//", 2, output, outputCapacity, &outputOffset);
+            written = written && write_str(reference + referenceComponents.authorityOffset, referenceComponents.authorityLen, output, outputCapacity, &outputOffset);
+        }
+
+        pathOffset = outputOffset;
+        written = written && write_str(reference + referenceComponents.pathOffset, referenceComponents.pathLen, output, outputCapacity, &outputOffset);
+    }
+    else
+    {
+        if (baseComponents.hasAuthority)
+        {
+            written = written && write_str("//", 2, output, outputCapacity, &outputOffset);
+            written = written && write_str(base + baseComponents.authorityOffset, baseComponents.authorityLen, output, outputCapacity, &outputOffset);
+        }
+
+        pathOffset = outputOffset;
+
+        if (referenceComponents.pathLen == 0)
+        {
+            removeDotSegments = 0;
+            written = written && write_str(base + baseComponents.pathOffset, baseComponents.pathLen, output, outputCapacity, &outputOffset);
+
+            if (!referenceComponents.hasQuery && baseComponents.hasQuery)
+            {
+                query = base + baseComponents.queryOffset;
+                queryLen = baseComponents.queryLen;
+            }
+        }
+        else if (reference[referenceComponents.pathOffset] == '/')
+        {
+            written = written && write_str(reference + referenceComponents.pathOffset, referenceComponents.pathLen, output, outputCapacity, &outputOffset);
+        }
+        else
+        {
+            // Merging with the base path up to its last segment
+            if (baseComponents.hasAuthority && baseComponents.pathLen == 0)
+            {
+                written = written && write_str("/", 1, output, outputCapacity, &outputOffset);
+            }
+            else
+            {
+                size_t basePathLen = baseComponents.pathLen;
+                while (basePathLen > 0 && base[baseComponents.pathOffset + basePathLen - 1] != '/')
+                    --basePathLen;
+                written = written && write_str(base + baseComponents.pathOffset, basePathLen, output, outputCapacity, &outputOffset);
+            }
+
+            written = written && write_str(reference + referenceComponents.pathOffset, referenceComponents.pathLen, output, outputCapacity, &outputOffset);
+        }
+    }
+
+    if (!written)
+        return curi_status_error;
+
+    if (removeDotSegments)
+    {
+        size_t pathLen;
+        curi_normalize_path(output + pathOffset, outputOffset - pathOffset, curi_path_remove_dot_segments, &pathLen);
+        outputOffset = pathOffset + pathLen;
+    }
+
+    if (referenceComponents.hasQuery)
+    {
+        query = reference + referenceComponents.queryOffset;
+        queryLen = referenceComponents.queryLen;
+    }
+
+    if (query)
+    {
+        written = written && write_str("?", 1, output, outputCapacity, &outputOffset);
+        written = written && write_str(query, queryLen, output, outputCapacity, &outputOffset);
+    }
+
+    if (referenceComponents.hasFragment)
+    {
+        written = written && write_str("#", 1, output, outputCapacity, &outputOffset);
+        written = written && write_str(reference + referenceComponents.fragmentOffset, referenceComponents.fragmentLen, output, outputCapacity, &outputOffset);
+    }
+
+    if (!written)
+        return curi_status_error;
+
+    if (outputLen)
+        *outputLen = outputOffset;
+
+    return curi_status_success;
+}
+
+curi_status curi_url_decode(const char* input, size_t inputLen, char* output, size_t outputCapacity, size_t* outputLen /*=0*/)
+{
+    curi_status status = curi_status_error;
+    size_t inputOffset = 0;
+    size_t outputOffset = 0;
+
+    #define HEXTOI(x) (isdigit(x) ? x - '0' : tolower(x) - 'a' + 10)
+
+    while ( outputOffset < outputCapacity )
+    {
+        status = curi_status_error;
+        if (status == curi_status_error)
+        {
+            // percent encoding
+            TRY(status, &inputOffset, parse_percent_encoded(input, inputLen, &inputOffset, 0, 0, 0));
+
+            if (status == curi_status_success)
+            {
+                int encodedChar = ((HEXTOI(input[inputOffset - 2]) << 4) | HEXTOI(tolower(input[inputOffset - 1])));
+                if (encodedChar < 128) // Only support ascii percent encodage at the moment.
+                {
+                    output[outputOffset] = (char)encodedChar;
+                    ++outputOffset;
+                }
+                else
+                {
+                    status = curi_status_error;
+                }
+            }
+        }
+
+        if (status == curi_status_error)
+        {
+            // '+' as a space
+            TRY(status, &inputOffset, parse_char('+', input, inputLen, &inputOffset, 0, 0, 0));
+            if (status == curi_status_success)
+            {
+                 output[outputOffset] = ' ';
+                 ++outputOffset;
+            }
+        }
+
+        if (status == curi_status_error)
+        {
+            // "any" character
+            output[outputOffset] = *read_char(input, inputLen, &inputOffset);
+            if (output[outputOffset] == '\0')
+            {
+                if (outputLen)
+                    *outputLen = outputOffset;
+
+                return curi_status_success;
+            }
+            else
+            {
+                ++outputOffset;
+            }
+        }
+    }
+
+    if (*read_char(input, inputLen, &inputOffset) == '\0')
+    {
+        if (outputLen)
+            *outputLen = outputOffset;
+
+        return curi_status_success;
+    }
+    else
+    {
+        return curi_status_error;
+    }
+}
+
+curi_status curi_url_decode_nt(const char* input, char* output, size_t outputCapacity, size_t* outputLen /*=0*/)
+{
+    return curi_url_decode(input, SIZE_MAX, output, outputCapacity, outputLen);
+}
+
+static size_t bounded_strlen(const char* str, size_t len)
+{
+    size_t i = 0;
+    while (i < len && str[i] != '\0')
+        ++i;
+    return i;
+}
+
+static size_t normalize_path_segment(char* path, size_t pathLen, size_t* readOffset, size_t writeOffset, int normalization)
+{
+    // Rewrites the segment starting at readOffset to writeOffset, returns its new length or -1 for invalid percent encodings
+    const size_t segmentStart = writeOffset;
+
+    while (*readOffset < pathLen && path[*readOffset] != '/')
+    {
+        char c = path[(*readOffset)++];
+
+        if (c == '%' && (normalization & curi_path_normalize_percent_encoding))
+        {
+            int high;
+            int low;
+
+            if (*readOffset + 2 > pathLen)
+                return (size_t)-1;
+
+            high = hexdigit_value(path[*readOffset]);
+            low = hexdigit_value(path[*readOffset + 1]);
+            if (high < 0 || low < 0)
+                return (size_t)-1;
+
+            c = (char)((high << 4) | low);
+            *readOffset += 2;
+
+            if (char_classes[(unsigned char)c] & CHAR_CLASS_UNRESERVED)
+            {
+                path[writeOffset++] = c;
+            }
+            else
+            {
+                // Uppercase hexadecimal digits
+                path[writeOffset++] = '%';
+                path[writeOffset++] = "0123456789ABCDEF"[high];
+                path[writeOffset++] = "0123456789ABCDEF"[low];
+            }
+        }
+        else
+        {
+            path[writeOffset++] = c;
+        }
+    }
+
+    return writeOffset - segmentStart;
+}
+
+curi_status curi_normalize_path(char* path, size_t pathLen, int normalization, size_t* newPathLen /*=0*/)
+{
+    // Single pass, each segment being rewritten in place after the previous ones.
+    // The output holds the stack of the segments kept so far, ".." popping the last one.
+    size_t readOffset = 0;
+    size_t writeOffset = 0;
+
+    pathLen = bounded_strlen(path, pathLen);
+
+    if (pathLen > 0 && path[0] == '/')
+    {
+        readOffset = 1;
+        writeOffset = 1;
+    }
+
+    while (readOffset <= pathLen)
+    {
+        const size_t segmentStart = writeOffset;
+        const size_t segmentLen = normalize_path_segment(path, pathLen, &readOffset, writeOffset, normalization);
+        const int isLast = readOffset >= pathLen;
+
+        if (segmentLen == (size_t)-1)
+            return curi_status_error;
+
+        if ((normalization & curi_path_remove_dot_segments) && segmentLen == 1 && path[segmentStart] == '.')
+        {
+            writeOffset = segmentStart;
+        }
+        else if ((normalization & curi_path_remove_dot_segments) && segmentLen == 2 && path[segmentStart] == '.' && path[segmentStart + 1] == '.')
+        {
+            // Popping the previous segment, keeping the root
+            writeOffset = segmentStart;
+            if (writeOffset > 0 && !(writeOffset == 1 && path[0] == '/'))
+            {
+                --writeOffset;
+                while (writeOffset > 0 && path[writeOffset - 1] != '/')
+                    --writeOffset;
+            }
+        }
+        else if ((normalization & curi_path_merge_slashes) && segmentLen == 0 && !isLast)
+        {
+            writeOffset = segmentStart;
+        }
+        else
+        {
+            writeOffset = segmentStart + segmentLen;
+            if (!isLast)
+                path[writeOffset++] = '/';
+        }
+
+        // Skipping the '/'
+        ++readOffset;
+    }
+
+    if (newPathLen)
+        *newPathLen = writeOffset;
+
+    return curi_status_success;
+}
+
+// Punycode (RFC-3492) parameters
+#define PUNYCODE_BASE 36
+#define PUNYCODE_TMIN 1
+#define PUNYCODE_TMAX 26
+#define PUNYCODE_SKEW 38
+#define PUNYCODE_DAMP 700
+#define PUNYCODE_INITIAL_BIAS 72
+#define PUNYCODE_INITIAL_N 0x80
+#define PUNYCODE_MAXINT 0x7FFFFFFFUL
+
+// Maximum number of code points in a punycode encoded label
+#define PUNYCODE_MAX_CODE_POINTS 256
+
+static unsigned long punycode_adapt(unsigned long delta, unsigned long numPoints, int firstTime)
+{
+    unsigned long k = 0;
+
+    delta = firstTime ? delta / PUNYCODE_DAMP : delta / 2;
+    delta += delta / numPoints;
+
+    while (delta > ((PUNYCODE_BASE - PUNYCODE_TMIN) * PUNYCODE_TMAX) / 2)
+    {
+        delta /= PUNYCODE_BASE - PUNYCODE_TMIN;
+        k += PUNYCODE_BASE;
+    }
+
+    return k + (PUNYCODE_BASE - PUNYCODE_TMIN + 1) * delta / (delta + PUNYCODE_SKEW);
+}
+
+static unsigned long punycode_threshold(unsigned long k, unsigned long bias)
+{
+    if (k <= bias)
+        return PUNYCODE_TMIN;
+    else if (k >= bias + PUNYCODE_TMAX)
+        return PUNYCODE_TMAX;
+    else
+        return k - bias;
+}
+
+static char punycode_encode_digit(unsigned long digit)
+{
+    // 0..25 map to 'a'..'z', 26..35 map to '0'..'9'
+    return (char)(digit < 26 ? 'a' + digit : '0' + (digit - 26));
+}
+
+static unsigned long punycode_decode_digit(char c)
+{
+    if (c >= '0' && c <= '9')
+        return (unsigned long)(c - '0' + 26);
+    else if (c >= 'A' && c <= 'Z')
+        return (unsigned long)(c - 'A');
+    else if (c >= 'a' && c <= 'z')
+        return (unsigned long)(c - 'a');
+    else
+        return PUNYCODE_BASE;
+}
+
+static size_t utf8_decode(const char* input, size_t inputLen, unsigned long* codePoint)
+{
+    // Returns the number of bytes read, 0 for an invalid sequence.
+    const unsigned char* bytes = (const unsigned char*)input;
+    size_t sequenceLen;
+    size_t i;
+    unsigned long minCodePoint;
+
+    if (bytes[0] < 0x80)
+    {
+        *codePoint = bytes[0];
+        return 1;
+    }
+    else if ((bytes[0] & 0xE0) == 0xC0)
+    {
+        sequenceLen = 2;
+        minCodePoint = 0x80;
+        *codePoint = bytes[0] & 0x1F;
+    }
+    else if ((bytes[0] & 0xF0) == 0xE0)
+    {
+        sequenceLen = 3;
+        minCodePoint = 0x800;
+        *codePoint = bytes[0] & 0x0F;
+    }
+    else if ((bytes[0] & 0xF8) == 0xF0)
+    {
+        sequenceLen = 4;
+        minCodePoint = 0x10000;
+        *codePoint = bytes[0] & 0x07;
+    }
+    else
+        return 0;
+
+    if (sequenceLen > inputLen)
+        return 0;
+
+    for (i = 1 ; i < sequenceLen ; ++i)
+    {
+        if ((bytes[i] & 0xC0) != 0x80)
+            return 0;
+        *codePoint = (*codePoint << 6) | (bytes[i] & 0x3F);
+    }
+
+    if (*codePoint < minCodePoint || *codePoint > 0x10FFFF || (*codePoint >= 0xD800 && *codePoint <= 0xDFFF))
+        return 0;
+
+    return sequenceLen;
+}
+
+static curi_status utf8_encode(unsigned long codePoint, char* output, size_t outputCapacity, size_t* outputOffset)
+{
+    size_t sequenceLen;
+    size_t i;
+
+    if (codePoint < 0x80)
+        sequenceLen = 1;
+    else if (codePoint < 0x800)
+        sequenceLen = 2;
+    else if (codePoint < 0x10000)
+        sequenceLen = 3;
+    else
+        sequenceLen = 4;
+
+    if (codePoint > 0x10FFFF || (codePoint >= 0xD800 && codePoint <= 0xDFFF) || *outputOffset + sequenceLen > outputCapacity)
+        return curi_status_error;
+
+    if (sequenceLen == 1)
+    {
+        output[*outputOffset] = (char)codePoint;
+    }
+    else
+    {
+        static const unsigned char firstByteMarks[5] = { 0x00, 0x00, 0xC0, 0xE0, 0xF0 };
+        for (i = sequenceLen - 1 ; i > 0 ; --i)
+        {
+            output[*outputOffset + i] = (char)(0x80 | (codePoint & 0x3F));
+            codePoint >>= 6;
+        }
+        output[*outputOffset] = (char)(firstByteMarks[sequenceLen] | codePoint);
+    }
+
+    *outputOffset += sequenceLen;
+    return curi_status_success;
+}
+
+static curi_status punycode_encode(const unsigned long* codePoints, size_t codePointCount, char* output, size_t outputCapacity, size_t* outputLen)
+{
+    unsigned long n = PUNYCODE_INITIAL_N;
+    unsigned long delta = 0;
+    unsigned long bias = PUNYCODE_INITIAL_BIAS;
+    size_t basicCount = 0;
+    size_t handledCount;
+    size_t outputOffset = 0;
+    size_t i;
+
+    // Basic code points are copied first
+    for (i = 0 ; i < codePointCount ; ++i)
+    {
+        if (codePoints[i] < 0x80)
+        {
+            if (outputOffset >= outputCapacity)
+                return curi_status_error;
+            output[outputOffset++] = (char)codePoints[i];
+            ++basicCount;
+        }
+    }
+
+    handledCount = basicCount;
+
+    if (basicCount > 0)
+    {
+        if (outputOffset >= outputCapacity)
+            return curi_status_error;
+        output[outputOffset++] = '-';
+    }
+
+    while (handledCount < codePointCount)
+    {
+        // The smallest code point not handled yet
+        unsigned long m = PUNYCODE_MAXINT;
+        for (i = 0 ; i < codePointCount ; ++i)
+            if (codePoints[i] >= n && codePoints[i] < m)
+                m = codePoints[i];
+
+        if (m - n > (PUNYCODE_MAXINT - delta) / (handledCount + 1))
+            return curi_status_error;
+
+        delta += (m - n) * (handledCount + 1);
+        n = m;
+
+        for (i = 0 ; i < codePointCount ; ++i)
+        {
+            if (codePoints[i] < n && ++delta > PUNYCODE_MAXINT)
+                return curi_status_error;
+
+            if (codePoints[i] == n)
+            {
+                // Encoding delta as a variable-length integer
+                unsigned long q = delta;
+                unsigned long k;
+
+                for (k = PUNYCODE_BASE ; ; k += PUNYCODE_BASE)
+                {
+                    const unsigned long t = punycode_threshold(k, bias);
+                    if (q < t)
+                        break;
+                    if (outputOffset >= outputCapacity)
+                        return curi_status_error;
+                    output[outputOffset++] = punycode_encode_digit(t + (q - t) % (PUNYCODE_BASE - t));
+                    q = (q - t) / (PUNYCODE_BASE - t);
+                }
+
+                if (outputOffset >= outputCapacity)
+                    return curi_status_error;
+                output[outputOffset++] = punycode_encode_digit(q);
+
+                bias = punycode_adapt(delta, (unsigned long)handledCount + 1, handledCount == basicCount);
+                delta = 0;
+                ++handledCount;
+            }
+        }
+
+        ++delta;
+        ++n;
+    }
+
+    *outputLen = outputOffset;
+    return curi_status_success;
+}
+
+static curi_status punycode_decode(const char* input, size_t inputLen, unsigned long* codePoints, size_t codePointCapacity, size_t* codePointCount)
+{
+    unsigned long n = PUNYCODE_INITIAL_N;
+    unsigned long i = 0;
+    unsigned long bias = PUNYCODE_INITIAL_BIAS;
+    size_t outputCount = 0;
+    size_t basicEnd = 0;
+    size_t inputOffset;
+    size_t j;
+
+    // Basic code points are the ones before the last delimiter
+    for (j = 0 ; j < inputLen ; ++j)
+        if (input[j] == '-')
+            basicEnd = j;
+
+    for (j = 0 ; j < basicEnd ; ++j)
+    {
+        if ((unsigned char)input[j] >= 0x80 || outputCount >= codePointCapacity)
+            return curi_status_error;
+        codePoints[outputCount++] = (unsigned char)input[j];
+    }
+
+    for (inputOffset = basicEnd > 0 ? basicEnd + 1 : 0 ; inputOffset < inputLen ; )
+    {
+        // Decoding a variable-length integer into delta, added to i
+        const unsigned long oldi = i;
+        unsigned long w = 1;
+        unsigned long k;
+
+        for (k = PUNYCODE_BASE ; ; k += PUNYCODE_BASE)
+        {
+            unsigned long digit;
+            unsigned long t;
+
+            if (inputOffset >= inputLen)
+                return curi_status_error;
+
+            digit = punycode_decode_digit(input[inputOffset++]);
+            if (digit >= PUNYCODE_BASE || digit > (PUNYCODE_MAXINT - i) / w)
+                return curi_status_error;
+
+            i += digit * w;
+            t = punycode_threshold(k, bias);
+            if (digit < t)
+                break;
+
+            if (w > PUNYCODE_MAXINT / (PUNYCODE_BASE - t))
+                return curi_status_error;
+            w *= PUNYCODE_BASE - t;
+        }
+
+        bias = punycode_adapt(i - oldi, (unsigned long)outputCount + 1, oldi == 0);
+
+        if (i / (outputCount + 1) > PUNYCODE_MAXINT - n)
+            return curi_status_error;
+        n += i / (outputCount + 1);
+        i %= (outputCount + 1);
+
+        if (n < 0x80 || outputCount >= codePointCapacity)
+            return curi_status_error;
+
+        // Inserting n at position i
+        memmove(codePoints + i + 1, codePoints + i, (outputCount - i) * sizeof(unsigned long));
+        codePoints[i++] = n;
+        ++outputCount;
+    }
+
+    *codePointCount = outputCount;
+    return curi_status_success;
+}
+
+curi_status curi_punycode_encode(const char* input, size_t inputLen, char* output, size_t outputCapacity, size_t* outputLen /*=0*/)
+{
+    unsigned long codePoints[PUNYCODE_MAX_CODE_POINTS];
+    size_t codePointCount = 0;
+    size_t inputOffset = 0;
+    size_t encodedLen;
+    curi_status status;
+
+    inputLen = bounded_strlen(input, inputLen);
+
+    while (inputOffset < inputLen)
+    {
+        const size_t sequenceLen = utf8_decode(input + inputOffset, inputLen - inputOffset, &codePoints[codePointCount]);
+        if (sequenceLen == 0 || ++codePointCount >= PUNYCODE_MAX_CODE_POINTS)
+            return curi_status_error;
+        inputOffset += sequenceLen;
+    }
+
+    status = punycode_encode(codePoints, codePointCount, output, outputCapacity, &encodedLen);
+
+    if (status == curi_status_success && outputLen)
+        *outputLen = encodedLen;
+
+    return status;
+}
+
+curi_status curi_punycode_decode(const char* input, size_t inputLen, char* output, size_t outputCapacity, size_t* outputLen /*=0*/)
+{
+    unsigned long codePoints[PUNYCODE_MAX_CODE_POINTS];
+    size_t codePointCount;
+    size_t outputOffset = 0;
+    size_t i;
+    curi_status status;
+
+    status = punycode_decode(input, bounded_strlen(input, inputLen), codePoints, PUNYCODE_MAX_CODE_POINTS, &codePointCount);
+
+    for (i = 0 ; status == curi_status_success && i < codePointCount ; ++i)
+        status = utf8_encode(codePoints[i], output, outputCapacity, &outputOffset);
+
+    if (status == curi_status_success && outputLen)
+        *outputLen = outputOffset;
+
+    return status;
+}
+
+static char to_lower_ascii(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+}
+
+static curi_status normalize_host_label(const char* label, size_t labelLen, int normalization, char* output, size_t outputCapacity, size_t* outputOffset)
+{
+    size_t i;
+    int isAscii = 1;
+    int isPunycode;
+
+    for (i = 0 ; i < labelLen ; ++i)
+        if ((unsigned char)label[i] >= 0x80)
+            isAscii = 0;
+
+    isPunycode = isAscii && labelLen >= 4 && to_lower_ascii(label[0]) == 'x' && to_lower_ascii(label[1]) == 'n' && label[2] == '-' && label[3] == '-';
+
+    if (isPunycode && (normalization & curi_host_to_unicode))
+    {
+        unsigned long codePoints[PUNYCODE_MAX_CODE_POINTS];
+        size_t codePointCount;
+        curi_status status = punycode_decode(label + 4, labelLen - 4, codePoints, PUNYCODE_MAX_CODE_POINTS, &codePointCount);
+
+        for (i = 0 ; status == curi_status_success && i < codePointCount ; ++i)
+        {
+            if ((normalization & curi_host_lowercase) && codePoints[i] < 0x80)
+                codePoints[i] = (unsigned long)to_lower_ascii((char)codePoints[i]);
+            status = utf8_encode(codePoints[i], output, outputCapacity, outputOffset);
+        }
+
+        return status;
+    }
+    else if (!isAscii && (normalization & curi_host_to_ascii))
+    {
+        unsigned long codePoints[PUNYCODE_MAX_CODE_POINTS];
+        size_t codePointCount = 0;
+        size_t encodedLen;
+        curi_status status;
+
+        for (i = 0 ; i < labelLen ; )
+        {
+            const size_t sequenceLen = utf8_decode(label + i, labelLen - i, &codePoints[codePointCount]);
+            if (sequenceLen == 0 || codePointCount + 1 >= PUNYCODE_MAX_CODE_POINTS)
+                return curi_status_error;
+            if ((normalization & curi_host_lowercase) && codePoints[codePointCount] < 0x80)
+                codePoints[codePointCount] = (unsigned long)to_lower_ascii((char)codePoints[codePointCount]);
+            ++codePointCount;
+            i += sequenceLen;
+        }
+
+        if (*outputOffset + 4 > outputCapacity)
+            return curi_status_error;
+        memcpy(output + *outputOffset, "xn--", 4);
+        *outputOffset += 4;
+
+        status = punycode_encode(codePoints, codePointCount, output + *outputOffset, outputCapacity - *outputOffset, &encodedLen);
+
+        // An encoded label is still a DNS label, limited to 63 characters
+        if (status == curi_status_success && encodedLen + 4 > 63)
+            status = curi_status_error;
+
+        *outputOffset += encodedLen;
+        return status;
+    }
+    else
+    {
+        if (*outputOffset + labelLen > outputCapacity)
+            return curi_status_error;
+
+        for (i = 0 ; i < labelLen ; ++i)
+            output[*outputOffset + i] = (normalization & curi_host_lowercase) ? to_lower_ascii(label[i]) : label[i];
+
+        *outputOffset += labelLen;
+        return curi_status_success;
+    }
+}
+
+curi_status curi_normalize_host(const char* host, size_t hostLen, int normalization, char* output, size_t outputCapacity, size_t* outputLen /*=0*/)
+{
+    curi_status status = curi_status_success;
+    size_t labelStart = 0;
+    size_t outputOffset = 0;
+    size_t i;
+
+    if ((normalization & curi_host_to_ascii) && (normalization & curi_host_to_unicode))
+        return curi_status_error;
+
+    hostLen = bounded_strlen(host, hostLen);
+
+    for (i = 0 ; status == curi_status_success && i <= hostLen ; ++i)
+    {
+        if (i == hostLen || host[i] == '.')
+        {
+            status = normalize_host_label(host + labelStart, i - labelStart, normalization, output, outputCapacity, &outputOffset);
+
+            if (status == curi_status_success && i < hostLen)
+            {
+                if (outputOffset >= outputCapacity)
+                    status = curi_status_error;
+                else
+                    output[outputOffset++] = '.';
+            }
+
+            labelStart = i + 1;
+        }
+    }
+
+    if (status == curi_status_success && outputLen)
+        *outputLen = outputOffset;
+
+    return status;
+}
+
+// Hosts longer than DNS names aren't cached
+#define HOST_CACHE_MAX_HOST_LENGTH 255
+
+typedef struct
+{
+    size_t hash; // 0 for unused entries
+    int normalization;
+    curi_status status;
+    size_t hostLen;
+    size_t normalizedHostLen;
+    char host[HOST_CACHE_MAX_HOST_LENGTH];
+    char normalizedHost[NORMALIZED_HOST_MAX_LENGTH];
+} host_cache_entry;
+
+struct curi_host_cache
+{
+    void (*deallocate)(void* userData, void* ptr, size_t size);
+    void* userData;
+    size_t capacity;
+    host_cache_entry entries[1];
+};
+
+static size_t host_cache_allocation_size(size_t capacity)
+{
+    return sizeof(curi_host_cache) + (capacity - 1) * sizeof(host_cache_entry);
+}
+
+curi_host_cache* curi_host_cache_create(size_t capacity, const curi_settings* settings /*= 0*/, void* userData /*= 0*/)
+{
+    curi_host_cache* cache;
+
+    if (capacity == 0)
+        return 0;
+
+    if (settings)
+        cache = (curi_host_cache*)settings->allocate(userData, host_cache_allocation_size(capacity));
+    else
+        cache = (curi_host_cache*)default_allocate(userData, host_cache_allocation_size(capacity));
+
+    if (cache)
+    {
+        size_t i;
+        cache->deallocate = settings ? settings->deallocate : default_deallocate;
+        cache->userData = userData;
+        cache->capacity = capacity;
+        for (i = 0 ; i < capacity ; ++i)
+            cache->entries[i].hash = 0;
+    }
+
+    return cache;
+}
+
+void curi_host_cache_destroy(curi_host_cache* cache)
+{
+    if (cache)
+        cache->deallocate(cache->userData, cache, host_cache_allocation_size(cache->capacity));
+}
+
+curi_status curi_host_cache_normalize(curi_host_cache* cache, const char* host, size_t hostLen, int normalization, char* output, size_t outputCapacity, size_t* outputLen /*=0*/)
+{
+    host_cache_entry* entry;
+    size_t hash = 2166136261U;
+    size_t i;
+
+    hostLen = bounded_strlen(host, hostLen);
+
+    if (hostLen > HOST_CACHE_MAX_HOST_LENGTH)
+        return curi_normalize_host(host, hostLen, normalization, output, outputCapacity, outputLen);
+
+    // FNV-1a hash of the host and the normalization flags, never 0
+    for (i = 0 ; i < hostLen ; ++i)
+        hash = (hash ^ (unsigned char)host[i]) * 16777619U;
+    hash = (hash ^ (size_t)normalization) * 16777619U;
+    if (hash == 0)
+        hash = 1;
+
+    // Direct mapped, a new host evicts the one previously stored in its entry
+    entry = &cache->entries[hash % cache->capacity];
+
+    if (entry->hash != hash || entry->normalization != normalization || entry->hostLen != hostLen || memcmp(entry->host, host, hostLen) != 0)
+    {
+        entry->hash = 0;
+        entry->status = curi_normalize_host(host, hostLen, normalization, entry->normalizedHost, NORMALIZED_HOST_MAX_LENGTH, &entry->normalizedHostLen);
+        if (entry->status != curi_status_success && outputCapacity > NORMALIZED_HOST_MAX_LENGTH)
+            // Might have failed because of the entry capacity, not caching it
+            return curi_normalize_host(host, hostLen, normalization, output, outputCapacity, outputLen);
+
+        memcpy(entry->host, host, hostLen);
+        entry->hostLen = hostLen;
+        entry->normalization = normalization;
+        entry->hash = hash;
+    }
+
+    if (entry->status != curi_status_success)
+        return entry->status;
+
+    if (entry->normalizedHostLen > outputCapacity)
+        return curi_status_error;
+
+    memcpy(output, entry->normalizedHost, entry->normalizedHostLen);
+    if (outputLen)
+        *outputLen = entry->normalizedHostLen;
+
+    return curi_status_success;
+}
+
+// Atomic operations used by the host table
+#if defined(__GNUC__) || defined(__clang__)
+#   define ATOMIC_LOAD_ACQUIRE(ptr) __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#   define ATOMIC_STORE_RELEASE(ptr, value) __atomic_store_n((ptr), (value), __ATOMIC_RELEASE)
+#   define ATOMIC_FENCE() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#   define ATOMIC_TRY_LOCK(ptr) (__atomic_exchange_n((ptr), 1, __ATOMIC_ACQUIRE) == 0)
+#elif defined(_MSC_VER)
+#   include <intrin.h>
+#   define ATOMIC_LOAD_ACQUIRE(ptr) _InterlockedCompareExchange((ptr), 0, 0)
+#   define ATOMIC_STORE_RELEASE(ptr, value) _InterlockedExchange((ptr), (value))
+#   define ATOMIC_FENCE() { long fence; _InterlockedExchange(&fence, 0); }
+#   define ATOMIC_TRY_LOCK(ptr) (_InterlockedExchange((ptr), 1) == 0)
+#else
+    // No known atomic operations, the host table is not thread safe, as documented by curi_host_table_create
+#   define ATOMIC_LOAD_ACQUIRE(ptr) (*(ptr))
+#   define ATOMIC_STORE_RELEASE(ptr, value) (*(ptr) = (value))
+#   define ATOMIC_FENCE()
+#   define ATOMIC_TRY_LOCK(ptr) ((*(ptr) = 1) == 1)
+#endif
+
+#define HOST_TABLE_STRIPE_COUNT 16
+#define HOST_TABLE_EMPTY_SLOT 0
+
+typedef struct
+{
+    volatile long version; // odd while the entry is being written
+    volatile long referenced; // reference bit of the CLOCK eviction
+    unsigned long hash;
+    size_t hostLen; // 0 for unused entries
+    char host[CURI_HOST_TABLE_MAX_HOST_LENGTH];
+} host_table_entry;
+
+typedef struct
+{
+    volatile long lock;
+    size_t usedEntryCount;
+    size_t clockHand;
+    volatile long* slots; // open addressing index of the entries, storing their local ID + 1
+    host_table_entry* entries;
+} host_table_stripe;
+
+struct curi_host_table
+{
+    void (*deallocate)(void* userData, void* ptr, size_t size);
+    void* userData;
+    size_t allocationSize;
+    size_t stripeCapacity;
+    size_t slotMask;
+    host_table_stripe stripes[HOST_TABLE_STRIPE_COUNT];
+};
+
+curi_host_table* curi_host_table_create(size_t capacity, const curi_settings* settings /*= 0*/, void* userData /*= 0*/)
+{
+    curi_host_table* table;
+    size_t stripeCapacity;
+    size_t slotCount = 1;
+    size_t allocationSize;
+
+    if (capacity == 0)
+        return 0;
+
+    // At least twice as many slots as entries, for short probe sequences
+    stripeCapacity = (capacity + HOST_TABLE_STRIPE_COUNT - 1) / HOST_TABLE_STRIPE_COUNT;
+    while (slotCount < 2 * stripeCapacity)
+        slotCount *= 2;
+
+    allocationSize = sizeof(curi_host_table) + HOST_TABLE_STRIPE_COUNT * (stripeCapacity * sizeof(host_table_entry) + slotCount * sizeof(long));
+
+    if (settings)
+        table = (curi_host_table*)settings->allocate(userData, allocationSize);
+    else
+        table = (curi_host_table*)default_allocate(userData, allocationSize);
+
+    if (table)
+    {
+        host_table_entry* entries = (host_table_entry*)(table + 1);
+        volatile long* slots = (volatile long*)(entries + HOST_TABLE_STRIPE_COUNT * stripeCapacity);
+        size_t i;
+
+        table->deallocate = settings ? settings->deallocate : default_deallocate;
+        table->userData = userData;
+        table->allocationSize = allocationSize;
+        table->stripeCapacity = stripeCapacity;
+        table->slotMask = slotCount - 1;
+
+        for (i = 0 ; i < HOST_TABLE_STRIPE_COUNT ; ++i)
+        {
+            host_table_stripe* stripe = &table->stripes[i];
+            size_t j;
+
+            stripe->lock = 0;
+            stripe->usedEntryCount = 0;
+            stripe->clockHand = 0;
+            stripe->entries = entries + i * stripeCapacity;
+            stripe->slots = slots + i * slotCount;
+
+            for (j = 0 ; j < stripeCapacity ; ++j)
+            {
+                stripe->entries[j].version = 0;
+                stripe->entries[j].referenced = 0;
+                stripe->entries[j].hostLen = 0;
+            }
+
+            for (j = 0 ; j < slotCount ; ++j)
+                stripe->slots[j] = HOST_TABLE_EMPTY_SLOT;
+        }
+    }
+
+    return table;
+}
+
+void curi_host_table_destroy(curi_host_table* table)
+{
+    if (table)
+        table->deallocate(table->userData, table, table->allocationSize);
+}
+
+size_t curi_host_table_capacity(const curi_host_table* table)
+{
+    return HOST_TABLE_STRIPE_COUNT * table->stripeCapacity;
+}
+
+static size_t host_table_entry_read(const host_table_entry* entry, unsigned long* hash, char* host)
+{
+    // Seqlock read, retried until no write happened during the copy
+    for ( ; ; )
+    {
+        const long version = ATOMIC_LOAD_ACQUIRE(&entry->version);
+        size_t hostLen;
+
+        if (version & 1)
+            continue;
+
+        *hash = entry->hash;
+        hostLen = entry->hostLen;
+        if (hostLen > CURI_HOST_TABLE_MAX_HOST_LENGTH)
+            continue;
+        memcpy(host, entry->host, hostLen);
+
+        ATOMIC_FENCE();
+        if (ATOMIC_LOAD_ACQUIRE(&entry->version) == version)
+            return hostLen;
+    }
+}
+
+static int host_table_entry_equals(const host_table_entry* entry, unsigned long hash, const char* host, size_t hostLen)
+{
+    // Seqlock read, retried until no write happened during the comparison
+    for ( ; ; )
+    {
+        const long version = ATOMIC_LOAD_ACQUIRE(&entry->version);
+        int equals;
+
+        if (version & 1)
+            continue;
+
+        equals = entry->hash == hash && entry->hostLen == hostLen && memcmp(entry->host, host, hostLen) == 0;
+
+        ATOMIC_FENCE();
+        if (ATOMIC_LOAD_ACQUIRE(&entry->version) == version)
+            return equals;
+    }
+}
+
+static long host_table_find(const host_table_stripe* stripe, size_t slotMask, unsigned long hash, const char* host, size_t hostLen)
+{
+    // Returns the local ID of the host in the stripe, -1 if not found
+    size_t slot = hash & slotMask;
+    size_t i;
+
+    for (i = 0 ; i <= slotMask ; ++i, slot = (slot + 1) & slotMask)
+    {
+        const long value = ATOMIC_LOAD_ACQUIRE(&stripe->slots[slot]);
+
+        if (value == HOST_TABLE_EMPTY_SLOT)
+            break;
+
+        if (host_table_entry_equals(&stripe->entries[value - 1], hash, host, hostLen))
+            return value - 1;
+    }
+
+    return -1;
+}
+
+static void host_table_remove_slot(host_table_stripe* stripe, size_t slotMask, size_t slot)
+{
+    // Called with the stripe lock held. Backward shift deletion: the following entries of the
+    // probe sequence are moved up, leaving no tombstone. A lock-free lookup racing with a shift
+    // may miss its host, it is then retried under the lock.
+    size_t next = slot;
+
+    for ( ; ; )
+    {
+        long value;
+        size_t home;
+
+        next = (next + 1) & slotMask;
+        value = stripe->slots[next];
+
+        if (value == HOST_TABLE_EMPTY_SLOT)
+            break;
+
+        // The entry can fill the hole only if its home slot isn't cyclically in ]slot, next]
+        home = stripe->entries[value - 1].hash & slotMask;
+        if (((next - home) & slotMask) >= ((next - slot) & slotMask))
+        {
+            ATOMIC_STORE_RELEASE(&stripe->slots[slot], value);
+            slot = next;
+        }
+    }
+
+    ATOMIC_STORE_RELEASE(&stripe->slots[slot], HOST_TABLE_EMPTY_SLOT);
+}
+
+static long host_table_insert(host_table_stripe* stripe, size_t stripeCapacity, size_t slotMask, unsigned long hash, const char* host, size_t hostLen)
+{
+    // Called with the stripe lock held, returns the local ID of the inserted host
+    host_table_entry* entry;
+    size_t localId;
+    size_t slot;
+
+    if (stripe->usedEntryCount < stripeCapacity)
+    {
+        localId = stripe->usedEntryCount++;
+    }
+    else
+    {
+        // CLOCK eviction: the first entry not referenced since the last pass of the hand is evicted
+        while (ATOMIC_LOAD_ACQUIRE(&stripe->entries[stripe->clockHand].referenced))
+        {
+            ATOMIC_STORE_RELEASE(&stripe->entries[stripe->clockHand].referenced, 0);
+            stripe->clockHand = (stripe->clockHand + 1) % stripeCapacity;
+        }
+
+        localId = stripe->clockHand;
+        stripe->clockHand = (stripe->clockHand + 1) % stripeCapacity;
+
+        // Removing the evicted entry from the index
+        for (slot = stripe->entries[localId].hash & slotMask ; ; slot = (slot + 1) & slotMask)
+        {
+            if (stripe->slots[slot] == (long)localId + 1)
+            {
+                host_table_remove_slot(stripe, slotMask, slot);
+                break;
+            }
+        }
+    }
+
+    // Seqlock write
+    entry = &stripe->entries[localId];
+    ATOMIC_STORE_RELEASE(&entry->version, entry->version + 1);
+    ATOMIC_FENCE();
+    entry->hash = hash;
+    entry->hostLen = hostLen;
+    memcpy(entry->host, host, hostLen);
+    ATOMIC_STORE_RELEASE(&entry->version, entry->version + 1);
+    ATOMIC_STORE_RELEASE(&entry->referenced, 1);
+
+    // Indexing the new entry, there is always a free slot as there are more slots than entries
+    for (slot = hash & slotMask ; ; slot = (slot + 1) & slotMask)
+    {
+        if (stripe->slots[slot] == HOST_TABLE_EMPTY_SLOT)
+        {
+            ATOMIC_STORE_RELEASE(&stripe->slots[slot], (long)localId + 1);
+            break;
+        }
+    }
+
+    return (long)localId;
+}
+
+static curi_status host_table_intern(curi_host_table* table, const char* host, size_t hostLen, unsigned int* hostId, char* canonicalHost)
+{
+    unsigned long hash = 2166136261UL;
+    size_t stripeIndex;
+    host_table_stripe* stripe;
+    long localId;
+    size_t i;
+
+    if (hostLen == 0 || hostLen > CURI_HOST_TABLE_MAX_HOST_LENGTH)
+        return curi_status_error;
+
+    // Lowercasing and hashing (FNV-1a) in the same pass
+    for (i = 0 ; i < hostLen ; ++i)
+    {
+        canonicalHost[i] = to_lower_ascii(host[i]);
+        hash = ((hash ^ (unsigned char)canonicalHost[i]) * 16777619UL) & 0xFFFFFFFFUL;
+    }
+
+    stripeIndex = (hash >> 24) % HOST_TABLE_STRIPE_COUNT;
+    stripe = &table->stripes[stripeIndex];
+
+    localId = host_table_find(stripe, table->slotMask, hash, canonicalHost, hostLen);
+
+    if (localId < 0)
+    {
+        while (!ATOMIC_TRY_LOCK(&stripe->lock))
+            ;
+
+        // Another writer might have inserted it in the meantime
+        localId = host_table_find(stripe, table->slotMask, hash, canonicalHost, hostLen);
+        if (localId < 0)
+            localId = host_table_insert(stripe, table->stripeCapacity, table->slotMask, hash, canonicalHost, hostLen);
+
+        ATOMIC_STORE_RELEASE(&stripe->lock, 0);
+    }
+    else if (!stripe->entries[localId].referenced)
+    {
+        ATOMIC_STORE_RELEASE(&stripe->entries[localId].referenced, 1);
+    }
+
+    *hostId = (unsigned int)(stripeIndex * table->stripeCapacity + (size_t)localId);
+    return curi_status_success;
+}
+
+curi_status curi_host_table_intern(curi_host_table* table, const char* host, size_t hostLen, unsigned int* hostId)
+{
+    char canonicalHost[CURI_HOST_TABLE_MAX_HOST_LENGTH];
+    return host_table_intern(table, host, bounded_strlen(host, hostLen), hostId, canonicalHost);
+}
+
+curi_status curi_host_table_get(const curi_host_table* table, unsigned int hostId, char* output, size_t outputCapacity, size_t* outputLen /*=0*/)
+{
+    const size_t stripeIndex = hostId / table->stripeCapacity;
+    char host[CURI_HOST_TABLE_MAX_HOST_LENGTH];
+    unsigned long hash;
+    size_t hostLen;
+
+    if (stripeIndex >= HOST_TABLE_STRIPE_COUNT)
+        return curi_status_error;
+
+    hostLen = host_table_entry_read(&table->stripes[stripeIndex].entries[hostId % table->stripeCapacity], &hash, host);
+
+    if (hostLen == 0 || hostLen > outputCapacity)
+        return curi_status_error;
+
+    memcpy(output, host, hostLen);
+    if (outputLen)
+        *outputLen = hostLen;
+
+    return curi_status_success;
+}
+
+#define PSL_RULE 1
+#define PSL_EXCEPTION 2
+
+typedef struct
+{
+    const char* label;
+    size_t labelLen;
+    size_t firstChild; // children are contiguous and sorted by label
+    size_t childCount;
+    int flags;
+} psl_node;
+
+struct curi_public_suffix_list
+{
+    void (*deallocate)(void* userData, void* ptr, size_t size);
+    void* userData;
+    size_t allocationSize;
+    size_t nodeCount;
+    psl_node nodes[1]; // followed by the labels
+};
+
+typedef struct
+{
+    size_t labelOffset;
+    size_t labelLen;
+    size_t firstChild; // index + 1, 0 if none
+    size_t nextSibling; // index + 1, 0 if none
+    int flags;
+} psl_build_node;
+
+static int psl_compare_labels(const char* label1, size_t label1Len, const char* label2, size_t label2Len)
+{
+    // Case insensitive, the labels of the list being lowercase
+    size_t i;
+
+    for (i = 0 ; i < label1Len && i < label2Len ; ++i)
+    {
+        const unsigned char c1 = (unsigned char)to_lower_ascii(label1[i]);
+        const unsigned char c2 = (unsigned char)to_lower_ascii(label2[i]);
+        if (c1 != c2)
+            return c1 < c2 ? -1 : 1;
+    }
+
+    if (label1Len == label2Len)
+        return 0;
+    else
+        return label1Len < label2Len ? -1 : 1;
+}
+
+static int psl_compare_nodes(const void* node1, const void* node2)
+{
+    return psl_compare_labels(((const psl_node*)node1)->label, ((const psl_node*)node1)->labelLen, ((const psl_node*)node2)->label, ((const psl_node*)node2)->labelLen);
+}
+
+static int psl_add_rule(psl_build_node* nodes, size_t* nodeCount, const char* labels, const char* rule, size_t ruleLen, int flags)
+{
+    // Inserting the labels of the rule, from the rightmost one, returns 0 for malformed rules
+    size_t node = 0;
+    size_t labelEnd = ruleLen;
+
+    if (ruleLen == 0)
+        return 0;
+
+    while (labelEnd > 0)
+    {
+        size_t labelStart = labelEnd;
+        size_t child;
+
+        while (labelStart > 0 && rule[labelStart - 1] != '.')
+            --labelStart;
+
+        if (labelStart == labelEnd || (labelStart == 1 && rule[0] == '.'))
+            return 0; // Empty label
+
+        for (child = nodes[node].firstChild ; child != 0 ; child = nodes[child - 1].nextSibling)
+            if (psl_compare_labels(labels + nodes[child - 1].labelOffset, nodes[child - 1].labelLen, rule + labelStart, labelEnd - labelStart) == 0)
+                break;
+
+        if (child == 0)
+        {
+            psl_build_node* newNode = &nodes[*nodeCount];
+            newNode->labelOffset = (size_t)(rule + labelStart - labels);
+            newNode->labelLen = labelEnd - labelStart;
+            newNode->firstChild = 0;
+            newNode->nextSibling = nodes[node].firstChild;
+            newNode->flags = 0;
+            child = ++(*nodeCount);
+            nodes[node].firstChild = child;
+        }
+
+        node = child - 1;
+        labelEnd = labelStart > 0 ? labelStart - 1 : 0;
+    }
+
+    nodes[node].flags |= flags;
+    return 1;
+}
+
+curi_public_suffix_list* curi_public_suffix_list_create(const char* list, size_t listLen, const curi_settings* settings /*= 0*/, void* userData /*= 0*/)
+{
+    void* (*allocate)(void* userData, size_t size) = settings ? settings->allocate : default_allocate;
+    void (*deallocate)(void* userData, void* ptr, size_t size) = settings ? settings->deallocate : default_deallocate;
+    curi_public_suffix_list* publicSuffixList = 0;
+    psl_build_node* buildNodes;
+    size_t buildNodesCapacity = 1;
+    size_t nodeCount = 1;
+    size_t labelsLen = 0;
+    char* labels;
+    size_t offset;
+    int valid = 1;
+
+    listLen = bounded_strlen(list, listLen);
+
+    // Each label is followed by a dot or a line end
+    for (offset = 0 ; offset < listLen ; ++offset)
+        if (list[offset] == '.' || list[offset] == '\n')
+            ++buildNodesCapacity;
+    ++buildNodesCapacity;
+
+    buildNodes = (psl_build_node*)allocate(userData, buildNodesCapacity * sizeof(psl_build_node));
+    labels = (char*)allocate(userData, listLen + 1);
+    if (!buildNodes || !labels)
+    {
+        if (buildNodes)
+            deallocate(userData, buildNodes, buildNodesCapacity * sizeof(psl_build_node));
+        if (labels)
+            deallocate(userData, labels, listLen + 1);
+        return 0;
+    }
+
+    buildNodes[0].labelOffset = 0;
+    buildNodes[0].labelLen = 0;
+    buildNodes[0].firstChild = 0;
+    buildNodes[0].nextSibling = 0;
+    buildNodes[0].flags = 0;
+
+    // Lines are made of a rule followed by whitespaces, comments start with "//"
+    offset = 0;
+    while (valid && offset < listLen)
+    {
+        size_t ruleStart = offset;
+        size_t ruleEnd;
+        int flags = PSL_RULE;
+
+        while (offset < listLen && list[offset] != '\n')
+            ++offset;
+
+        for (ruleEnd = ruleStart ; ruleEnd < offset && list[ruleEnd] != ' ' && list[ruleEnd] != '\t' && list[ruleEnd] != '\r' ; ++ruleEnd)
+            ;
+
+        ++offset;
+
+        if (ruleEnd == ruleStart || (ruleEnd - ruleStart >= 2 && list[ruleStart] == '/' && list[ruleStart + 1] == '/'))
+            continue;
+
+        if (list[ruleStart] == '!')
+        {
+            flags = PSL_EXCEPTION;
+            ++ruleStart;
+        }
+
+        memcpy(labels + labelsLen, list + ruleStart, ruleEnd - ruleStart);
+        valid = psl_add_rule(buildNodes, &nodeCount, labels, labels + labelsLen, ruleEnd - ruleStart, flags);
+        labelsLen += ruleEnd - ruleStart;
+    }
+
+    if (valid)
+    {
+        const size_t allocationSize = sizeof(curi_public_suffix_list) + (nodeCount - 1) * sizeof(psl_node) + labelsLen;
+        publicSuffixList = (curi_public_suffix_list*)allocate(userData, allocationSize);
+
+        if (publicSuffixList)
+        {
+            char* finalLabels = (char*)(publicSuffixList->nodes + nodeCount);
+            psl_node* nodes = publicSuffixList->nodes;
+            size_t finalNodeCount = 1;
+            size_t i;
+
+            publicSuffixList->deallocate = deallocate;
+            publicSuffixList->userData = userData;
+            publicSuffixList->allocationSize = allocationSize;
+            publicSuffixList->nodeCount = nodeCount;
+
+            for (i = 0 ; i < labelsLen ; ++i)
+                finalLabels[i] = to_lower_ascii(labels[i]);
+
+            // Laying out nodes breadth first, firstChild temporarily storing the build node index
+            nodes[0].label = finalLabels;
+            nodes[0].labelLen = 0;
+            nodes[0].flags = 0;
+            nodes[0].firstChild = 0;
+            for (i = 0 ; i < finalNodeCount ; ++i)
+            {
+                size_t child = buildNodes[nodes[i].firstChild].firstChild;
+
+                nodes[i].firstChild = finalNodeCount;
+                for ( ; child != 0 ; child = buildNodes[child - 1].nextSibling)
+                {
+                    psl_node* node = &nodes[finalNodeCount++];
+                    node->label = finalLabels + buildNodes[child - 1].labelOffset;
+                    node->labelLen = buildNodes[child - 1].labelLen;
+                    node->flags = buildNodes[child - 1].flags;
+                    node->firstChild = child - 1;
+                    node->childCount = 0;
+                }
+                nodes[i].childCount = finalNodeCount - nodes[i].firstChild;
+
+                qsort(&nodes[nodes[i].firstChild], nodes[i].childCount, sizeof(psl_node), psl_compare_nodes);
+            }
+        }
+    }
+
+    deallocate(userData, buildNodes, buildNodesCapacity * sizeof(psl_build_node));
+    deallocate(userData, labels, listLen + 1);
+
+    return publicSuffixList;
+}
+
+void curi_public_suffix_list_destroy(curi_public_suffix_list* publicSuffixList)
+{
+    if (publicSuffixList)
+        publicSuffixList->deallocate(publicSuffixList->userData, publicSuffixList, publicSuffixList->allocationSize);
+}
+
+static const psl_node* psl_find_child(const curi_public_suffix_list* publicSuffixList, const psl_node* node, const char* label, size_t labelLen)
+{
+    const psl_node* children = &publicSuffixList->nodes[node->firstChild];
+    size_t first = 0;
+    size_t last = node->childCount;
+
+    while (first < last)
+    {
+        const size_t middle = first + (last - first) / 2;
+        const int comparison = psl_compare_labels(label, labelLen, children[middle].label, children[middle].labelLen);
+
+        if (comparison == 0)
+            return &children[middle];
+        else if (comparison < 0)
+            last = middle;
+        else
+            first = middle + 1;
+    }
+
+    return 0;
+}
+
+curi_status curi_registrable_domain(const curi_public_suffix_list* publicSuffixList, const char* host, size_t hostLen, size_t* domainOffset, size_t* domainLen /*=0*/)
+{
+    const psl_node* node = publicSuffixList->nodes;
+    size_t suffixLabelCount = 1; // The implicit "*" rule
+    size_t labelCount = 0;
+    size_t labelStart;
+    size_t labelEnd;
+    int matching = 1;
+
+    hostLen = bounded_strlen(host, hostLen);
+
+    // Ignoring the trailing dot of absolute domain names
+    if (hostLen > 0 && host[hostLen - 1] == '.')
+        --hostLen;
+
+    if (hostLen == 0)
+        return curi_status_error;
+
+    // Walking the labels from the rightmost one, down the trie while rules match
+    for (labelEnd = hostLen ; matching ; labelEnd = labelStart - 1)
+    {
+        const psl_node* child;
+        const psl_node* wildcard;
+
+        for (labelStart = labelEnd ; labelStart > 0 && host[labelStart - 1] != '.' ; --labelStart)
+            ;
+
+        if (labelStart == labelEnd)
+            return curi_status_error;
+
+        ++labelCount;
+        child = psl_find_child(publicSuffixList, node, host + labelStart, labelEnd - labelStart);
+        wildcard = psl_find_child(publicSuffixList, node, "*", 1);
+
+        if (child && (child->flags & PSL_EXCEPTION))
+        {
+            suffixLabelCount = labelCount - 1;
+            break;
+        }
+
+        if ((child && (child->flags & PSL_RULE)) || (wildcard && (wildcard->flags & PSL_RULE)))
+            suffixLabelCount = labelCount;
+
+        node = child;
+        matching = child != 0 && labelStart > 0;
+    }
+
+    // The registrable domain is the public suffix plus one label
+    labelCount = 0;
+    for (labelEnd = hostLen ; ; labelEnd = labelStart - 1)
+    {
+        for (labelStart = labelEnd ; labelStart > 0 && host[labelStart - 1] != '.' ; --labelStart)
+            ;
+
+        if (labelStart == labelEnd)
+            return curi_status_error;
+
+        if (++labelCount == suffixLabelCount + 1)
+        {
+            *domainOffset = labelStart;
+            if (domainLen)
+                *domainLen = hostLen - labelStart;
+            return curi_status_success;
+        }
+
+        if (labelStart == 0)
+            return curi_status_error;
+    }
+}
+
+typedef struct
+{
+    size_t labelOffset;
+    size_t labelLen;
+    size_t firstChild; // index + 1, 0 if none
+    size_t nextSibling; // index + 1, 0 if none
+    size_t paramChild; // index + 1, 0 if none
+} router_build_node;
+
+typedef struct
+{
+    const char* label;
+    size_t labelLen;
+    size_t firstChild; // static children are contiguous and sorted by label
+    size_t childCount;
+    size_t paramChild; // index + 1, 0 if none
+    size_t firstRoute;
+    size_t routeCount;
+    size_t firstWildcardRoute;
+    size_t wildcardRouteCount;
+} router_node;
+
+struct curi_router
+{
+    void (*deallocate)(void* userData, void* ptr, size_t size);
+    void* userData;
+    size_t allocationSize;
+    router_node* nodes;
+    size_t* routes; // route IDs grouped by node, the ones ending with a wildcard after the others
+    unsigned int* routeMethods;
+};
+
+static int router_compare_labels(const char* label1, size_t label1Len, const char* label2, size_t label2Len)
+{
+    const int comparison = memcmp(label1, label2, label1Len < label2Len ? label1Len : label2Len);
+
+    if (comparison != 0 || label1Len == label2Len)
+        return comparison;
+    else
+        return label1Len < label2Len ? -1 : 1;
+}
+
+static int router_compare_nodes(const void* node1, const void* node2)
+{
+    return router_compare_labels(((const router_node*)node1)->label, ((const router_node*)node1)->labelLen, ((const router_node*)node2)->label, ((const router_node*)node2)->labelLen);
+}
+
+static int router_add_route(router_build_node* nodes, size_t* nodeCount, const char* labels, const char* route, size_t routeLen, size_t* routeNode, int* isWildcard)
+{
+    // Inserting the segments of the route, returns 0 for malformed routes
+    size_t node = 0;
+    size_t captureCount = 0;
+    size_t segmentCount = 0;
+    size_t segmentStart = 0;
+
+    *isWildcard = 0;
+
+    while (segmentStart < routeLen)
+    {
+        size_t segmentEnd = segmentStart;
+        size_t child;
+
+        while (segmentEnd < routeLen && route[segmentEnd] != '/')
+            ++segmentEnd;
+
+        if (segmentEnd == segmentStart)
+        {
+            // Empty segments are ignored, like while parsing
+        }
+        else if (*isWildcard || ++segmentCount > CURI_ROUTE_MAX_SEGMENTS)
+        {
+            return 0;
+        }
+        else if (segmentEnd - segmentStart == 1 && route[segmentStart] == '*')
+        {
+            *isWildcard = 1;
+            if (++captureCount > CURI_ROUTE_MAX_CAPTURES)
+                return 0;
+        }
+        else if (segmentEnd - segmentStart >= 2 && route[segmentStart] == '{' && route[segmentEnd - 1] == '}')
+        {
+            if (++captureCount > CURI_ROUTE_MAX_CAPTURES)
+                return 0;
+
+            if (nodes[node].paramChild == 0)
+            {
+                router_build_node* newNode = &nodes[*nodeCount];
+                newNode->labelOffset = 0;
+                newNode->labelLen = 0;
+                newNode->firstChild = 0;
+                newNode->nextSibling = 0;
+                newNode->paramChild = 0;
+                nodes[node].paramChild = ++(*nodeCount);
+            }
+            node = nodes[node].paramChild - 1;
+        }
+        else
+        {
+            for (child = nodes[node].firstChild ; child != 0 ; child = nodes[child - 1].nextSibling)
+                if (router_compare_labels(labels + nodes[child - 1].labelOffset, nodes[child - 1].labelLen, route + segmentStart, segmentEnd - segmentStart) == 0)
+                    break;
+
+            if (child == 0)
+            {
+                router_build_node* newNode = &nodes[*nodeCount];
+                newNode->labelOffset = (size_t)(route + segmentStart - labels);
+                newNode->labelLen = segmentEnd - segmentStart;
+                newNode->firstChild = 0;
+                newNode->nextSibling = nodes[node].firstChild;
+                newNode->paramChild = 0;
+                child = ++(*nodeCount);
+                nodes[node].firstChild = child;
+            }
+            node = child - 1;
+        }
+
+        segmentStart = segmentEnd + 1;
+    }
+
+    *routeNode = node;
+    return 1;
+}
+
+curi_router* curi_router_create(const char* const* routes, const unsigned int* routeMethods /*= 0*/, size_t routeCount, const curi_settings* settings /*= 0*/, void* userData /*= 0*/)
+{
+    void* (*allocate)(void* userData, size_t size) = settings ? settings->allocate : default_allocate;
+    void (*deallocate)(void* userData, void* ptr, size_t size) = settings ? settings->deallocate : default_deallocate;
+    curi_router* router = 0;
+    router_build_node* buildNodes;
+    size_t buildNodesCapacity = 1;
+    size_t* routeNodes;
+    int* routeIsWildcard;
+    size_t nodeCount = 1;
+    size_t labelsCapacity = 0;
+    size_t labelsLen = 0;
+    char* labels;
+    size_t i;
+    int valid = 1;
+
+    // Each segment is followed by a '/' or the end of the route
+    for (i = 0 ; i < routeCount ; ++i)
+    {
+        const char* route = routes[i];
+        for ( ; *route != '\0' ; ++route, ++labelsCapacity)
+            if (*route == '/')
+                ++buildNodesCapacity;
+        ++buildNodesCapacity;
+    }
+
+    buildNodes = (router_build_node*)allocate(userData, buildNodesCapacity * sizeof(router_build_node));
+    routeNodes = (size_t*)allocate(userData, (routeCount + 1) * sizeof(size_t));
+    routeIsWildcard = (int*)allocate(userData, (routeCount + 1) * sizeof(int));
+    labels = (char*)allocate(userData, labelsCapacity + 1);
+
+    if (!buildNodes || !routeNodes || !routeIsWildcard || !labels)
+        valid = 0;
+    else
+    {
+        buildNodes[0].labelOffset = 0;
+        buildNodes[0].labelLen = 0;
+        buildNodes[0].firstChild = 0;
+        buildNodes[0].nextSibling = 0;
+        buildNodes[0].paramChild = 0;
+    }
+
+    for (i = 0 ; valid && i < routeCount ; ++i)
+    {
+        const size_t routeLen = strlen(routes[i]);
+        memcpy(labels + labelsLen, routes[i], routeLen);
+        valid = router_add_route(buildNodes, &nodeCount, labels, labels + labelsLen, routeLen, &routeNodes[i], &routeIsWildcard[i]);
+        labelsLen += routeLen;
+    }
+
+    if (valid)
+    {
+        const size_t allocationSize = sizeof(curi_router) + nodeCount * sizeof(router_node) + routeCount * (sizeof(size_t) + sizeof(unsigned int)) + labelsLen;
+        router = (curi_router*)allocate(userData, allocationSize);
+
+        if (router)
+        {
+            router_node* nodes = (router_node*)(router + 1);
+            size_t finalNodeCount = 1;
+            size_t routeOffset = 0;
+            char* finalLabels;
+
+            router->deallocate = deallocate;
+            router->userData = userData;
+            router->allocationSize = allocationSize;
+            router->nodes = nodes;
+            router->routes = (size_t*)(nodes + nodeCount);
+            router->routeMethods = (unsigned int*)(router->routes + routeCount);
+            finalLabels = (char*)(router->routeMethods + routeCount);
+            memcpy(finalLabels, labels, labelsLen);
+
+            // Laying out nodes breadth first, firstRoute temporarily storing the build node index
+            nodes[0].label = finalLabels;
+            nodes[0].labelLen = 0;
+            nodes[0].firstRoute = 0;
+            for (i = 0 ; i < finalNodeCount ; ++i)
+            {
+                const size_t buildNode = nodes[i].firstRoute;
+                size_t child;
+
+                nodes[i].firstChild = finalNodeCount;
+                for (child = buildNodes[buildNode].firstChild ; child != 0 ; child = buildNodes[child - 1].nextSibling)
+                {
+                    router_node* node = &nodes[finalNodeCount++];
+                    node->label = finalLabels + buildNodes[child - 1].labelOffset;
+                    node->labelLen = buildNodes[child - 1].labelLen;
+                    node->firstRoute = child - 1;
+                }
+                nodes[i].childCount = finalNodeCount - nodes[i].firstChild;
+                qsort(&nodes[nodes[i].firstChild], nodes[i].childCount, sizeof(router_node), router_compare_nodes);
+
+                nodes[i].paramChild = 0;
+                if (buildNodes[buildNode].paramChild != 0)
+                {
+                    router_node* node = &nodes[finalNodeCount++];
+                    node->label = finalLabels;
+                    node->labelLen = 0;
+                    node->firstRoute = buildNodes[buildNode].paramChild - 1;
+                    nodes[i].paramChild = finalNodeCount;
+                }
+
+                // The build node isn't needed anymore, its next sibling now maps it to the final node
+                buildNodes[buildNode].nextSibling = i;
+                nodes[i].routeCount = 0;
+                nodes[i].wildcardRouteCount = 0;
+            }
+
+            for (i = 0 ; i < routeCount ; ++i)
+            {
+                router_node* node = &nodes[buildNodes[routeNodes[i]].nextSibling];
+                if (routeIsWildcard[i])
+                    ++node->wildcardRouteCount;
+                else
+                    ++node->routeCount;
+                router->routeMethods[i] = routeMethods ? routeMethods[i] : ~0u;
+            }
+
+            for (i = 0 ; i < nodeCount ; ++i)
+            {
+                nodes[i].firstRoute = routeOffset;
+                routeOffset += nodes[i].routeCount;
+                nodes[i].firstWildcardRoute = routeOffset;
+                routeOffset += nodes[i].wildcardRouteCount;
+                nodes[i].routeCount = 0;
+                nodes[i].wildcardRouteCount = 0;
+            }
+
+            // Routes of a node are sorted by ID, earlier routes having priority
+            for (i = 0 ; i < routeCount ; ++i)
+            {
+                router_node* node = &nodes[buildNodes[routeNodes[i]].nextSibling];
+                if (routeIsWildcard[i])
+                    router->routes[node->firstWildcardRoute + node->wildcardRouteCount++] = i;
+                else
+                    router->routes[node->firstRoute + node->routeCount++] = i;
+            }
+        }
+    }
+
+    if (buildNodes)
+        deallocate(userData, buildNodes, buildNodesCapacity * sizeof(router_build_node));
+    if (routeNodes)
+        deallocate(userData, routeNodes, (routeCount + 1) * sizeof(size_t));
+    if (routeIsWildcard)
+        deallocate(userData, routeIsWildcard, (routeCount + 1) * sizeof(int));
+    if (labels)
+        deallocate(userData, labels, labelsCapacity + 1);
+
+    return router;
+}
+
+void curi_router_destroy(curi_router* router)
+{
+    if (router)
+        router->deallocate(router->userData, router, router->allocationSize);
+}
+
+void curi_route_match_init(curi_route_match* match, const curi_router* router, unsigned int methods)
+{
+    match->router = router;
+    match->methods = methods;
+    match->segmentCount = 0;
+    match->captureCount = 0;
+    match->allowedMethods = 0;
+}
+
+int curi_route_match_segment(void* match, const char* segment, size_t segmentLen)
+{
+    curi_route_match* routeMatch = (curi_route_match*)match;
+
+    // Segments beyond the maximum are counted, making the match fail
+    if (routeMatch->segmentCount < CURI_ROUTE_MAX_SEGMENTS)
+    {
+        routeMatch->segments[routeMatch->segmentCount].str = segment;
+        routeMatch->segments[routeMatch->segmentCount].len = segmentLen;
+    }
+    ++routeMatch->segmentCount;
+
+    return 1;
+}
+
+static const router_node* router_find_child(const curi_router* router, const router_node* node, const char* label, size_t labelLen)
+{
+    const router_node* children = &router->nodes[node->firstChild];
+    size_t first = 0;
+    size_t last = node->childCount;
+
+    while (first < last)
+    {
+        const size_t middle = first + (last - first) / 2;
+        const int comparison = router_compare_labels(label, labelLen, children[middle].label, children[middle].labelLen);
+
+        if (comparison == 0)
+            return &children[middle];
+        else if (comparison < 0)
+            last = middle;
+        else
+            first = middle + 1;
+    }
+
+    return 0;
+}
+
+static int router_match_routes(const curi_router* router, size_t firstRoute, size_t routeCount, curi_route_match* match, size_t* routeId)
+{
+    size_t i;
+
+    for (i = firstRoute ; i < firstRoute + routeCount ; ++i)
+    {
+        const size_t route = router->routes[i];
+
+        if (router->routeMethods[route] & match->methods)
+        {
+            *routeId = route;
+            return 1;
+        }
+
+        match->allowedMethods |= router->routeMethods[route];
+    }
+
+    return 0;
+}
+
+static int router_match(const curi_router* router, const router_node* node, curi_route_match* match, size_t segmentIndex, size_t* routeId)
+{
+    // Depth first, static segments having priority over parameters, themselves having priority over wildcards
+    if (segmentIndex == match->segmentCount)
+    {
+        if (router_match_routes(router, node->firstRoute, node->routeCount, match, routeId))
+            return 1;
+    }
+    else
+    {
+        const router_node* child = router_find_child(router, node, match->segments[segmentIndex].str, match->segments[segmentIndex].len);
+
+        if (child && router_match(router, child, match, segmentIndex + 1, routeId))
+            return 1;
+
+        if (node->paramChild != 0)
+        {
+            match->captures[match->captureCount++] = match->segments[segmentIndex];
+            if (router_match(router, &router->nodes[node->paramChild - 1], match, segmentIndex + 1, routeId))
+                return 1;
+            --match->captureCount;
+        }
+    }
+
+    if (node->wildcardRouteCount > 0)
+    {
+        // Capturing the remaining segments, possibly none
+        curi_route_capture* capture = &match->captures[match->captureCount++];
+
+        if (segmentIndex < match->segmentCount)
+        {
+            const curi_route_capture* lastSegment = &match->segments[match->segmentCount - 1];
+            capture->str = match->segments[segmentIndex].str;
+            capture->len = (size_t)(lastSegment->str + lastSegment->len - capture->str);
+        }
+        else
+        {
+            capture->str = 0;
+            capture->len = 0;
+        }
+
+        if (router_match_routes(router, node->firstWildcardRoute, node->wildcardRouteCount, match, routeId))
+            return 1;
+        --match->captureCount;
+    }
+
+    return 0;
+}
+
+curi_status curi_route_match_end(curi_route_match* match, size_t* routeId)
+{
+    if (match->segmentCount > CURI_ROUTE_MAX_SEGMENTS)
+        return curi_status_limit_exceeded;
+
+    match->captureCount = 0;
+    match->allowedMethods = 0;
+
+    if (router_match(match->router, match->router->nodes, match, 0, routeId))
+        return curi_status_success;
+    else
+        return curi_status_error;
+}
+
+curi_status curi_route_path(const curi_router* router, const char* path, size_t pathLen, unsigned int methods, curi_route_match* match, size_t* routeId)
+{
+    curi_settings settings;
+    curi_status status;
+
+    curi_default_settings(&settings);
+    settings.path_segment_callback = curi_route_match_segment;
+
+    curi_route_match_init(match, router, methods);
+
+    status = curi_parse_path(path, pathLen, &settings, match);
+
+    if (status == curi_status_success)
+        status = curi_route_match_end(match, routeId);
 
     return status;
 }
 
-
-curi_status curi_parse_path_nt(const char* path, const curi_settings* settings /*= 0*/, void* userData /*= 0*/)
+typedef struct
 {
-    return curi_parse_path(path, SIZE_MAX, settings, userData);
+    size_t parent;
+    size_t labelOffset;
+    size_t labelLen;
+    size_t firstChild; // index + 1, 0 if none
+    size_t nextSibling; // index + 1, 0 if none
+    size_t pathRoot; // index + 1 of the root of the path trie of host nodes, 0 if none
+} url_matcher_build_node;
+
+typedef struct
+{
+    url_matcher_build_node* nodes;
+    size_t nodeCount;
+    size_t* slots; // hash index of the nodes by parent and label, storing their index + 1
+    size_t slotMask;
+    const char* labels;
+} url_matcher_builder;
+
+typedef struct
+{
+    const char* label;
+    size_t labelLen;
+    size_t firstChild; // children are contiguous and sorted by label
+    size_t childCount;
+    size_t pathRoot; // index + 1 of the root of the path trie of host nodes, 0 if none
+    size_t firstRule;
+    size_t ruleCount;
+} url_matcher_node;
+
+struct curi_url_matcher
+{
+    void (*deallocate)(void* userData, void* ptr, size_t size);
+    void* userData;
+    size_t allocationSize;
+    url_matcher_node* nodes;
+    size_t* rules; // rule IDs grouped by path node
+};
+
+static unsigned long url_matcher_hash(size_t parent, const char* label, size_t labelLen)
+{
+    // FNV-1a
+    unsigned long hash = (2166136261UL ^ (unsigned long)parent) * 16777619UL;
+    size_t i;
+
+    for (i = 0 ; i < labelLen ; ++i)
+        hash = (hash ^ (unsigned char)label[i]) * 16777619UL;
+
+    return hash;
 }
 
-curi_status curi_parse_query(const char* query, size_t len, const curi_settings* settings /*= 0*/, void* userData /*= 0*/)
+static size_t url_matcher_add_node(url_matcher_builder* builder, size_t parent, size_t labelOffset, size_t labelLen)
 {
-    size_t offset = 0;
-    curi_status status;
+    // Returns the index of the child of parent having the given label, creating it if needed
+    const char* label = builder->labels + labelOffset;
+    size_t slot = url_matcher_hash(parent, label, labelLen) & builder->slotMask;
+    url_matcher_build_node* node;
 
-    if (settings)
+    for ( ; builder->slots[slot] != 0 ; slot = (slot + 1) & builder->slotMask)
     {
-        // parsing with the given settings
-        status = parse_query(query, len, &offset, settings, userData, 0);
+        node = &builder->nodes[builder->slots[slot] - 1];
+        if (node->parent == parent && node->labelLen == labelLen && memcmp(builder->labels + node->labelOffset, label, labelLen) == 0)
+            return builder->slots[slot] - 1;
     }
-    else
+
+    node = &builder->nodes[builder->nodeCount];
+    node->parent = parent;
+    node->labelOffset = labelOffset;
+    node->labelLen = labelLen;
+    node->firstChild = 0;
+    node->nextSibling = builder->nodes[parent].firstChild;
+    node->pathRoot = 0;
+    builder->nodes[parent].firstChild = ++builder->nodeCount;
+    builder->slots[slot] = builder->nodeCount;
+
+    return builder->nodeCount - 1;
+}
+
+static size_t url_matcher_add_path_root(url_matcher_builder* builder, size_t hostNode)
+{
+    if (builder->nodes[hostNode].pathRoot == 0)
     {
-        curi_settings defaultSettings;
-        curi_default_settings(&defaultSettings);
-        // parsing with default settings
-        status = parse_query(query, len, &offset, &defaultSettings, userData, 0);
+        url_matcher_build_node* node = &builder->nodes[builder->nodeCount];
+        node->parent = hostNode;
+        node->labelOffset = 0;
+        node->labelLen = 0;
+        node->firstChild = 0;
+        node->nextSibling = 0;
+        node->pathRoot = 0;
+        builder->nodes[hostNode].pathRoot = ++builder->nodeCount;
     }
 
-    if (status == curi_status_success && *read_char(query, len, &offset) != '\0')
-        // the imput weren't fully consumed
-        // TODO: set an error string somewhere
-        status = curi_status_error;
+    return builder->nodes[hostNode].pathRoot - 1;
+}
 
-    return status;
+static int url_matcher_add_rule(url_matcher_builder* builder, size_t hostOffset, size_t hostLen, size_t pathOffset, size_t pathLen, size_t* ruleNode)
+{
+    // Inserting the labels of the host suffix, from the rightmost one, then the characters of the path prefix
+    const char* host = builder->labels + hostOffset;
+    size_t node = 0;
+    size_t labelEnd = hostLen;
+    size_t i;
+
+    if (hostLen > 0 && host[hostLen - 1] == '.')
+        --labelEnd;
+
+    while (labelEnd > 0)
+    {
+        size_t labelStart = labelEnd;
+
+        while (labelStart > 0 && host[labelStart - 1] != '.')
+            --labelStart;
+
+        if (labelStart == labelEnd || (labelStart == 1 && host[0] == '.'))
+            return 0; // Empty label
+
+        node = url_matcher_add_node(builder, node, hostOffset + labelStart, labelEnd - labelStart);
+        labelEnd = labelStart > 0 ? labelStart - 1 : 0;
+    }
+
+    node = url_matcher_add_path_root(builder, node);
+
+    for (i = 0 ; i < pathLen ; ++i)
+        node = url_matcher_add_node(builder, node, pathOffset + i, 1);
+
+    *ruleNode = node;
+    return 1;
 }
 
-curi_status curi_parse_query_nt(const char* query, const curi_settings* settings /*= 0*/, void* userData /*= 0*/)
+static int url_matcher_compare_nodes(const void* node1, const void* node2)
 {
-    return curi_parse_query(query, SIZE_MAX, settings, userData);
+    return router_compare_labels(((const url_matcher_node*)node1)->label, ((const url_matcher_node*)node1)->labelLen, ((const url_matcher_node*)node2)->label, ((const url_matcher_node*)node2)->labelLen);
 }
 
-curi_status curi_url_decode(const char* input, size_t inputLen, char* output, size_t outputCapacity, size_t* outputLen /*=0*/)
+curi_url_matcher* curi_url_matcher_create(const curi_url_rule* rules, size_t ruleCount, const curi_settings* settings /*= 0*/, void* userData /*= 0*/)
 {
-    curi_status status = curi_status_error;
-    size_t inputOffset = 0;
-    size_t outputOffset = 0;
+    void* (*allocate)(void* userData, size_t size) = settings ? settings->allocate : default_allocate;
+    void (*deallocate)(void* userData, void* ptr, size_t size) = settings ? settings->deallocate : default_deallocate;
+    curi_url_matcher* matcher = 0;
+    url_matcher_builder builder;
+    size_t nodesCapacity = 1;
+    size_t slotCount = 1;
+    size_t labelsCapacity = 0;
+    size_t labelsLen = 0;
+    size_t* ruleNodes;
+    char* labels;
+    size_t i;
+    int valid = 1;
 
-    #define HEXTOI(x) (isdigit(x) ? x - '0' : tolower(x) - 'a' + 10)
+    // Host suffixes have at most a node per dot plus one, path prefixes a node per character plus the root
+    for (i = 0 ; i < ruleCount ; ++i)
+    {
+        const char* host = rules[i].host_suffix ? rules[i].host_suffix : "";
+        const size_t pathLen = rules[i].path_prefix ? strlen(rules[i].path_prefix) : 0;
+
+        for ( ; *host != '\0' ; ++host, ++labelsCapacity)
+            if (*host == '.')
+                ++nodesCapacity;
+        nodesCapacity += 2 + pathLen;
+        labelsCapacity += pathLen;
+    }
 
-    while ( outputOffset < outputCapacity )
+    while (slotCount < 2 * nodesCapacity)
+        slotCount *= 2;
+
+    builder.nodes = (url_matcher_build_node*)allocate(userData, nodesCapacity * sizeof(url_matcher_build_node));
+    builder.slots = (size_t*)allocate(userData, slotCount * sizeof(size_t));
+    builder.nodeCount = 1;
+    builder.slotMask = slotCount - 1;
+    ruleNodes = (size_t*)allocate(userData, (ruleCount + 1) * sizeof(size_t));
+    labels = (char*)allocate(userData, labelsCapacity + 1);
+    builder.labels = labels;
+
+    if (!builder.nodes || !builder.slots || !ruleNodes || !labels)
     {
-        status = curi_status_error;
-        if (status == curi_status_error)
-        {
-            // percent encoding
-            TRY(status, &inputOffset, parse_percent_encoded(input, inputLen, &inputOffset, 0, 0));
+        valid = 0;
+    }
+    else
+    {
+        memset(builder.slots, 0, slotCount * sizeof(size_t));
+        builder.nodes[0].parent = 0;
+        builder.nodes[0].labelOffset = 0;
+        builder.nodes[0].labelLen = 0;
+        builder.nodes[0].firstChild = 0;
+        builder.nodes[0].nextSibling = 0;
+        builder.nodes[0].pathRoot = 0;
+    }
 
-            if (status == curi_status_success)
+    for (i = 0 ; valid && i < ruleCount ; ++i)
+    {
+        const size_t hostOffset = labelsLen;
+        const char* host = rules[i].host_suffix ? rules[i].host_suffix : "";
+        const char* path = rules[i].path_prefix ? rules[i].path_prefix : "";
+        size_t hostLen;
+        size_t pathLen = strlen(path);
+
+        // Host suffixes are matched ignoring the case
+        for (hostLen = 0 ; host[hostLen] != '\0' ; ++hostLen)
+            labels[labelsLen++] = to_lower_ascii(host[hostLen]);
+        memcpy(labels + labelsLen, path, pathLen);
+        labelsLen += pathLen;
+
+        valid = url_matcher_add_rule(&builder, hostOffset, hostLen, hostOffset + hostLen, pathLen, &ruleNodes[i]);
+    }
+
+    if (valid)
+    {
+        const size_t nodeCount = builder.nodeCount;
+        const size_t allocationSize = sizeof(curi_url_matcher) + nodeCount * sizeof(url_matcher_node) + ruleCount * sizeof(size_t) + labelsLen;
+        matcher = (curi_url_matcher*)allocate(userData, allocationSize);
+
+        if (matcher)
+        {
+            url_matcher_node* nodes = (url_matcher_node*)(matcher + 1);
+            url_matcher_build_node* buildNodes = builder.nodes;
+            size_t finalNodeCount = 1;
+            size_t ruleOffset = 0;
+            char* finalLabels;
+
+            matcher->deallocate = deallocate;
+            matcher->userData = userData;
+            matcher->allocationSize = allocationSize;
+            matcher->nodes = nodes;
+            matcher->rules = (size_t*)(nodes + nodeCount);
+            finalLabels = (char*)(matcher->rules + ruleCount);
+            memcpy(finalLabels, labels, labelsLen);
+
+            // Laying out nodes breadth first, firstRule temporarily storing the build node index
+            nodes[0].label = finalLabels;
+            nodes[0].labelLen = 0;
+            nodes[0].firstRule = 0;
+            for (i = 0 ; i < finalNodeCount ; ++i)
             {
-                int encodedChar = ((HEXTOI(input[inputOffset - 2]) << 4) | HEXTOI(tolower(input[inputOffset - 1])));
-                if (encodedChar < 128) // Only support ascii percent encodage at the moment.
+                const size_t buildNode = nodes[i].firstRule;
+                size_t child;
+
+                nodes[i].firstChild = finalNodeCount;
+                for (child = buildNodes[buildNode].firstChild ; child != 0 ; child = buildNodes[child - 1].nextSibling)
                 {
-                    output[outputOffset] = (char)encodedChar;
-                    ++outputOffset;
+                    url_matcher_node* node = &nodes[finalNodeCount++];
+                    node->label = finalLabels + buildNodes[child - 1].labelOffset;
+                    node->labelLen = buildNodes[child - 1].labelLen;
+                    node->firstRule = child - 1;
                 }
-                else
+                nodes[i].childCount = finalNodeCount - nodes[i].firstChild;
+                qsort(&nodes[nodes[i].firstChild], nodes[i].childCount, sizeof(url_matcher_node), url_matcher_compare_nodes);
+
+                nodes[i].pathRoot = 0;
+                if (buildNodes[buildNode].pathRoot != 0)
                 {
-                    status = curi_status_error;
+                    url_matcher_node* node = &nodes[finalNodeCount++];
+                    node->label = finalLabels;
+                    node->labelLen = 0;
+                    node->firstRule = buildNodes[buildNode].pathRoot - 1;
+                    nodes[i].pathRoot = finalNodeCount;
                 }
-            }
-        }
 
-        if (status == curi_status_error)
-        {
-            // '+' as a space
-            TRY(status, &inputOffset, parse_char('+', input, inputLen, &inputOffset, 0, 0));
-            if (status == curi_status_success)
-            {
-                 output[outputOffset] = ' ';
-                 ++outputOffset;
+                // The build node isn't needed anymore, its next sibling now maps it to the final node
+                buildNodes[buildNode].nextSibling = i;
+                nodes[i].ruleCount = 0;
             }
-        }
 
-        if (status == curi_status_error)
-        {
-            // "any" character
-            output[outputOffset] = *read_char(input, inputLen, &inputOffset);
-            if (output[outputOffset] == '\0')
-            {
-                if (outputLen)
-                    *outputLen = outputOffset;
+            for (i = 0 ; i < ruleCount ; ++i)
+                ++nodes[buildNodes[ruleNodes[i]].nextSibling].ruleCount;
 
-                return curi_status_success;
+            for (i = 0 ; i < nodeCount ; ++i)
+            {
+                nodes[i].firstRule = ruleOffset;
+                ruleOffset += nodes[i].ruleCount;
+                nodes[i].ruleCount = 0;
             }
-            else
+
+            for (i = 0 ; i < ruleCount ; ++i)
             {
-                ++outputOffset;
+                url_matcher_node* node = &nodes[buildNodes[ruleNodes[i]].nextSibling];
+                matcher->rules[node->firstRule + node->ruleCount++] = i;
             }
         }
     }
 
-    if (*read_char(input, inputLen, &inputOffset) == '\0')
+    if (builder.nodes)
+        deallocate(userData, builder.nodes, nodesCapacity * sizeof(url_matcher_build_node));
+    if (builder.slots)
+        deallocate(userData, builder.slots, slotCount * sizeof(size_t));
+    if (ruleNodes)
+        deallocate(userData, ruleNodes, (ruleCount + 1) * sizeof(size_t));
+    if (labels)
+        deallocate(userData, labels, labelsCapacity + 1);
+
+    return matcher;
+}
+
+void curi_url_matcher_destroy(curi_url_matcher* matcher)
+{
+    if (matcher)
+        matcher->deallocate(matcher->userData, matcher, matcher->allocationSize);
+}
+
+static const url_matcher_node* url_matcher_find_child(const curi_url_matcher* matcher, const url_matcher_node* node, const char* label, size_t labelLen)
+{
+    const url_matcher_node* children = &matcher->nodes[node->firstChild];
+    size_t first = 0;
+    size_t last = node->childCount;
+
+    while (first < last)
     {
-        if (outputLen)
-            *outputLen = outputOffset;
+        const size_t middle = first + (last - first) / 2;
+        const int comparison = router_compare_labels(label, labelLen, children[middle].label, children[middle].labelLen);
+
+        if (comparison == 0)
+            return &children[middle];
+        else if (comparison < 0)
+            last = middle;
+        else
+            first = middle + 1;
+    }
+
+    return 0;
+}
+
+static curi_status url_matcher_visit_rules(const curi_url_matcher* matcher, const url_matcher_node* node, int (*visitor)(void* data, size_t ruleId), void* data)
+{
+    size_t i;
+
+    for (i = node->firstRule ; i < node->firstRule + node->ruleCount ; ++i)
+        if (visitor(data, matcher->rules[i]) == 0)
+            return curi_status_canceled;
 
+    return curi_status_success;
+}
+
+static curi_status url_matcher_visit_path(const curi_url_matcher* matcher, const url_matcher_node* hostNode, const char* path, size_t pathLen, int (*visitor)(void* data, size_t ruleId), void* data)
+{
+    // Visiting the rules of each prefix of the path, from the shortest one
+    const url_matcher_node* node;
+    curi_status status;
+    size_t i;
+
+    if (hostNode->pathRoot == 0)
         return curi_status_success;
+
+    node = &matcher->nodes[hostNode->pathRoot - 1];
+    status = url_matcher_visit_rules(matcher, node, visitor, data);
+
+    for (i = 0 ; status == curi_status_success && i < pathLen ; ++i)
+    {
+        node = url_matcher_find_child(matcher, node, path + i, 1);
+        if (!node)
+            break;
+        status = url_matcher_visit_rules(matcher, node, visitor, data);
     }
-    else
+
+    return status;
+}
+
+static curi_status url_matcher_visit(const curi_url_matcher* matcher, const char* host, size_t hostLen, const char* path, size_t pathLen, int (*visitor)(void* data, size_t ruleId), void* data)
+{
+    // Visiting the rules of each suffix of the host, from the shortest one
+    const url_matcher_node* node = matcher->nodes;
+    curi_status status = url_matcher_visit_path(matcher, node, path, pathLen, visitor, data);
+    size_t labelEnd = hostLen;
+
+    if (hostLen > 0 && host[hostLen - 1] == '.')
+        --labelEnd;
+
+    while (status == curi_status_success && labelEnd > 0)
     {
+        char label[CURI_HOST_TABLE_MAX_HOST_LENGTH];
+        size_t labelStart = labelEnd;
+        size_t i;
+
+        while (labelStart > 0 && host[labelStart - 1] != '.')
+            --labelStart;
+
+        if (labelStart == labelEnd || labelEnd - labelStart > CURI_HOST_TABLE_MAX_HOST_LENGTH)
+            break;
+
+        for (i = labelStart ; i < labelEnd ; ++i)
+            label[i - labelStart] = to_lower_ascii(host[i]);
+
+        node = url_matcher_find_child(matcher, node, label, labelEnd - labelStart);
+        if (!node)
+            break;
+
+        status = url_matcher_visit_path(matcher, node, path, pathLen, visitor, data);
+
+        if (labelStart == 0)
+            break;
+        labelEnd = labelStart - 1;
+    }
+
+    return status;
+}
+
+typedef struct
+{
+    size_t* ruleIds;
+    size_t ruleIdsCapacity;
+    size_t ruleCount;
+} url_matcher_rule_ids;
+
+static int url_matcher_collect(void* data, size_t ruleId)
+{
+    url_matcher_rule_ids* ruleIds = (url_matcher_rule_ids*)data;
+
+    if (ruleIds->ruleCount < ruleIds->ruleIdsCapacity)
+        ruleIds->ruleIds[ruleIds->ruleCount] = ruleId;
+    ++ruleIds->ruleCount;
+
+    return 1;
+}
+
+static int url_matcher_keep_first(void* data, size_t ruleId)
+{
+    size_t* firstRuleId = (size_t*)data;
+
+    if (ruleId < *firstRuleId)
+        *firstRuleId = ruleId;
+
+    return 1;
+}
+
+curi_status curi_url_matcher_match(const curi_url_matcher* matcher, const char* host, size_t hostLen, const char* path, size_t pathLen, size_t* ruleIds, size_t ruleIdsCapacity, size_t* ruleCount)
+{
+    url_matcher_rule_ids data;
+
+    data.ruleIds = ruleIds;
+    data.ruleIdsCapacity = ruleIdsCapacity;
+    data.ruleCount = 0;
+
+    url_matcher_visit(matcher, host, bounded_strlen(host, hostLen), path, bounded_strlen(path, pathLen), url_matcher_collect, &data);
+
+    *ruleCount = data.ruleCount;
+    return data.ruleCount > 0 ? curi_status_success : curi_status_error;
+}
+
+curi_status curi_url_matcher_first(const curi_url_matcher* matcher, const char* host, size_t hostLen, const char* path, size_t pathLen, size_t* ruleId)
+{
+    size_t firstRuleId = (size_t)-1;
+
+    url_matcher_visit(matcher, host, bounded_strlen(host, hostLen), path, bounded_strlen(path, pathLen), url_matcher_keep_first, &firstRuleId);
+
+    if (firstRuleId == (size_t)-1)
         return curi_status_error;
+
+    *ruleId = firstRuleId;
+    return curi_status_success;
+}
+
+#if defined(_MSC_VER)
+#   define THREAD_LOCAL __declspec(thread)
+#elif defined(__GNUC__) || defined(__clang__)
+#   define THREAD_LOCAL __thread
+#else
+#   define THREAD_LOCAL // No thread local storage, the thread arena is shared
+#endif
+
+// Allocations are aligned for the most constrained of the usual types
+typedef union
+{
+    long double longDouble;
+    double doubleValue;
+    long longValue;
+    void* pointer;
+    void (*function)(void);
+} arena_max_align;
+
+#define ARENA_ALIGNMENT sizeof(arena_max_align)
+#define ARENA_ALIGN(size) (((size) + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT)
+
+typedef struct arena_chunk
+{
+    struct arena_chunk* next;
+    size_t capacity;
+    size_t used;
+} arena_chunk;
+
+#define ARENA_CHUNK_HEADER_SIZE ARENA_ALIGN(sizeof(arena_chunk))
+
+struct curi_arena
+{
+    void* (*allocate)(void* userData, size_t size);
+    void (*deallocate)(void* userData, void* ptr, size_t size);
+    void* userData;
+    size_t chunkSize;
+    arena_chunk* first;
+    arena_chunk* current;
+    size_t usage;
+    size_t peakUsage;
+};
+
+#define ARENA_HEADER_SIZE ARENA_ALIGN(sizeof(curi_arena))
+
+static char* arena_chunk_data(arena_chunk* chunk)
+{
+    return (char*)chunk + ARENA_CHUNK_HEADER_SIZE;
+}
+
+static arena_chunk* allocate_arena_chunk(curi_arena* arena, size_t capacity)
+{
+    arena_chunk* chunk = (arena_chunk*)arena->allocate(arena->userData, ARENA_CHUNK_HEADER_SIZE + capacity);
+    if (chunk)
+    {
+        chunk->next = 0;
+        chunk->capacity = capacity;
+        chunk->used = 0;
     }
+    return chunk;
 }
 
-curi_status curi_url_decode_nt(const char* input, char* output, size_t outputCapacity, size_t* outputLen /*=0*/)
+curi_arena* curi_arena_create(size_t chunkSize, const curi_settings* settings /*= 0*/, void* userData /*= 0*/)
 {
-    return curi_url_decode(input, SIZE_MAX, output, outputCapacity, outputLen);
+    void* (*allocate)(void* userData, size_t size) = settings ? settings->allocate : default_allocate;
+    curi_arena* arena;
+
+    chunkSize = ARENA_ALIGN(chunkSize > 0 ? chunkSize : ARENA_ALIGNMENT);
+
+    arena = (curi_arena*)allocate(userData, ARENA_HEADER_SIZE);
+    if (arena)
+    {
+        arena->allocate = allocate;
+        arena->deallocate = settings ? settings->deallocate : default_deallocate;
+        arena->userData = userData;
+        arena->chunkSize = chunkSize;
+        arena->usage = 0;
+        arena->peakUsage = 0;
+        arena->first = allocate_arena_chunk(arena, chunkSize);
+        arena->current = arena->first;
+        if (!arena->first)
+        {
+            arena->deallocate(userData, arena, ARENA_HEADER_SIZE);
+            arena = 0;
+        }
+    }
+    return arena;
+}
+
+void curi_arena_destroy(curi_arena* arena)
+{
+    if (arena)
+    {
+        arena_chunk* chunk = arena->first;
+        while (chunk)
+        {
+            arena_chunk* next = chunk->next;
+            arena->deallocate(arena->userData, chunk, ARENA_CHUNK_HEADER_SIZE + chunk->capacity);
+            chunk = next;
+        }
+        arena->deallocate(arena->userData, arena, ARENA_HEADER_SIZE);
+    }
+}
+
+void curi_arena_reset(curi_arena* arena)
+{
+    arena_chunk* chunk;
+    for (chunk = arena->first ; chunk ; chunk = chunk->next)
+        chunk->used = 0;
+    arena->current = arena->first;
+    arena->usage = 0;
+}
+
+size_t curi_arena_usage(const curi_arena* arena)
+{
+    return arena->usage;
+}
+
+size_t curi_arena_peak_usage(const curi_arena* arena)
+{
+    return arena->peakUsage;
+}
+
+void* curi_arena_allocate(void* userData, size_t size)
+{
+    curi_arena* arena = (curi_arena*)userData;
+    arena_chunk* chunk = arena->current;
+    void* ptr;
+
+    if (size > (size_t)-1 - ARENA_CHUNK_HEADER_SIZE - ARENA_ALIGNMENT)
+        return 0;
+
+    size = ARENA_ALIGN(size > 0 ? size : 1);
+    if (chunk->capacity - chunk->used < size)
+    {
+        // Chunks following the current one are empty, kept by a reset
+        if (chunk->next && chunk->next->capacity >= size)
+        {
+            chunk = chunk->next;
+        }
+        else
+        {
+            arena_chunk* newChunk = allocate_arena_chunk(arena, size > arena->chunkSize ? size : arena->chunkSize);
+            if (!newChunk)
+                return 0;
+            newChunk->next = chunk->next;
+            chunk->next = newChunk;
+            chunk = newChunk;
+        }
+        arena->current = chunk;
+    }
+
+    ptr = arena_chunk_data(chunk) + chunk->used;
+    chunk->used += size;
+    arena->usage += size;
+    if (arena->usage > arena->peakUsage)
+        arena->peakUsage = arena->usage;
+    return ptr;
+}
+
+void curi_arena_deallocate(void* userData, void* ptr, size_t size)
+{
+    curi_arena* arena = (curi_arena*)userData;
+    arena_chunk* chunk = arena->current;
+
+    size = ARENA_ALIGN(size > 0 ? size : 1);
+    if (ptr && chunk->used >= size && (char*)ptr == arena_chunk_data(chunk) + chunk->used - size)
+    {
+        chunk->used -= size;
+        arena->usage -= size;
+    }
+}
+
+static THREAD_LOCAL curi_arena* threadArena = 0;
+
+void curi_arena_set_thread_arena(curi_arena* arena)
+{
+    threadArena = arena;
+}
+
+curi_arena* curi_arena_thread_arena(void)
+{
+    return threadArena;
+}
+
+void* curi_thread_arena_allocate(void* userData, size_t size)
+{
+    return threadArena ? curi_arena_allocate(threadArena, size) : 0;
+}
+
+void curi_thread_arena_deallocate(void* userData, void* ptr, size_t size)
+{
+    if (threadArena)
+        curi_arena_deallocate(threadArena, ptr, size);
 }
 
 #ifdef _MSC_VER
@@ -38,23 +38,294 @@ typedef enum
 {
     curi_status_success = 0, //!< No error
     curi_status_canceled, //!< A callback returned 0, stopping the operation
-    curi_status_error //!< An error occured
+    curi_status_error, //!< An error occured
+    curi_status_limit_exceeded, //!< A limit set in the curi_limits was crossed, stopping the operation
+    curi_status_partial //!< All the components requested in the settings were parsed, the rest of the URI being left unchecked
 } curi_status;
 
+/** URI components, to be combined
+    \ingroup parsing
+*/
+typedef enum
+{
+    curi_component_scheme = 1, //!< The scheme
+    curi_component_userinfo = 2, //!< The userinfo
+    curi_component_host = 4, //!< The host
+    curi_component_port = 8, //!< The port
+    curi_component_path = 16, //!< The path
+    curi_component_query = 32, //!< The query
+    curi_component_fragment = 64 //!< The fragment
+} curi_component;
+
+/** Well-known schemes, see `curi_scheme_lookup`
+    \ingroup parsing
+*/
+typedef enum
+{
+    curi_scheme_unknown = 0, //!< A scheme other than the ones below
+    curi_scheme_http, //!< "http"
+    curi_scheme_https, //!< "https"
+    curi_scheme_ws, //!< "ws"
+    curi_scheme_wss //!< "wss"
+} curi_scheme_id;
+
+/** Forms of URI references
+    \ingroup parsing
+*/
+typedef enum
+{
+    curi_reference_uri = 0, //!< A full URI, starting with a scheme
+    curi_reference_network_path, //!< A relative reference starting with "//" followed by an authority
+    curi_reference_absolute_path, //!< A relative reference starting with a single "/"
+    curi_reference_relative_path //!< A relative reference starting with a path segment, or an empty path
+} curi_reference_form;
+
+/** Methods of HTTP requests
+    \ingroup request_line
+*/
+typedef enum
+{
+    curi_method_unknown = 0, //!< A method other than the ones below
+    curi_method_get, //!< "GET"
+    curi_method_head, //!< "HEAD"
+    curi_method_post, //!< "POST"
+    curi_method_put, //!< "PUT"
+    curi_method_delete, //!< "DELETE"
+    curi_method_connect, //!< "CONNECT"
+    curi_method_options, //!< "OPTIONS"
+    curi_method_trace, //!< "TRACE"
+    curi_method_patch //!< "PATCH"
+} curi_method;
+
+/** Forms of HTTP request targets (RFC-7230 section 5.3)
+    \ingroup request_line
+*/
+typedef enum
+{
+    curi_request_target_origin = 0, //!< An absolute path and an optional query, e.g. "/where?q=now"
+    curi_request_target_absolute, //!< A URI without fragment, e.g. "http://www.example.org/pub"
+    curi_request_target_authority, //!< An authority, only used by CONNECT requests, e.g. "www.example.com:80"
+    curi_request_target_asterisk //!< "*", e.g. in "OPTIONS * HTTP/1.1"
+} curi_request_target_form;
+
+/** Elements of an HTTP request line, see `curi_parse_request_line`
+    \ingroup request_line
+*/
+typedef struct
+{
+    curi_method method; //!< the method, curi_method_unknown when it isn't a known one.
+    const char* methodName; //!< the method, as it appears in the request line.
+    size_t methodNameLen; //!< length of the method.
+    curi_request_target_form targetForm; //!< the form of the request target.
+    const char* target; //!< the request target.
+    size_t targetLen; //!< length of the request target.
+    unsigned int versionMajor; //!< the major digit of the HTTP version.
+    unsigned int versionMinor; //!< the minor digit of the HTTP version.
+} curi_request_line;
+
+/** Elements of a data URI, see `curi_parse_data_uri`
+    \ingroup data_uri
+*/
+typedef struct
+{
+    const char* mediaType; //!< the media type, "type/subtype", empty when omitted (meaning "text/plain").
+    size_t mediaTypeLen; //!< length of the media type.
+    const char* parameters; //!< the parameters following the media type, "attribute=value" items separated by ';', ";base64" excluded.
+    size_t parametersLen; //!< length of the parameters.
+    int base64; //!< != 0 if the data is base64 encoded, percent encoded otherwise.
+    const char* data; //!< the encoded data, following the first ','.
+    size_t dataLen; //!< length of the encoded data.
+} curi_data_uri;
+
+/** Incremental decoder of the data of data URIs, see `curi_data_decoder_init`
+    \ingroup data_uri
+*/
+typedef struct
+{
+    int base64; //!< != 0 if the data is base64 encoded, percent encoded otherwise.
+    unsigned long bits; //!< the bits of a base64 quartet, or the first digit of a percent encoding, split between two chunks.
+    int bitCount; //!< number of base64 bits pending in bits, always below 8.
+    int padding; //!< != 0 once a base64 padding character was read.
+    int percent; //!< number of characters, '%' included, of a percent encoding split between two chunks.
+} curi_data_decoder;
+
+/** Grammar rules reported on parsing errors
+    \ingroup parsing
+*/
+typedef enum
+{
+    curi_error_none = 0, //!< No error
+    curi_error_scheme, //!< The scheme, or the ':' following it, is invalid
+    curi_error_authority, //!< The authority is followed by an invalid character, or lacks the host required by a request target
+    curi_error_ip_literal, //!< The IP literal, between '[' and ']', isn't a valid IPv6 or IPvFuture address
+    curi_error_percent_encoding, //!< A '%' isn't followed by two hexadecimal digits
+    curi_error_trailing_characters, //!< Characters are left after the longest valid prefix
+    curi_error_method, //!< The method of a request line isn't a token followed by a space
+    curi_error_http_version //!< The version of a request line isn't "HTTP/" DIGIT "." DIGIT
+} curi_error_rule;
+
+/** Position and reason of a parsing error, given to each parsing call, see `curi_parse_full_uri_with_error`
+
+    Filled with the failure when the parsing returns curi_status_error, reset to curi_error_none otherwise.
+
+    \ingroup parsing
+*/
+typedef struct
+{
+    curi_error_rule rule; //!< the rule that failed.
+    size_t offset; //!< offset of the offending character, the furthest one reached, or of the '[' starting an invalid IP literal.
+    char character; //!< the offending character, '\0' if the end of the string was reached.
+} curi_error;
+
+/** Resource limits enforced while parsing
+
+    Limits are checked as soon as they are crossed, before calling the callbacks or
+    allocating memory for the offending element. A limit set to 0 is disabled.
+
+    \ingroup parsing
+*/
+typedef struct
+{
+    size_t max_length; //!< maximum length of the parsed string.
+    size_t max_path_segments; //!< maximum number of path segments, empty ones included.
+    size_t max_query_items; //!< maximum number of query items, only checked when one of the query item callbacks is set.
+    size_t max_query_item_key_length; //!< maximum length of a query item key, only checked when one of the query item callbacks is set.
+    size_t max_query_item_value_length; //!< maximum length of a query item value, only checked when one of the query item callbacks is set.
+    size_t max_decoded_length; //!< maximum length of a string to url decode, only checked when url_decode != 0.
+} curi_limits;
+
+/** Span of a parsed string
+    \ingroup parsing
+*/
+typedef struct
+{
+    size_t offset; //!< offset of the span from the start of the parsed string.
+    size_t len; //!< length of the span.
+} curi_span;
+
+/** Spans of the segments of a parsed path, given to each parsing call, see `curi_parse_full_uri_with_spans`
+    \ingroup parsing
+*/
+typedef struct
+{
+    curi_span* spans; //!< if not-NULL, array filled with the spans of the path segments, empty ones included, before any url decoding or normalization, the spans beyond capacity being dropped.
+    size_t capacity; //!< capacity of spans, ignored if spans is NULL.
+    size_t count; //!< set to the number of path segments, empty ones included, which is above capacity when spans were dropped.
+} curi_path_segments;
+
+/** Iterator over the segments of a path, see `curi_segment_iter_init`
+    \ingroup parsing
+*/
+typedef struct
+{
+    const char* path; //!< the iterated path.
+    size_t len; //!< length of the iterated path.
+    size_t offset; //!< offset of the next segment.
+    int done; //!< != 0 once all the segments have been iterated.
+} curi_segment_iter;
+
+/** Item of a query, see `curi_query_iter_next`
+    \ingroup parsing
+*/
+typedef struct
+{
+    const char* key; //!< the key of the item, not url decoded.
+    size_t keyLen; //!< length of the key.
+    const char* value; //!< the value of the item, not url decoded, NULL when the item has no key separator.
+    size_t valueLen; //!< length of the value.
+} curi_query_item;
+
+/** Iterator over the items of a query, see `curi_query_iter_init`
+    \ingroup parsing
+*/
+typedef struct
+{
+    const char* query; //!< the iterated query.
+    size_t len; //!< length of the iterated query.
+    size_t offset; //!< offset of the next item.
+    char item_separator; //!< the character separating query items.
+    char key_separator; //!< the character separating, in query items, the key from the value.
+    const char* item_separators; //!< if not-NULL, the set of characters separating query items, overriding item_separator.
+    const char* key_separators; //!< if not-NULL, the set of characters separating, in query items, the key from the value, overriding key_separator.
+} curi_query_iter;
+
+/** Host normalizations, to be combined
+    \ingroup host_normalization
+*/
+typedef enum
+{
+    curi_host_lowercase = 1, //!< ASCII characters are lowercased
+    curi_host_to_ascii = 2, //!< Labels having non-ASCII characters are punycode encoded and prefixed by "xn--"
+    curi_host_to_unicode = 4 //!< Labels prefixed by "xn--" are punycode decoded to UTF-8
+} curi_host_normalization;
+
+/** Path normalizations, to be combined
+    \ingroup path_normalization
+*/
+typedef enum
+{
+    curi_path_remove_dot_segments = 1, //!< "." and ".." segments are removed (RFC-3986 section 5.2.4)
+    curi_path_merge_slashes = 2, //!< Empty segments, except the last one, are removed
+    curi_path_normalize_percent_encoding = 4 //!< Percent encoded unreserved characters are decoded and the others use uppercase hexadecimal digits (RFC-3986 section 6.2.2)
+} curi_path_normalization;
+
+/** Classes of the characters of query items, compiled once from query separators, see `curi_compile_query_grammar`
+    \ingroup parsing
+*/
+typedef struct
+{
+    unsigned char classes[256]; //!< class of each character, for internal use.
+} curi_query_grammar;
+
+/** Bounded cache of host normalization results
+    \ingroup host_normalization
+*/
+typedef struct curi_host_cache curi_host_cache;
+
+/** Maximum length of the hosts stored in a host table
+    \ingroup host_interning
+*/
+#define CURI_HOST_TABLE_MAX_HOST_LENGTH 255
+
+/** Thread safe table mapping hosts to integer IDs
+    \ingroup host_interning
+*/
+typedef struct curi_host_table curi_host_table;
+
+/** Public suffix list compiled in a trie of reversed labels
+    \ingroup public_suffix
+*/
+typedef struct curi_public_suffix_list curi_public_suffix_list;
+
+/** Rules compiled in tries of host suffixes and path prefixes
+    \ingroup url_matching
+*/
+typedef struct curi_url_matcher curi_url_matcher;
+
+/** Bump allocator made of chained chunks
+    \ingroup arena
+*/
+typedef struct curi_arena curi_arena;
+
 /** Parsing parameters
     \ingroup parsing
 */
 typedef struct
 {
-    void* (*allocate)(void* userData, size_t size); //!< function used for memory allocation (default is based on malloc).
+    void* (*allocate)(void* userData, size_t size); //!< function used for memory allocation, returning NULL on failure, making the parsing fail (default is based on malloc).
     void (*deallocate)(void* userData, void* ptr, size_t size); //!< function used for memory deallocation (default is based on free).
     int (*scheme_callback)(void* userData, const char* scheme, size_t schemeLen); //!< if not-NULL, called with the parsed scheme (default is NULL).
+    int (*scheme_id_callback)(void* userData, curi_scheme_id schemeId); //!< if not-NULL, called after scheme_callback with the ID of the parsed scheme, curi_scheme_unknown if it isn't a well-known one (default is NULL).
     int (*userinfo_callback)(void* userData, const char* userinfo, size_t userinfoLen); //!< if not-NULL, called with the parsed userinfo (default is NULL).
     int (*host_callback)(void* userData, const char* host, size_t hostLen); //!< if not-NULL, called with the parsed host (default is NULL).
+    int (*host_ipv4_callback)(void* userData, unsigned long address); //!< if not-NULL, called with the parsed host as a 32 bits number, in host order, when it is an IPv4 address (default is NULL).
+    int (*host_ipv6_callback)(void* userData, const unsigned char* address); //!< if not-NULL, called with the 16 bytes, in network order, of the parsed host when it is an IPv6 address (default is NULL).
     int (*portStr_callback)(void* userData, const char* portStr, size_t portStrLen); //!< if not-NULL, called with the parsed port (default is NULL).
-    int (*port_callback)(void* userData, unsigned int port); //!< if not-NULL, called with the parsed port as a number (default is NULL).
+    int (*port_callback)(void* userData, unsigned int port); //!< if not-NULL, called with the parsed port as a number, when it is not above 65535 (default is NULL).
+    int (*invalid_port_callback)(void* userData, const char* portStr, size_t portStrLen); //!< if not-NULL, called with the parsed port when it is above 65535, instead of port_callback (default is NULL).
     int (*path_callback)(void* userData, const char* path, size_t pathLen); //!< if not-NULL, called with the parsed path (default is NULL).
     int (*path_segment_callback)(void* userData, const char* pathSegment, size_t pathSegmentLen); //!< if not-NULL, called with the parsed path segment (default is NULL).
+    int path_normalization; //!< combination of curi_path_normalization applied to the path, requiring the allocation of a temporary string, before calling path_segment_callback and path_callback (default is 0, no normalization).
     int (*query_callback)(void* userData, const char* query, size_t queryLen); //!< if not-NULL, called with the parsed query (default is NULL).
     int (*query_item_null_callback)(void* userData, const char* queryItemKey, size_t queryItemKeyLen); //!< if not-NULL, called with each of the parsed query items having no value (default is NULL).
     int (*query_item_int_callback)(void* userData, const char* queryItemKey, size_t queryItemKeyLen, long int queryItemValue); //!< if not-NULL, called with each of the parsed query items having an int value (default is NULL).
@@ -62,8 +333,21 @@ typedef struct
     int (*query_item_str_callback)(void* userData, const char* queryItemKey, size_t queryItemKeyLen, const char* queryItemValue, size_t queryItemValueLen); //!< if not-NULL, called with each of the parsed query items that hasn't been handled by the previous callbacks (default is NULL).
     char query_item_separator; //!< the character separating query items (default is '&').
     char query_item_key_separator; //!< the character separating, in query items, the key from the value (default is '=').
+    const char* query_item_separators; //!< if not-NULL, the NUL-terminated set of characters separating query items, overriding query_item_separator (default is NULL).
+    const char* query_item_key_separators; //!< if not-NULL, the NUL-terminated set of characters separating, in query items, the key from the value, overriding query_item_key_separator (default is NULL).
+    const curi_query_grammar* query_grammar; //!< if not-NULL, grammar compiled by `curi_compile_query_grammar`, used to parse query items instead of the four separator settings above (default is NULL).
     int (*fragment_callback)(void* userData, const char* fragment, size_t fragmentLen); //!< if not-NULL, called with the parsed fragment (default is NULL).
+    const curi_url_matcher* url_matcher; //!< if not-NULL, rules matched against the host and path of parsed URIs (default is NULL).
+    int (*url_rule_callback)(void* userData, size_t ruleId); //!< if not-NULL and url_matcher is set, called with each rule matching the parsed URI, like `curi_url_matcher_match` (default is NULL).
     int url_decode; //!< if != 0, the string passed to the callbacks ae first url decoded, requiring the allocation of a temporary string.
+    const curi_limits* limits; //!< if not-NULL, the resource limits enforced while parsing (default is NULL).
+    int components; //!< if != 0, combination of curi_component after which the parsing of full URIs stops, returning curi_status_partial if characters are left unchecked (default is 0, the whole URI is parsed).
+    int host_normalization; //!< combination of curi_host_normalization applied to reg-name hosts before calling host_callback (default is 0, no normalization).
+    curi_host_cache* host_cache; //!< if not-NULL, cache used for the host normalization (default is NULL).
+    curi_host_table* host_table; //!< if not-NULL, table in which the parsed host is interned before calling host_id_callback (default is NULL).
+    int (*host_id_callback)(void* userData, unsigned int hostId, const char* host, size_t hostLen); //!< if not-NULL and host_table is set, called with the ID of the parsed host in host_table and its canonical lowercase form, unless the host is longer than CURI_HOST_TABLE_MAX_HOST_LENGTH (default is NULL).
+    const curi_public_suffix_list* public_suffix_list; //!< if not-NULL, public suffix list used to find the registrable domain of reg-name hosts (default is NULL).
+    int (*registrable_domain_callback)(void* userData, const char* domain, size_t domainLen); //!< if not-NULL and public_suffix_list is set, called with the registrable domain of the parsed host, when it has one (default is NULL).
 } curi_settings;
 
 /** Set the given settings to their default value
@@ -87,10 +371,68 @@ curi_status curi_parse_full_uri_nt(const char* uri, const curi_settings* setting
     NULL-character ('\0') is read, making this function working for NULL-terminated
     string as well.
 
+    \note When settings->components is set, the parsing stops once the requested
+    components are known, returning curi_status_partial if the rest of the URI
+    was left unchecked.
+
     \ingroup parsing
 */
 curi_status curi_parse_full_uri(const char* uri, size_t len, const curi_settings* settings /*= 0*/, void* userData /*= 0*/);
 
+/** Parse the given string as a full URI, like `curi_parse_full_uri`, reporting the position and reason of a failure.
+
+    If `error` is not-NULL, it is filled while parsing, in the same pass, the furthest offset
+    reached being kept. Being given per call, settings can still be shared between threads.
+
+    \ingroup parsing
+*/
+curi_status curi_parse_full_uri_with_error(const char* uri, size_t len, curi_error* error /*= 0*/, const curi_settings* settings /*= 0*/, void* userData /*= 0*/);
+
+/** Parse the given string as a full URI, like `curi_parse_full_uri_with_error`, retrieving the spans of its path segments.
+
+    If `segments` is not-NULL, its count and spans are set while parsing, offsets being relative to
+    the start of `uri`. Being given per call, settings can still be shared between threads.
+
+    \ingroup parsing
+*/
+curi_status curi_parse_full_uri_with_spans(const char* uri, size_t len, curi_path_segments* segments /*= 0*/, curi_error* error /*= 0*/, const curi_settings* settings /*= 0*/, void* userData /*= 0*/);
+
+/** ID of the given scheme, curi_scheme_unknown if it isn't a well-known one, schemes being case insensitive.
+
+    \ingroup parsing
+*/
+curi_scheme_id curi_scheme_lookup(const char* scheme, size_t schemeLen);
+
+/** Default port of the given scheme, 0 for curi_scheme_unknown and values outside curi_scheme_id.
+
+    \ingroup parsing
+*/
+unsigned int curi_scheme_default_port(curi_scheme_id schemeId);
+
+/** Parse the given NULL-terminated string as a URI reference.
+
+    \note This function doesn't do compute `strlen(uri)`, it calls `curi_parse_uri_reference`
+    with a length set to SIZE_MAX.
+
+    \ingroup parsing
+*/
+curi_status curi_parse_uri_reference_nt(const char* uri, curi_reference_form* form /*= 0*/, curi_error* error /*= 0*/, const curi_settings* settings /*= 0*/, void* userData /*= 0*/);
+
+/** Parse the given string as a URI reference, a full URI or a relative reference, specifying its length.
+
+    If `form` is not-NULL, it is set to the form of the reference. The characters
+    that may start a scheme are read once: followed by a colon they are the scheme,
+    otherwise the first path segment goes on from them. If `error` is not-NULL, it
+    is filled like by `curi_parse_full_uri_with_error`.
+
+    \note In practice the parsing ends once the given length is reached or a
+    NULL-character ('\0') is read, making this function working for NULL-terminated
+    string as well.
+
+    \ingroup parsing
+*/
+curi_status curi_parse_uri_reference(const char* uri, size_t len, curi_reference_form* form /*= 0*/, curi_error* error /*= 0*/, const curi_settings* settings /*= 0*/, void* userData /*= 0*/);
+
 /** Parse the given NULL-terminated string as a URI path.
 
     \note This function doesn't do compute `strlen(path)`, it calls `curi_parse_path`
@@ -110,6 +452,22 @@ curi_status curi_parse_path_nt(const char* path, const curi_settings* settings /
 */
 curi_status curi_parse_path(const char* path, size_t len, const curi_settings* settings /*= 0*/, void* userData /*= 0*/);
 
+/** Parse the given string as a URI path, like `curi_parse_path`, reporting the position and reason of a failure.
+
+    See `curi_parse_full_uri_with_error`.
+
+    \ingroup parsing
+*/
+curi_status curi_parse_path_with_error(const char* path, size_t len, curi_error* error /*= 0*/, const curi_settings* settings /*= 0*/, void* userData /*= 0*/);
+
+/** Parse the given string as a URI path, like `curi_parse_path_with_error`, retrieving the spans of its segments.
+
+    See `curi_parse_full_uri_with_spans`.
+
+    \ingroup parsing
+*/
+curi_status curi_parse_path_with_spans(const char* path, size_t len, curi_path_segments* segments /*= 0*/, curi_error* error /*= 0*/, const curi_settings* settings /*= 0*/, void* userData /*= 0*/);
+
 /** Parse the given NULL-terminated string as a URI query.
 
     \note This function doesn't do compute `strlen(query)`, it calls `curi_parse_query`
@@ -129,6 +487,187 @@ curi_status curi_parse_query_nt(const char* query, const curi_settings* settings
 */
 curi_status curi_parse_query(const char* query, size_t len, const curi_settings* settings /*= 0*/, void* userData /*= 0*/);
 
+/** Parse the given string as a URI query, like `curi_parse_query`, reporting the position and reason of a failure.
+
+    See `curi_parse_full_uri_with_error`.
+
+    \ingroup parsing
+*/
+curi_status curi_parse_query_with_error(const char* query, size_t len, curi_error* error /*= 0*/, const curi_settings* settings /*= 0*/, void* userData /*= 0*/);
+
+/** Compile the query item separators of the given settings in a grammar.
+
+    The grammar is meant to be compiled once, when the settings are built, and set as
+    `curi_settings::query_grammar`: custom separators are then parsed as fast as the default
+    ones, which never need to be compiled.
+
+    \ingroup parsing
+*/
+void curi_compile_query_grammar(curi_query_grammar* grammar, const curi_settings* settings);
+
+/** Check that the given string is a full URI, without calling any callback.
+
+    Accepts the same URIs as `curi_parse_full_uri`, in a single pass over the character classes.
+    On error, `errorOffset` is set to the offset of the first character that couldn't be accepted.
+
+    \note The validation ends once the given length is reached or a NULL-character ('\0') is read.
+
+    \ingroup parsing
+*/
+curi_status curi_validate_full_uri(const char* uri, size_t len, size_t* errorOffset /*= 0*/);
+
+/** Check that the given string is a URI path, without calling any callback.
+
+    Accepts the same paths as `curi_parse_path`, see `curi_validate_full_uri`.
+
+    \ingroup parsing
+*/
+curi_status curi_validate_path(const char* path, size_t len, size_t* errorOffset /*= 0*/);
+
+/** Check that the given string is a URI query, without calling any callback.
+
+    Accepts the same queries as `curi_parse_query`, see `curi_validate_full_uri`.
+
+    \ingroup parsing
+*/
+curi_status curi_validate_query(const char* query, size_t len, size_t* errorOffset /*= 0*/);
+
+/** Initialize an iterator over the segments of the given path.
+
+    Segments are split lazily by `curi_segment_iter_next`, like the spans retrieved with
+    `curi_parse_path_with_spans`: a leading '/' is skipped and empty segments are included.
+    The path isn't validated, it is expected to come from a parsed URI.
+
+    \note The iteration ends once the given length is reached or a NULL-character ('\0') is read.
+
+    \ingroup parsing
+*/
+void curi_segment_iter_init(curi_segment_iter* iter, const char* path, size_t len);
+
+/** Retrieve the next segment of the path, returns 0 once all the segments have been iterated.
+
+    \ingroup parsing
+*/
+int curi_segment_iter_next(curi_segment_iter* iter, const char** segment, size_t* segmentLen);
+
+/** Initialize an iterator over the items of the given query.
+
+    Items are split lazily by `curi_query_iter_next`, using the separators of the given settings
+    (default settings if NULL), empty items being skipped. The query isn't validated, it is
+    expected to come from a parsed URI.
+
+    \note The iteration ends once the given length is reached or a NULL-character ('\0') is read.
+
+    \ingroup parsing
+*/
+void curi_query_iter_init(curi_query_iter* iter, const char* query, size_t len, const curi_settings* settings /*= 0*/);
+
+/** Retrieve the next item of the query, returns 0 once all the items have been iterated.
+
+    Only the characters of the retrieved item are read.
+
+    \ingroup parsing
+*/
+int curi_query_iter_next(curi_query_iter* iter, curi_query_item* item);
+
+/** \defgroup request_line HTTP request lines
+    \brief Parsing HTTP request lines, their request target being parsed like URIs.
+ */
+
+/** Parse the given NULL-terminated string as an HTTP request line.
+
+    \note This function doesn't do compute `strlen(line)`, it calls `curi_parse_request_line`
+    with a length set to SIZE_MAX.
+
+    \ingroup request_line
+*/
+curi_status curi_parse_request_line_nt(const char* line, curi_request_line* requestLine /*= 0*/, curi_error* error /*= 0*/, const curi_settings* settings /*= 0*/, void* userData /*= 0*/);
+
+/** Parse the given string as an HTTP request line specifying its length (RFC-7230 section 3.1.1).
+
+    request-line = method SP request-target SP HTTP-version [ CRLF ]
+
+    The method, the request target and the version are read in one scan, the components of the
+    request target being passed to the settings callbacks. If `requestLine` is not-NULL, it is
+    filled with the elements of the line. If `error` is not-NULL, it is filled like by
+    `curi_parse_full_uri_with_error`.
+
+    The form of the request target is chosen from the method and its first character: the
+    authority form for CONNECT requests, the asterisk form for "*", the origin form for "/" and
+    the absolute form otherwise.
+
+    \note When settings->components is set, the parsing of origin and absolute form targets stops
+    once the requested components are known, returning curi_status_partial, the rest of the target
+    and the version being left unchecked. Authority and asterisk form targets are always fully parsed.
+
+    \ingroup request_line
+*/
+curi_status curi_parse_request_line(const char* line, size_t len, curi_request_line* requestLine /*= 0*/, curi_error* error /*= 0*/, const curi_settings* settings /*= 0*/, void* userData /*= 0*/);
+
+/** \defgroup data_uri Data URIs
+    \brief Parsing data URIs (RFC-2397) and decoding their data.
+ */
+
+/** Parse the given string as a data URI specifying its length.
+
+    dataurl = "data:" [ mediatype ] [ ";base64" ] "," data
+
+    If `dataUri` is not-NULL, it is filled with the elements of the URI, the parameters being
+    iterable with `curi_query_iter`, using ';' as query item separator. If `output` is not-NULL,
+    the data is validated and decoded in it, like `curi_data_decoder_decode`, an output capacity
+    of `dataLen` being always enough.
+
+    \note Fails if the scheme isn't "data" (case insensitive), the media type or the parameters
+    aren't tokens, the data is invalid or the output is too small.
+
+    \ingroup data_uri
+*/
+curi_status curi_parse_data_uri(const char* uri, size_t len, curi_data_uri* dataUri /*= 0*/, char* output /*= 0*/, size_t outputCapacity /*= 0*/, size_t* outputLen /*= 0*/);
+
+/** Initialize a decoder of base64 encoded (if base64 != 0) or percent encoded data.
+
+    \ingroup data_uri
+*/
+void curi_data_decoder_init(curi_data_decoder* decoder, int base64);
+
+/** Decode a chunk of the data of a data URI, writing its decoded bytes at the start of `output`.
+
+    Each call writes from `output[0]`, `outputLen` being set to the number of bytes decoded from
+    this chunk only: the caller concatenates the outputs of the successive chunks.
+
+    The data can be split in chunks anywhere, the characters of a base64 quartet or of a percent
+    encoding split between two chunks being kept in the decoder. An output capacity of
+    `dataLen` is always enough, allowing huge data to be decoded in a bounded buffer.
+
+    Base64 data is decoded a quartet at a time, the padding being optional.
+
+    \note Fails if the data has invalid characters or the output is too small.
+
+    \ingroup data_uri
+*/
+curi_status curi_data_decoder_decode(curi_data_decoder* decoder, const char* data, size_t dataLen, char* output, size_t outputCapacity, size_t* outputLen /*= 0*/);
+
+/** Check that the data given to the decoder ended on a complete base64 quartet or percent encoding.
+
+    \ingroup data_uri
+*/
+curi_status curi_data_decoder_finish(const curi_data_decoder* decoder);
+
+/** \defgroup resolution Reference resolution
+    \brief Resolving URI references against a base URI.
+ */
+
+/** Resolve the given URI reference against the given base URI (RFC-3986 section 5.2).
+
+    The target URI is written in the output, its dot segments removed, without any allocation.
+    An output capacity of `baseLen + referenceLen + 1` is always enough.
+
+    \note Fails if the base isn't a URI, the reference isn't a URI reference or the output is too small.
+
+    \ingroup resolution
+*/
+curi_status curi_resolve(const char* base, size_t baseLen, const char* reference, size_t referenceLen, char* output, size_t outputCapacity, size_t* outputLen /*=0*/);
+
 /** \defgroup url_decoding URL decoding
     \brief Decoding percent encoded strings.
  */
@@ -158,6 +697,409 @@ curi_status curi_url_decode_nt(const char* input, char* output, size_t outputCap
 */
 curi_status curi_url_decode(const char* input, size_t inputLen, char* output, size_t outputCapacity, size_t* outputLen /*=0*/);
 
+/** \defgroup path_normalization Path normalization
+    \brief Removing dot segments and normalizing percent encodings of paths.
+ */
+
+/** Normalize, in place, the given path following a combination of curi_path_normalization.
+
+    The path is rewritten in a single pass, its new length being at most its current length.
+
+    \note Fails if the path has an invalid percent encoding and curi_path_normalize_percent_encoding is set.
+
+    \ingroup path_normalization
+*/
+curi_status curi_normalize_path(char* path, size_t pathLen, int normalization, size_t* newPathLen /*=0*/);
+
+/** \defgroup host_normalization Host normalization
+    \brief Lowercasing hosts and converting internationalized domain names.
+ */
+
+/** Punycode encode (RFC-3492) the given UTF-8 string.
+
+    \note This works on a single label and doesn't add the "xn--" prefix.
+
+    \ingroup host_normalization
+*/
+curi_status curi_punycode_encode(const char* input, size_t inputLen, char* output, size_t outputCapacity, size_t* outputLen /*=0*/);
+
+/** Punycode decode (RFC-3492) the given string to UTF-8.
+
+    \note This works on a single label, without the "xn--" prefix.
+
+    \ingroup host_normalization
+*/
+curi_status curi_punycode_decode(const char* input, size_t inputLen, char* output, size_t outputCapacity, size_t* outputLen /*=0*/);
+
+/** Normalize the given host, label by label, following a combination of curi_host_normalization.
+
+    \note Only ASCII characters are lowercased, the IDNA mapping of Unicode characters
+    (case folding and normalization forms) is not applied.
+
+    \ingroup host_normalization
+*/
+curi_status curi_normalize_host(const char* host, size_t hostLen, int normalization, char* output, size_t outputCapacity, size_t* outputLen /*=0*/);
+
+/** Create a cache able to store the normalization of `capacity` hosts.
+
+    Each host is stored in an entry determined by its hash, evicting the previous one.
+    The memory used by the cache is allocated once, using the given settings allocation
+    function (`malloc` if settings is NULL).
+
+    \note A cache is not thread safe, it should be used by one thread at a time.
+
+    \ingroup host_normalization
+*/
+curi_host_cache* curi_host_cache_create(size_t capacity, const curi_settings* settings /*= 0*/, void* userData /*= 0*/);
+
+/** Destroy a cache created by `curi_host_cache_create`.
+
+    \ingroup host_normalization
+*/
+void curi_host_cache_destroy(curi_host_cache* cache);
+
+/** Normalize the given host like `curi_normalize_host`, using the cache.
+
+    \ingroup host_normalization
+*/
+curi_status curi_host_cache_normalize(curi_host_cache* cache, const char* host, size_t hostLen, int normalization, char* output, size_t outputCapacity, size_t* outputLen /*=0*/);
+
+/** \defgroup host_interning Host interning
+    \brief Mapping hosts to stable integer IDs, shared between threads.
+ */
+
+/** Create a table able to intern `capacity` hosts.
+
+    Hosts are mapped to IDs in [0, `curi_host_table_capacity(table)`[. Once the table is full,
+    interning a new host evicts one that wasn't recently interned (CLOCK policy), its ID being
+    reused. The memory used by the table is allocated once, using the given settings allocation
+    function (`malloc` if settings is NULL).
+
+    \note The table is thread safe: lookups of interned hosts don't lock, insertions lock
+    one of the table stripes. This relies on the atomic operations of GCC, Clang or MSVC:
+    built with another compiler, the table isn't thread safe and should be used by one
+    thread at a time.
+
+    \ingroup host_interning
+*/
+curi_host_table* curi_host_table_create(size_t capacity, const curi_settings* settings /*= 0*/, void* userData /*= 0*/);
+
+/** Destroy a table created by `curi_host_table_create`.
+
+    \ingroup host_interning
+*/
+void curi_host_table_destroy(curi_host_table* table);
+
+/** Number of IDs of the table, at least the capacity given at its creation.
+
+    \ingroup host_interning
+*/
+size_t curi_host_table_capacity(const curi_host_table* table);
+
+/** Intern the given host, ASCII lowercased, and retrieve its ID.
+
+    \note Fails if the host is empty or longer than CURI_HOST_TABLE_MAX_HOST_LENGTH.
+
+    \ingroup host_interning
+*/
+curi_status curi_host_table_intern(curi_host_table* table, const char* host, size_t hostLen, unsigned int* hostId);
+
+/** Retrieve the canonical lowercase host having the given ID.
+
+    \note Fails if no host has this ID.
+
+    \ingroup host_interning
+*/
+curi_status curi_host_table_get(const curi_host_table* table, unsigned int hostId, char* output, size_t outputCapacity, size_t* outputLen /*=0*/);
+
+/** \defgroup public_suffix Public suffixes
+    \brief Finding the registrable domain of hosts, using the [Public Suffix List](https://publicsuffix.org).
+ */
+
+/** Compile the given public suffix list, in the format of `public_suffix_list.dat`.
+
+    Each line holds a rule, possibly followed by whitespaces, comments starting with "//".
+    Wildcard ("*.") and exception ("!") rules are supported. Rules are matched as written,
+    hosts with internationalized labels should be normalized consistently with the list.
+
+    The memory used by the compiled list is allocated using the given settings allocation
+    function (`malloc` if settings is NULL), returns NULL if a rule has an empty label.
+
+    \note A compiled list is never modified, it can be shared between threads.
+
+    \ingroup public_suffix
+*/
+curi_public_suffix_list* curi_public_suffix_list_create(const char* list, size_t listLen, const curi_settings* settings /*= 0*/, void* userData /*= 0*/);
+
+/** Destroy a list created by `curi_public_suffix_list_create`.
+
+    \ingroup public_suffix
+*/
+void curi_public_suffix_list_destroy(curi_public_suffix_list* publicSuffixList);
+
+/** Retrieve the registrable domain of the given host, its public suffix plus one label.
+
+    The domain is the `domainLen` characters of the host starting at `domainOffset`, a trailing
+    dot being excluded. Labels are compared ignoring the case of ASCII characters.
+
+    \note Fails if the host has an empty label or is itself a public suffix.
+
+    \ingroup public_suffix
+*/
+curi_status curi_registrable_domain(const curi_public_suffix_list* publicSuffixList, const char* host, size_t hostLen, size_t* domainOffset, size_t* domainLen /*=0*/);
+
+/** \defgroup routing Routing
+    \brief Matching paths against a compiled table of routes.
+ */
+
+/** Maximum number of segments of matched paths
+    \ingroup routing
+*/
+#define CURI_ROUTE_MAX_SEGMENTS 32
+
+/** Maximum number of captures of a route
+    \ingroup routing
+*/
+#define CURI_ROUTE_MAX_CAPTURES 16
+
+/** Route table compiled in a trie of segments
+    \ingroup routing
+*/
+typedef struct curi_router curi_router;
+
+/** Segment, or segments, of a matched path
+    \ingroup routing
+*/
+typedef struct
+{
+    const char* str; //!< start of the capture in the parsed path, NULL for empty wildcard captures
+    size_t len; //!< length of the capture
+} curi_route_capture;
+
+/** State of the matching of a path, to be initialized by `curi_route_match_init`
+    \ingroup routing
+*/
+typedef struct
+{
+    const curi_router* router; //!< router used for the matching.
+    unsigned int methods; //!< method of the matched request, as a bit of the routes methods.
+    size_t segmentCount; //!< number of segments of the matched path.
+    curi_route_capture segments[CURI_ROUTE_MAX_SEGMENTS]; //!< segments of the matched path.
+    size_t captureCount; //!< number of captures of the matched route.
+    curi_route_capture captures[CURI_ROUTE_MAX_CAPTURES]; //!< captures of the matched route, in the order of its parameters and wildcard.
+    unsigned int allowedMethods; //!< if no route is matched, methods of the routes matching the path but not the request method.
+} curi_route_match;
+
+/** Compile the given routes, their IDs being their index.
+
+    Routes are made of segments separated by '/', empty segments being ignored. A segment is either:
+    - static, matching the same path segment;
+    - a parameter, like "{id}", matching and capturing any path segment;
+    - a wildcard, "*", as the last segment, matching and capturing the remaining path segments, possibly none.
+
+    Static segments have priority over parameters, themselves having priority over wildcards.
+    Routes having the same segments are tried in the order of their IDs.
+
+    `routeMethods`, if not-NULL, holds for each route the bit mask of its accepted methods,
+    the meaning of the bits being up to the caller. By default, routes accept all methods.
+
+    The memory used by the router is allocated using the given settings allocation
+    function (`malloc` if settings is NULL), returns NULL if a route is malformed or
+    has more than CURI_ROUTE_MAX_CAPTURES captures.
+
+    \note A router is never modified, it can be shared between threads.
+
+    \ingroup routing
+*/
+curi_router* curi_router_create(const char* const* routes, const unsigned int* routeMethods /*= 0*/, size_t routeCount, const curi_settings* settings /*= 0*/, void* userData /*= 0*/);
+
+/** Destroy a router created by `curi_router_create`.
+
+    \ingroup routing
+*/
+void curi_router_destroy(curi_router* router);
+
+/** Initialize the matching of a path, its segments being given to `curi_route_match_segment`.
+
+    \ingroup routing
+*/
+void curi_route_match_init(curi_route_match* match, const curi_router* router, unsigned int methods);
+
+/** Add a segment to the matched path.
+
+    To be used as `path_segment_callback`, `userData` being the `curi_route_match`. Captures point to
+    the given segments, `url_decode` and `path_normalization` shouldn't be used while parsing.
+
+    \ingroup routing
+*/
+int curi_route_match_segment(void* match, const char* segment, size_t segmentLen);
+
+/** Find the route matching the segments given to `curi_route_match_segment`.
+
+    \note Fails if no route is matched, returns curi_status_limit_exceeded if the path has
+    more than CURI_ROUTE_MAX_SEGMENTS segments.
+
+    \ingroup routing
+*/
+curi_status curi_route_match_end(curi_route_match* match, size_t* routeId);
+
+/** Parse the given path and find the matching route.
+
+    \ingroup routing
+*/
+curi_status curi_route_path(const curi_router* router, const char* path, size_t pathLen, unsigned int methods, curi_route_match* match, size_t* routeId);
+
+/** \defgroup url_matching URL matching
+    \brief Matching URIs against a compiled set of host suffix and path prefix rules.
+ */
+
+/** Rule matched by a `curi_url_matcher`
+    \ingroup url_matching
+*/
+typedef struct
+{
+    const char* host_suffix; //!< if not-NULL and not empty, the host must be equal to it or end with '.' followed by it, ignoring the case.
+    const char* path_prefix; //!< if not-NULL and not empty, the path must start with it.
+} curi_url_rule;
+
+/** Compile the given rules, their IDs being their index.
+
+    The memory used by the matcher is allocated using the given settings allocation
+    function (`malloc` if settings is NULL), returns NULL if a host suffix has an empty label.
+
+    \note A matcher is never modified, it can be shared between threads.
+
+    \ingroup url_matching
+*/
+curi_url_matcher* curi_url_matcher_create(const curi_url_rule* rules, size_t ruleCount, const curi_settings* settings /*= 0*/, void* userData /*= 0*/);
+
+/** Destroy a matcher created by `curi_url_matcher_create`.
+
+    \ingroup url_matching
+*/
+void curi_url_matcher_destroy(curi_url_matcher* matcher);
+
+/** Retrieve the IDs of the rules matching the given host and path.
+
+    Rules are ordered from the shortest host suffix to the longest, then from the shortest path
+    prefix to the longest, then by ID. `ruleCount` is set to the number of matching rules, the
+    IDs beyond `ruleIdsCapacity` being dropped.
+
+    \note Host and path are matched as given, without url decoding. Fails if no rule matches.
+
+    \ingroup url_matching
+*/
+curi_status curi_url_matcher_match(const curi_url_matcher* matcher, const char* host, size_t hostLen, const char* path, size_t pathLen, size_t* ruleIds, size_t ruleIdsCapacity, size_t* ruleCount);
+
+/** Retrieve the lowest ID of the rules matching the given host and path.
+
+    \note Fails if no rule matches.
+
+    \ingroup url_matching
+*/
+curi_status curi_url_matcher_first(const curi_url_matcher* matcher, const char* host, size_t hostLen, const char* path, size_t pathLen, size_t* ruleId);
+
+/** \defgroup arena Arena allocation
+    \brief Bump allocator to plug in the settings allocation functions.
+
+    Typical usage, when the settings user data is used for the callbacks, is to set a thread arena:
+    ~~~
+    curi_arena* arena = curi_arena_create(4096, 0, 0);
+    curi_arena_set_thread_arena(arena);
+    settings.allocate = curi_thread_arena_allocate;
+    settings.deallocate = curi_thread_arena_deallocate;
+    // For each request
+    curi_parse_full_uri(uri, len, &settings, userData);
+    curi_arena_reset(arena);
+    ~~~
+ */
+
+/** Create an arena allocating chunks of at least `chunkSize` bytes.
+
+    Chunks are allocated using the given settings allocation function (`malloc` if settings is NULL)
+    and chained as needed, allocations larger than `chunkSize` getting their own chunk. The first
+    chunk is allocated with the arena, returns NULL if it fails.
+
+    \note An arena isn't thread safe, it should be used by one thread at a time.
+
+    \ingroup arena
+*/
+curi_arena* curi_arena_create(size_t chunkSize, const curi_settings* settings /*= 0*/, void* userData /*= 0*/);
+
+/** Destroy an arena created by `curi_arena_create` and all its chunks.
+
+    \ingroup arena
+*/
+void curi_arena_destroy(curi_arena* arena);
+
+/** Release at once all the memory allocated from the arena, its chunks being kept for later allocations.
+
+    \ingroup arena
+*/
+void curi_arena_reset(curi_arena* arena);
+
+/** Number of bytes currently allocated from the arena, including alignment padding.
+
+    \ingroup arena
+*/
+size_t curi_arena_usage(const curi_arena* arena);
+
+/** Highest number of bytes allocated from the arena at once since its creation, resets included.
+
+    Useful to choose a chunk size fitting the usual workload in one chunk.
+
+    \ingroup arena
+*/
+size_t curi_arena_peak_usage(const curi_arena* arena);
+
+/** Allocate `size` bytes from the arena given as user data, aligned for any type.
+
+    To be used as `curi_settings::allocate`, the arena being the user data. Returns NULL if
+    a chunk allocation fails.
+
+    \ingroup arena
+*/
+void* curi_arena_allocate(void* arena, size_t size);
+
+/** Release an allocation from the arena given as user data.
+
+    To be used as `curi_settings::deallocate`, the arena being the user data. Memory is reclaimed
+    only for the latest allocation, the rest being reclaimed by `curi_arena_reset`.
+
+    \ingroup arena
+*/
+void curi_arena_deallocate(void* arena, void* ptr, size_t size);
+
+/** Set the arena used by the calling thread in `curi_thread_arena_allocate` and `curi_thread_arena_deallocate`.
+
+    \note Thread local storage relies on compiler extensions, available with GCC, Clang and MSVC.
+
+    \ingroup arena
+*/
+void curi_arena_set_thread_arena(curi_arena* arena);
+
+/** Retrieve the arena used by the calling thread, NULL if none was set.
+
+    \ingroup arena
+*/
+curi_arena* curi_arena_thread_arena(void);
+
+/** Allocate `size` bytes from the arena of the calling thread, the user data being ignored.
+
+    To be used as `curi_settings::allocate` when the user data is needed by the callbacks.
+    Returns NULL if the calling thread has no arena or a chunk allocation fails, the parsing
+    then failing with curi_status_error: an arena must be set in each parsing thread.
+
+    \ingroup arena
+*/
+void* curi_thread_arena_allocate(void* userData, size_t size);
+
+/** Release an allocation from the arena of the calling thread, the user data being ignored.
+
+    \ingroup arena
+*/
+void curi_thread_arena_deallocate(void* userData, void* ptr, size_t size);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,1031 @@
+// Copyright (c) 2013 Clodéric Mars
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef CURI_HPP
+#define CURI_HPP
+
+#include "curi.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+/** \defgroup cpp C++ interface
+    \brief Header-only C++17 views over the parsed URIs, built on top of the C interface,
+    and C++20 URI literals parsed at compile time.
+ */
+
+namespace curi
+{
+
+/** Lazy range over the segments of a path, empty ones included, as `std::string_view`.
+
+    Adaptor of `curi_segment_iter`, the segments being split from the path as the range is iterated.
+
+    \ingroup cpp
+*/
+class path_segment_range
+{
+public:
+    class iterator
+    {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = std::string_view;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const std::string_view*;
+        using reference = const std::string_view&;
+
+        iterator() = default;
+
+        reference operator*() const { return segment_; }
+        pointer operator->() const { return &segment_; }
+
+        iterator& operator++()
+        {
+            next();
+            return *this;
+        }
+
+        iterator operator++(int)
+        {
+            iterator previous = *this;
+            next();
+            return previous;
+        }
+
+        friend bool operator==(const iterator& lhs, const iterator& rhs)
+        {
+            return lhs.done_ == rhs.done_ && (lhs.done_ || lhs.segment_.data() == rhs.segment_.data());
+        }
+
+        friend bool operator!=(const iterator& lhs, const iterator& rhs) { return !(lhs == rhs); }
+
+    private:
+        friend class path_segment_range;
+
+        explicit iterator(std::string_view path)
+            : done_(false)
+        {
+            curi_segment_iter_init(&iter_, path.data(), path.size());
+            next();
+        }
+
+        void next()
+        {
+            const char* segment = 0;
+            size_t segmentLen = 0;
+            done_ = !curi_segment_iter_next(&iter_, &segment, &segmentLen);
+            segment_ = done_ ? std::string_view() : std::string_view(segment, segmentLen);
+        }
+
+        curi_segment_iter iter_ = curi_segment_iter();
+        std::string_view segment_;
+        bool done_ = true;
+    };
+
+    path_segment_range() = default;
+
+    explicit path_segment_range(std::string_view path)
+        : path_(path)
+    {
+    }
+
+    iterator begin() const { return iterator(path_); }
+    iterator end() const { return iterator(); }
+
+private:
+    std::string_view path_;
+};
+
+/** Item of a query, split at its first key separator.
+    \ingroup cpp
+*/
+struct query_item
+{
+    std::string_view key; //!< the key of the item, not url decoded.
+    std::optional<std::string_view> value; //!< the value of the item, not url decoded, `std::nullopt` when the item has no key separator.
+};
+
+/** Lazy range over the items of a query, as `query_item`.
+
+    Adaptor of `curi_query_iter`, the items being split from the query as the range is iterated.
+    Empty items are skipped.
+
+    \ingroup cpp
+*/
+class query_item_range
+{
+public:
+    class iterator
+    {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = query_item;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const query_item*;
+        using reference = const query_item&;
+
+        iterator() = default;
+
+        reference operator*() const { return item_; }
+        pointer operator->() const { return &item_; }
+
+        iterator& operator++()
+        {
+            next();
+            return *this;
+        }
+
+        iterator operator++(int)
+        {
+            iterator previous = *this;
+            next();
+            return previous;
+        }
+
+        friend bool operator==(const iterator& lhs, const iterator& rhs)
+        {
+            return lhs.done_ == rhs.done_ && (lhs.done_ || lhs.item_.key.data() == rhs.item_.key.data());
+        }
+
+        friend bool operator!=(const iterator& lhs, const iterator& rhs) { return !(lhs == rhs); }
+
+    private:
+        friend class query_item_range;
+
+        iterator(std::string_view query, const curi_settings* settings)
+            : done_(false)
+        {
+            curi_query_iter_init(&iter_, query.data(), query.size(), settings);
+            next();
+        }
+
+        void next()
+        {
+            curi_query_item item;
+            done_ = !curi_query_iter_next(&iter_, &item);
+            item_ = query_item();
+            if (!done_)
+            {
+                item_.key = std::string_view(item.key, item.keyLen);
+                if (item.value)
+                    item_.value = std::string_view(item.value, item.valueLen);
+            }
+        }
+
+        curi_query_iter iter_ = curi_query_iter();
+        query_item item_;
+        bool done_ = true;
+    };
+
+    query_item_range() = default;
+
+    /** Range over the items of the query, split using the separators of the given settings (default settings if NULL). */
+    explicit query_item_range(std::string_view query, const curi_settings* settings = 0)
+        : query_(query)
+        , settings_(settings)
+    {
+    }
+
+    iterator begin() const { return iterator(query_, settings_); }
+    iterator end() const { return iterator(); }
+
+private:
+    std::string_view query_;
+    const curi_settings* settings_ = 0;
+};
+
+/** Lazy range over the segments of a path, like `path_segment_range`, usable in constant expressions.
+
+    The segments are split by a `constexpr` port of `curi_segment_iter_next`.
+
+    \ingroup cpp
+*/
+class static_path_segment_range
+{
+public:
+    class iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::string_view;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const std::string_view*;
+        using reference = const std::string_view&;
+
+        iterator() = default;
+
+        constexpr reference operator*() const { return segment_; }
+        constexpr pointer operator->() const { return &segment_; }
+
+        constexpr iterator& operator++()
+        {
+            next();
+            return *this;
+        }
+
+        constexpr iterator operator++(int)
+        {
+            iterator previous = *this;
+            next();
+            return previous;
+        }
+
+        friend constexpr bool operator==(const iterator& lhs, const iterator& rhs)
+        {
+            return lhs.done_ == rhs.done_ && (lhs.done_ || lhs.segment_.data() == rhs.segment_.data());
+        }
+
+        friend constexpr bool operator!=(const iterator& lhs, const iterator& rhs) { return !(lhs == rhs); }
+
+    private:
+        friend class static_path_segment_range;
+
+        constexpr explicit iterator(std::string_view remaining)
+            : remaining_(remaining)
+            , last_(false)
+            , done_(false)
+        {
+            next();
+        }
+
+        constexpr void next()
+        {
+            // A separator is always followed by a segment, possibly empty
+            if (last_)
+            {
+                done_ = true;
+                segment_ = std::string_view();
+                return;
+            }
+            const std::size_t separator = remaining_.find('/');
+            segment_ = remaining_.substr(0, separator);
+            if (separator == std::string_view::npos)
+                last_ = true;
+            else
+                remaining_.remove_prefix(separator + 1);
+        }
+
+        std::string_view remaining_;
+        std::string_view segment_;
+        bool last_ = true;
+        bool done_ = true;
+    };
+
+    static_path_segment_range() = default;
+
+    constexpr explicit static_path_segment_range(std::string_view path)
+        : path_(path)
+    {
+        if (!path_.empty() && path_.front() == '/')
+            path_.remove_prefix(1);
+    }
+
+    constexpr iterator begin() const { return path_.empty() ? iterator() : iterator(path_); }
+    constexpr iterator end() const { return iterator(); }
+
+private:
+    std::string_view path_;
+};
+
+/** Lazy range over the items of a query, like `query_item_range` with the default separators, usable in constant expressions.
+
+    Items are split at '&' and their key from their value at the first '=', empty items being skipped.
+
+    \ingroup cpp
+*/
+class static_query_item_range
+{
+public:
+    class iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = query_item;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const query_item*;
+        using reference = const query_item&;
+
+        iterator() = default;
+
+        constexpr reference operator*() const { return item_; }
+        constexpr pointer operator->() const { return &item_; }
+
+        constexpr iterator& operator++()
+        {
+            next();
+            return *this;
+        }
+
+        constexpr iterator operator++(int)
+        {
+            iterator previous = *this;
+            next();
+            return previous;
+        }
+
+        friend constexpr bool operator==(const iterator& lhs, const iterator& rhs)
+        {
+            return lhs.done_ == rhs.done_ && (lhs.done_ || lhs.item_.key.data() == rhs.item_.key.data());
+        }
+
+        friend constexpr bool operator!=(const iterator& lhs, const iterator& rhs) { return !(lhs == rhs); }
+
+    private:
+        friend class static_query_item_range;
+
+        constexpr explicit iterator(std::string_view remaining)
+            : remaining_(remaining)
+            , done_(false)
+        {
+            next();
+        }
+
+        constexpr void next()
+        {
+            std::string_view item;
+            while (item.empty())
+            {
+                if (remaining_.empty())
+                {
+                    done_ = true;
+                    item_ = query_item();
+                    return;
+                }
+                const std::size_t separator = remaining_.find('&');
+                item = remaining_.substr(0, separator);
+                remaining_.remove_prefix(separator == std::string_view::npos ? remaining_.size() : separator + 1);
+            }
+
+            const std::size_t keySeparator = item.find('=');
+            item_.key = item.substr(0, keySeparator);
+            if (keySeparator == std::string_view::npos)
+                item_.value.reset();
+            else
+                item_.value = item.substr(keySeparator + 1);
+        }
+
+        std::string_view remaining_;
+        query_item item_;
+        bool done_ = true;
+    };
+
+    static_query_item_range() = default;
+
+    constexpr explicit static_query_item_range(std::string_view query)
+        : query_(query)
+    {
+    }
+
+    constexpr iterator begin() const { return iterator(query_); }
+    constexpr iterator end() const { return iterator(); }
+
+private:
+    std::string_view query_;
+};
+
+/** Non-owning view over the components of a full URI.
+
+    The URI is parsed once, by `curi_parse_full_uri`, at construction, the components being
+    `std::string_view` referencing the parsed string, which must outlive the view. Nothing is
+    allocated and nothing is url decoded.
+
+    \note Empty and missing components can't be told apart, both being empty views.
+
+    \ingroup cpp
+*/
+class uri_view
+{
+public:
+    uri_view() = default;
+
+    explicit uri_view(std::string_view uri) noexcept
+    {
+        curi_settings settings;
+        curi_default_settings(&settings);
+        settings.scheme_callback = &uri_view::on_scheme;
+        settings.userinfo_callback = &uri_view::on_userinfo;
+        settings.host_callback = &uri_view::on_host;
+        settings.host_ipv4_callback = &uri_view::on_host_ipv4;
+        settings.host_ipv6_callback = &uri_view::on_host_ipv6;
+        settings.portStr_callback = &uri_view::on_port;
+        settings.port_callback = &uri_view::on_port_number;
+        settings.path_callback = &uri_view::on_path;
+        settings.query_callback = &uri_view::on_query;
+        settings.fragment_callback = &uri_view::on_fragment;
+
+        status_ = curi_parse_full_uri(uri.data(), uri.size(), &settings, this);
+        if (status_ != curi_status_success)
+            *this = uri_view(status_);
+    }
+
+    curi_status status() const noexcept { return status_; } //!< status of the parsing, the view being empty on failure.
+    explicit operator bool() const noexcept { return status_ == curi_status_success; } //!< true if the URI was successfully parsed.
+
+    std::string_view scheme() const noexcept { return scheme_; }
+    std::string_view userinfo() const noexcept { return userinfo_; }
+    std::string_view host() const noexcept { return host_; }
+    std::string_view port() const noexcept { return port_; }
+    std::string_view path() const noexcept { return path_; }
+    std::string_view query() const noexcept { return query_; }
+    std::string_view fragment() const noexcept { return fragment_; }
+
+    std::optional<std::uint16_t> port_number() const noexcept { return portNumber_; } //!< the port, `std::nullopt` if missing or above 65535.
+    std::optional<std::uint32_t> host_ipv4() const noexcept { return hostIPv4_; } //!< the host in host order, `std::nullopt` if not an IPv4 address.
+    std::optional<std::array<unsigned char, 16> > host_ipv6() const noexcept { return hostIPv6_; } //!< the host in network order, `std::nullopt` if not an IPv6 address.
+
+    path_segment_range segments() const noexcept { return path_segment_range(path_); } //!< lazy range over the path segments.
+    query_item_range query_items() const noexcept { return query_item_range(query_); } //!< lazy range over the query items.
+
+private:
+    explicit uri_view(curi_status status) noexcept
+        : status_(status)
+    {
+    }
+
+    static uri_view& self(void* userData) { return *static_cast<uri_view*>(userData); }
+
+    static int on_scheme(void* userData, const char* str, size_t len) { self(userData).scheme_ = std::string_view(str, len); return 1; }
+    static int on_userinfo(void* userData, const char* str, size_t len) { self(userData).userinfo_ = std::string_view(str, len); return 1; }
+    static int on_host(void* userData, const char* str, size_t len) { self(userData).host_ = std::string_view(str, len); return 1; }
+    static int on_port(void* userData, const char* str, size_t len) { self(userData).port_ = std::string_view(str, len); return 1; }
+    static int on_path(void* userData, const char* str, size_t len) { self(userData).path_ = std::string_view(str, len); return 1; }
+    static int on_query(void* userData, const char* str, size_t len) { self(userData).query_ = std::string_view(str, len); return 1; }
+    static int on_fragment(void* userData, const char* str, size_t len) { self(userData).fragment_ = std::string_view(str, len); return 1; }
+    static int on_port_number(void* userData, unsigned int port) { self(userData).portNumber_ = static_cast<std::uint16_t>(port); return 1; }
+    static int on_host_ipv4(void* userData, unsigned long address) { self(userData).hostIPv4_ = static_cast<std::uint32_t>(address); return 1; }
+
+    static int on_host_ipv6(void* userData, const unsigned char* address)
+    {
+        std::array<unsigned char, 16> bytes;
+        for (std::size_t i = 0 ; i < bytes.size() ; ++i)
+            bytes[i] = address[i];
+        self(userData).hostIPv6_ = bytes;
+        return 1;
+    }
+
+    curi_status status_ = curi_status_error;
+    std::string_view scheme_;
+    std::string_view userinfo_;
+    std::string_view host_;
+    std::string_view port_;
+    std::string_view path_;
+    std::string_view query_;
+    std::string_view fragment_;
+    std::optional<std::uint16_t> portNumber_;
+    std::optional<std::uint32_t> hostIPv4_;
+    std::optional<std::array<unsigned char, 16> > hostIPv6_;
+};
+
+
+/** Components of a URI parsed by `static_parse_full_uri`.
+    \ingroup cpp
+*/
+struct static_uri_components
+{
+    bool valid = false; //!< true if the whole string is a valid full URI, the other members being empty otherwise.
+    std::string_view scheme;
+    std::string_view userinfo;
+    std::string_view host;
+    std::string_view port;
+    std::string_view path;
+    std::string_view query;
+    std::string_view fragment;
+    std::optional<std::uint16_t> port_number; //!< the port, `std::nullopt` if missing or above 65535.
+    std::optional<std::uint32_t> host_ipv4; //!< the host in host order, `std::nullopt` if not an IPv4 address.
+    std::optional<std::array<unsigned char, 16> > host_ipv6; //!< the host in network order, `std::nullopt` if not an IPv6 address.
+};
+
+namespace detail
+{
+
+constexpr bool is_alpha(char c) { return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z'); }
+constexpr bool is_digit(char c) { return c >= '0' && c <= '9'; }
+constexpr bool is_unreserved(char c) { return is_alpha(c) || is_digit(c) || c == '-' || c == '.' || c == '_' || c == '~'; }
+
+constexpr int hexdigit_value(char c)
+{
+    return is_digit(c) ? c - '0' : (c >= 'A' && c <= 'F') ? c - 'A' + 10 : (c >= 'a' && c <= 'f') ? c - 'a' + 10 : -1;
+}
+
+constexpr bool is_sub_delims(char c)
+{
+    switch (c)
+    {
+        case '!': case '$': case '&': case '\'': case '(': case ')':
+        case '*': case '+': case ',': case ';': case '=':
+            return true;
+        default:
+            return false;
+    }
+}
+
+constexpr bool is_userinfo_char(char c) { return is_unreserved(c) || is_sub_delims(c) || c == ':'; }
+constexpr bool is_reg_name_char(char c) { return is_unreserved(c) || is_sub_delims(c); }
+constexpr bool is_path_char(char c) { return is_unreserved(c) || is_sub_delims(c) || c == ':' || c == '@' || c == '/'; }
+constexpr bool is_query_fragment_char(char c) { return is_path_char(c) || c == '?'; }
+
+// Detection of the optional handler methods, `has_<name><Handler, Arg>` and `call_<name>(handler, arg)`,
+// the latter returning false if the handler method returned false, cancelling the parsing
+#define CURI_DETAIL_HANDLER_METHOD(name) \
+    template <class Handler, class Arg, class = void> \
+    struct has_##name : std::false_type {}; \
+    template <class Handler, class Arg> \
+    struct has_##name<Handler, Arg, std::void_t<decltype(std::declval<Handler&>().name(std::declval<Arg>()))> > : std::true_type {}; \
+    template <class Handler, class Arg> \
+    constexpr bool call_##name(Handler& handler, Arg arg) \
+    { \
+        if constexpr (!has_##name<Handler, Arg>::value) \
+            return true; \
+        else if constexpr (std::is_void_v<decltype(handler.name(arg))>) \
+        { \
+            handler.name(arg); \
+            return true; \
+        } \
+        else \
+            return static_cast<bool>(handler.name(arg)); \
+    }
+
+CURI_DETAIL_HANDLER_METHOD(scheme)
+CURI_DETAIL_HANDLER_METHOD(userinfo)
+CURI_DETAIL_HANDLER_METHOD(host)
+CURI_DETAIL_HANDLER_METHOD(host_ipv4)
+CURI_DETAIL_HANDLER_METHOD(host_ipv6)
+CURI_DETAIL_HANDLER_METHOD(port)
+CURI_DETAIL_HANDLER_METHOD(port_number)
+CURI_DETAIL_HANDLER_METHOD(path)
+CURI_DETAIL_HANDLER_METHOD(path_segment)
+CURI_DETAIL_HANDLER_METHOD(query)
+CURI_DETAIL_HANDLER_METHOD(fragment)
+
+#undef CURI_DETAIL_HANDLER_METHOD
+
+typedef std::array<unsigned char, 16> ipv6_address;
+
+template <class T>
+struct identity
+{
+    typedef T type;
+};
+
+struct no_handler
+{
+};
+
+// Port of the parse_full_uri grammar of curi.c, the handler methods being called instead of the
+// callbacks. The work only needed by missing handler methods is compiled out.
+template <class Handler>
+class uri_parser
+{
+public:
+    constexpr uri_parser(std::string_view uri, Handler& handler)
+        : uri_(uri)
+        , offset_(0)
+        , handler_(handler)
+        , status_(curi_status_error)
+    {
+    }
+
+    constexpr curi_status parse_full_uri()
+    {
+        // URI = scheme ":" hier-part [ "?" query ] [ "#" fragment ]
+        if (!parse_scheme() || !accept(':') || !parse_hier_part())
+            return status_;
+
+        if (accept('?') && !call(call_query<Handler, std::string_view>, skip_chars(is_query_fragment_char)))
+            return status_;
+
+        if (accept('#') && !call(call_fragment<Handler, std::string_view>, skip_chars(is_query_fragment_char)))
+            return status_;
+
+        // The URI must be fully consumed, like in curi_parse_full_uri
+        return peek() == '\0' ? curi_status_success : curi_status_error;
+    }
+
+    constexpr bool parse_IPv4address(std::uint32_t& address)
+    {
+        // IPv4address = dec-octet "." dec-octet "." dec-octet "." dec-octet
+        address = 0;
+        for (int i = 0 ; i < 4 ; ++i)
+        {
+            std::uint32_t octet = 0;
+            if ((i > 0 && !accept('.')) || !parse_dec_octet(octet))
+                return false;
+            address = (address << 8) | octet;
+        }
+        return true;
+    }
+
+    constexpr bool at_end() const { return offset_ == uri_.size(); }
+
+private:
+    template <class Arg>
+    constexpr bool call(bool (*method)(Handler&, Arg), typename identity<Arg>::type arg)
+    {
+        if (method(handler_, arg))
+            return true;
+        status_ = curi_status_canceled;
+        return false;
+    }
+
+    constexpr char peek() const { return offset_ < uri_.size() ? uri_[offset_] : '\0'; }
+
+    constexpr bool accept(char c)
+    {
+        if (c == '\0' || peek() != c)
+            return false;
+        ++offset_;
+        return true;
+    }
+
+    constexpr std::string_view span(std::size_t start) const { return uri_.substr(start, offset_ - start); }
+
+    constexpr std::string_view skip_chars(bool (*isChar)(char))
+    {
+        // *( char / "%" h8 )
+        const std::size_t start = offset_;
+        for ( ; ; )
+        {
+            if (isChar(peek()))
+                ++offset_;
+            else if (peek() == '%' && offset_ + 2 < uri_.size() && hexdigit_value(uri_[offset_ + 1]) >= 0 && hexdigit_value(uri_[offset_ + 2]) >= 0)
+                offset_ += 3;
+            else
+                break;
+        }
+        return span(start);
+    }
+
+    constexpr bool parse_scheme()
+    {
+        // scheme = ALPHA *( ALPHA / DIGIT / "+" / "-" / ".")
+        const std::size_t start = offset_;
+        if (!is_alpha(peek()))
+            return false;
+        while (is_alpha(peek()) || is_digit(peek()) || peek() == '+' || peek() == '-' || peek() == '.')
+            ++offset_;
+        return call(call_scheme<Handler, std::string_view>, span(start));
+    }
+
+    constexpr bool parse_hier_part()
+    {
+        // hier-part = "//" authority path-abempty
+        //           / path-absolute / path-rootless / path-empty
+        // As the authority can be empty, the first alternative matches whenever "//" is found.
+        // The path alternatives boil down to the longest sequence of pchar and "/".
+        std::string_view path = uri_.substr(offset_, 0);
+        if (uri_.substr(offset_, 2) == "//")
+        {
+            offset_ += 2;
+            if (!parse_authority())
+                return false;
+            if (peek() == '/')
+                path = skip_chars(is_path_char);
+        }
+        else
+        {
+            path = skip_chars(is_path_char);
+        }
+
+        if constexpr (has_path_segment<Handler, std::string_view>::value)
+        {
+            for (std::string_view segment : static_path_segment_range(path))
+                if (!call(call_path_segment<Handler, std::string_view>, segment))
+                    return false;
+        }
+        return call(call_path<Handler, std::string_view>, path);
+    }
+
+    constexpr bool parse_authority()
+    {
+        // authority = [ userinfo "@" ] host [ ":" port ]
+        const std::size_t start = offset_;
+        const std::string_view userinfo = skip_chars(is_userinfo_char);
+        if (!accept('@'))
+            offset_ = start;
+        else if (!call(call_userinfo<Handler, std::string_view>, userinfo))
+            return false;
+
+        if (!parse_host())
+            return false;
+
+        if (accept(':'))
+        {
+            // port = *DIGIT, the value only growing once above the maximum port
+            const std::size_t portStart = offset_;
+            std::uint32_t port = 0;
+            while (is_digit(peek()))
+            {
+                if constexpr (has_port_number<Handler, std::uint16_t>::value)
+                    if (port <= 65535)
+                        port = port * 10 + static_cast<std::uint32_t>(peek() - '0');
+                ++offset_;
+            }
+            if (!call(call_port<Handler, std::string_view>, span(portStart)))
+                return false;
+            if (offset_ > portStart && port <= 65535 && !call(call_port_number<Handler, std::uint16_t>, static_cast<std::uint16_t>(port)))
+                return false;
+        }
+        return true;
+    }
+
+    constexpr bool parse_host()
+    {
+        // host = IP-literal / IPv4address / reg-name
+        const std::size_t start = offset_;
+        if (peek() == '[')
+        {
+            ipv6_address address = {};
+            int isIPv6 = 0;
+            if (!parse_IP_literal(address, isIPv6))
+            {
+                offset_ = start;
+                isIPv6 = 0;
+            }
+            return call(call_host<Handler, std::string_view>, span(start))
+                && (!isIPv6 || call(call_host_ipv6<Handler, const ipv6_address&>, address));
+        }
+
+        // The host is an IPv4address only if it isn't followed by other reg-name characters
+        const std::string_view host = skip_chars(is_reg_name_char);
+        if (!call(call_host<Handler, std::string_view>, host))
+            return false;
+        if constexpr (has_host_ipv4<Handler, std::uint32_t>::value)
+        {
+            no_handler noHandler;
+            uri_parser<no_handler> ipv4Parser(host, noHandler);
+            std::uint32_t address = 0;
+            if (ipv4Parser.parse_IPv4address(address) && ipv4Parser.at_end())
+                return call(call_host_ipv4<Handler, std::uint32_t>, address);
+        }
+        return true;
+    }
+
+    constexpr bool parse_IP_literal(ipv6_address& address, int& isIPv6)
+    {
+        // IP-literal = "[" ( IPv6address / IPvFuture  ) "]"
+        const std::size_t start = ++offset_;
+        if (parse_IPv6address(address) && accept(']'))
+        {
+            isIPv6 = 1;
+            return true;
+        }
+        offset_ = start;
+        return parse_IPvFuture() && accept(']');
+    }
+
+    constexpr bool parse_IPvFuture()
+    {
+        // IPvFuture = "v" 1*HEXDIG "." 1*( unreserved / sub-delims / ":" )
+        if (!accept('v') || hexdigit_value(peek()) < 0)
+            return false;
+        while (hexdigit_value(peek()) >= 0)
+            ++offset_;
+        if (!accept('.') || !is_userinfo_char(peek()))
+            return false;
+        while (is_userinfo_char(peek()))
+            ++offset_;
+        return true;
+    }
+
+    constexpr bool parse_dec_octet(std::uint32_t& octet)
+    {
+        // 1 to 3 digits, without leading zero, up to 255
+        const std::size_t start = offset_;
+        octet = 0;
+        while (offset_ - start < 3 && is_digit(peek()))
+            octet = octet * 10 + static_cast<std::uint32_t>(uri_[offset_++] - '0');
+        return offset_ > start && octet <= 255 && (offset_ - start == 1 || uri_[start] != '0');
+    }
+
+    constexpr std::size_t parse_h16(unsigned int& value)
+    {
+        // h16 = 1*4HEXDIG
+        std::size_t digitCount = 0;
+        value = 0;
+        for ( ; digitCount < 4 && hexdigit_value(peek()) >= 0 ; ++digitCount)
+            value = (value << 4) | static_cast<unsigned int>(hexdigit_value(uri_[offset_++]));
+        return digitCount;
+    }
+
+    constexpr bool parse_IPv6address(ipv6_address& address)
+    {
+        // A list of h16 separated by ":", see parse_IPv6address in curi.c
+        unsigned int groups[8] = {};
+        std::size_t groupCount = 0;
+        std::size_t compressionIndex = 0;
+        bool compressed = false;
+
+        if (accept(':'))
+        {
+            if (!accept(':'))
+                return false;
+            compressed = true;
+        }
+
+        for ( ; ; )
+        {
+            const std::size_t groupOffset = offset_;
+            unsigned int value = 0;
+
+            if (parse_h16(value) == 0)
+            {
+                // Only allowed right after the compression, ending the address
+                if (compressed && compressionIndex == groupCount)
+                    break;
+                return false;
+            }
+
+            if (peek() == '.')
+            {
+                // ls32 as an IPv4address, ending the address
+                std::uint32_t ipv4Address = 0;
+                offset_ = groupOffset;
+                if (groupCount > 6 || !parse_IPv4address(ipv4Address))
+                    return false;
+                groups[groupCount++] = ipv4Address >> 16;
+                groups[groupCount++] = ipv4Address & 0xFFFF;
+                break;
+            }
+
+            if (groupCount == 8)
+                return false;
+            groups[groupCount++] = value;
+
+            if (!accept(':'))
+                break;
+
+            if (accept(':'))
+            {
+                if (compressed)
+                    return false; // Only one compression allowed
+                compressed = true;
+                compressionIndex = groupCount;
+            }
+        }
+
+        if (compressed ? groupCount > 7 : groupCount != 8)
+            return false;
+
+        if constexpr (has_host_ipv6<Handler, const ipv6_address&>::value)
+        {
+            if (!compressed)
+                compressionIndex = 8;
+
+            // Expanding the compression
+            for (std::size_t i = 0 ; i < 8 ; ++i)
+            {
+                unsigned int value = 0;
+                if (i < compressionIndex)
+                    value = groups[i];
+                else if (i >= compressionIndex + 8 - groupCount)
+                    value = groups[i - (8 - groupCount)];
+                address[2 * i] = static_cast<unsigned char>(value >> 8);
+                address[2 * i + 1] = static_cast<unsigned char>(value & 0xFF);
+            }
+        }
+        return true;
+    }
+
+    std::string_view uri_;
+    std::size_t offset_;
+    Handler& handler_;
+    curi_status status_;
+};
+
+// Handler recording the components of static_parse_full_uri
+struct static_uri_recorder
+{
+    constexpr void scheme(std::string_view str) { components.scheme = str; }
+    constexpr void userinfo(std::string_view str) { components.userinfo = str; }
+    constexpr void host(std::string_view str) { components.host = str; }
+    constexpr void host_ipv4(std::uint32_t address) { components.host_ipv4 = address; }
+    constexpr void host_ipv6(const ipv6_address& address) { components.host_ipv6 = std::optional<ipv6_address>(address); }
+    constexpr void port(std::string_view str) { components.port = str; }
+    constexpr void port_number(std::uint16_t number) { components.port_number = number; }
+    constexpr void path(std::string_view str) { components.path = str; }
+    constexpr void query(std::string_view str) { components.query = str; }
+    constexpr void fragment(std::string_view str) { components.fragment = str; }
+
+    static_uri_components components;
+};
+
+}
+
+/** Parse the given string as a full URI, calling the methods of the given handler.
+
+    The handler methods are all optional, called with the components as found, like the
+    callbacks of `curi_parse_full_uri` with the default settings:
+    - `scheme(std::string_view)`, `userinfo(std::string_view)`, `host(std::string_view)`,
+    - `host_ipv4(std::uint32_t)`, in host order, and `host_ipv6(const std::array<unsigned char, 16>&)`, in network order,
+    - `port(std::string_view)` and `port_number(std::uint16_t)`, when not above 65535,
+    - `path_segment(std::string_view)`, empty segments included, then `path(std::string_view)`,
+    - `query(std::string_view)` and `fragment(std::string_view)`.
+
+    The methods returning `false` stop the parsing, returning `curi_status_canceled`. As they are
+    called statically, they can be inlined, the work needed only by missing methods being compiled out.
+
+    \ingroup cpp
+*/
+template <class Handler>
+constexpr curi_status parse(std::string_view uri, Handler&& handler)
+{
+    return detail::uri_parser<std::remove_reference_t<Handler> >(uri, handler).parse_full_uri();
+}
+
+/** Parse the given string as a full URI, in a constant expression if needed.
+
+    This is a `constexpr` version of `curi_parse_full_uri` with the default settings, recording the
+    spans of the components instead of calling callbacks.
+
+    \ingroup cpp
+*/
+constexpr static_uri_components static_parse_full_uri(std::string_view uri)
+{
+    detail::static_uri_recorder recorder;
+    if (curi::parse(uri, recorder) != curi_status_success)
+        return static_uri_components();
+    recorder.components.valid = true;
+    return recorder.components;
+}
+
+#if defined(__cpp_nontype_template_args) && __cpp_nontype_template_args >= 201911L
+
+/** String literal usable as a template argument.
+    \ingroup cpp
+*/
+template <std::size_t N>
+struct fixed_string
+{
+    constexpr fixed_string(const char (&str)[N])
+    {
+        for (std::size_t i = 0 ; i < N ; ++i)
+            chars[i] = str[i];
+    }
+
+    constexpr std::string_view view() const { return std::string_view(chars, N - 1); }
+
+    char chars[N] = {};
+};
+
+/** URI literal parsed at compile time, a malformed URI failing the build.
+
+    ~~~
+    using upstream = curi::static_uri<"https://api.internal:8443/v2">;
+    static_assert(upstream::host() == "api.internal");
+    ~~~
+
+    \note Requires C++20.
+
+    \ingroup cpp
+*/
+template <fixed_string Uri>
+class static_uri
+{
+public:
+    static constexpr static_uri_components components = static_parse_full_uri(Uri.view());
+    static_assert(components.valid, "malformed URI literal");
+
+    static constexpr std::string_view str() { return Uri.view(); }
+    static constexpr std::string_view scheme() { return components.scheme; }
+    static constexpr std::string_view userinfo() { return components.userinfo; }
+    static constexpr std::string_view host() { return components.host; }
+    static constexpr std::string_view port() { return components.port; }
+    static constexpr std::string_view path() { return components.path; }
+    static constexpr std::string_view query() { return components.query; }
+    static constexpr std::string_view fragment() { return components.fragment; }
+    static constexpr std::optional<std::uint16_t> port_number() { return components.port_number; }
+    static constexpr std::optional<std::uint32_t> host_ipv4() { return components.host_ipv4; }
+    static constexpr std::optional<std::array<unsigned char, 16> > host_ipv6() { return components.host_ipv6; }
+    static constexpr static_path_segment_range segments() { return static_path_segment_range(components.path); }
+    static constexpr static_query_item_range query_items() { return static_query_item_range(components.query); }
+};
+
+#endif
+
+}
+
+#endif
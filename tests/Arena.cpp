@@ -0,0 +1,195 @@
+// Copyright (c) 2013 Clodéric Mars
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "Common.h"
+
+#include <curi.h>
+
+#include <cstring>
+#include <thread>
+
+TEST_CASE("Arena/Allocate", "Allocating from an arena")
+{
+    URI uri;
+    uri.clear();
+
+    curi_settings settings;
+    curi_default_settings(&settings);
+    settings.allocate = test_allocate;
+    settings.deallocate = test_deallocate;
+
+    curi_arena* arena = curi_arena_create(64, &settings, &uri);
+    REQUIRE(arena);
+    const size_t createdMemory = uri.allocatedMemory;
+    CHECK(createdMemory > 64);
+
+    SECTION("Alignment", "")
+    {
+        void* a = curi_arena_allocate(arena, 1);
+        void* b = curi_arena_allocate(arena, 3);
+        void* c = curi_arena_allocate(arena, 8);
+        REQUIRE(a);
+        REQUIRE(b);
+        REQUIRE(c);
+        CHECK(a != b);
+        CHECK(b != c);
+        CHECK((reinterpret_cast<size_t>(a) % sizeof(double)) == 0);
+        CHECK((reinterpret_cast<size_t>(b) % sizeof(double)) == 0);
+        CHECK((reinterpret_cast<size_t>(c) % sizeof(double)) == 0);
+        CHECK(uri.allocatedMemory == createdMemory);
+    }
+
+    SECTION("Chaining", "")
+    {
+        char* a = static_cast<char*>(curi_arena_allocate(arena, 40));
+        char* b = static_cast<char*>(curi_arena_allocate(arena, 40));
+        REQUIRE(a);
+        REQUIRE(b);
+        memset(a, 'a', 40);
+        memset(b, 'b', 40);
+        CHECK(uri.allocatedMemory > createdMemory);
+
+        const size_t chainedMemory = uri.allocatedMemory;
+        char* large = static_cast<char*>(curi_arena_allocate(arena, 1000));
+        REQUIRE(large);
+        memset(large, 'l', 1000);
+        CHECK(uri.allocatedMemory > chainedMemory + 1000);
+        CHECK(a[39] == 'a');
+        CHECK(b[0] == 'b');
+    }
+
+    SECTION("Deallocate", "")
+    {
+        void* a = curi_arena_allocate(arena, 16);
+        void* b = curi_arena_allocate(arena, 16);
+        const size_t usage = curi_arena_usage(arena);
+
+        // Only the latest allocation is reclaimed
+        curi_arena_deallocate(arena, a, 16);
+        CHECK(curi_arena_usage(arena) == usage);
+        curi_arena_deallocate(arena, b, 16);
+        CHECK(curi_arena_usage(arena) < usage);
+        CHECK(curi_arena_allocate(arena, 16) == b);
+        CHECK(uri.deallocatedMemory == 0);
+    }
+
+    SECTION("Reset", "")
+    {
+        curi_arena_allocate(arena, 40);
+        curi_arena_allocate(arena, 40);
+        curi_arena_allocate(arena, 200);
+        const size_t peakUsage = curi_arena_peak_usage(arena);
+        const size_t chainedMemory = uri.allocatedMemory;
+        CHECK(peakUsage >= 280);
+        CHECK(curi_arena_usage(arena) == peakUsage);
+
+        curi_arena_reset(arena);
+        CHECK(curi_arena_usage(arena) == 0);
+        CHECK(curi_arena_peak_usage(arena) == peakUsage);
+
+        // Chunks are reused after a reset
+        curi_arena_allocate(arena, 40);
+        curi_arena_allocate(arena, 40);
+        curi_arena_allocate(arena, 40);
+        CHECK(uri.allocatedMemory == chainedMemory);
+        CHECK(curi_arena_peak_usage(arena) == peakUsage);
+    }
+
+    curi_arena_destroy(arena);
+    CHECK(uri.allocatedMemory == uri.deallocatedMemory);
+}
+
+static int ignoredPath(void* userData, const char* path, size_t pathLen)
+{
+    return 1;
+}
+
+TEST_CASE("Arena/Parse", "Using arenas as parsing allocator")
+{
+    URI uri;
+    uri.clear();
+
+    curi_settings settings;
+    curi_default_settings(&settings);
+    settings.host_callback = host;
+    settings.path_callback = path;
+    settings.query_callback = query;
+    settings.url_decode = 1;
+
+    curi_arena* arena = curi_arena_create(256, 0, 0);
+    REQUIRE(arena);
+
+    SECTION("UserData", "")
+    {
+        // The arena being the user data, callbacks can't use it
+        curi_default_settings(&settings);
+        settings.path_callback = ignoredPath;
+        settings.path_normalization = curi_path_remove_dot_segments;
+        settings.allocate = curi_arena_allocate;
+        settings.deallocate = curi_arena_deallocate;
+        CHECK(curi_status_success == curi_parse_full_uri_nt("http://example.com/a/../path", &settings, arena));
+        CHECK(curi_arena_usage(arena) == 0);
+        CHECK(curi_arena_peak_usage(arena) > 0);
+    }
+
+    SECTION("ThreadArena", "")
+    {
+        settings.allocate = curi_thread_arena_allocate;
+        settings.deallocate = curi_thread_arena_deallocate;
+        CHECK(curi_arena_thread_arena() == 0);
+
+        curi_arena_set_thread_arena(arena);
+        CHECK(curi_arena_thread_arena() == arena);
+        CHECK(curi_status_success == curi_parse_full_uri_nt("http://example.com/a%20path?a%20query", &settings, &uri));
+        CHECK(uri.path == "/a path");
+        CHECK(uri.query == "a query");
+        CHECK(curi_arena_peak_usage(arena) > 0);
+
+        curi_arena* otherThreadArena = arena;
+        std::thread thread([&otherThreadArena]() { otherThreadArena = curi_arena_thread_arena(); });
+        thread.join();
+        CHECK(otherThreadArena == 0);
+
+        curi_arena_set_thread_arena(0);
+    }
+
+    SECTION("NoThreadArena", "")
+    {
+        // Allocations fail without a thread arena, making the parsing fail
+        settings.allocate = curi_thread_arena_allocate;
+        settings.deallocate = curi_thread_arena_deallocate;
+        settings.query_item_str_callback = queryStrItem;
+        REQUIRE(curi_arena_thread_arena() == 0);
+
+        CHECK(curi_status_error == curi_parse_full_uri_nt("http://%41b.com/", &settings, &uri));
+        CHECK(uri.host.empty());
+        CHECK(curi_status_error == curi_parse_path_nt("/a%20path", &settings, &uri));
+        CHECK(uri.path.empty());
+        CHECK(curi_status_error == curi_parse_query_nt("a=b", &settings, &uri));
+        CHECK(uri.queryStrItems.empty());
+
+        settings.url_decode = 0;
+        settings.path_normalization = curi_path_remove_dot_segments;
+        CHECK(curi_status_error == curi_parse_path_nt("/a/../path", &settings, &uri));
+        CHECK(uri.path.empty());
+    }
+
+    curi_arena_destroy(arena);
+}
@@ -37,8 +37,14 @@ struct URI
     std::string scheme;
     std::string userinfo;
     std::string host;
+    unsigned long hostIPv4;
+    std::vector<unsigned char> hostIPv6;
+    unsigned int hostId;
+    std::string internedHost;
+    std::string registrableDomain;
     std::string portStr;
     unsigned int port;
+    std::string invalidPortStr;
     std::string path;
     std::vector<std::string> pathSegments;
     std::string query;
@@ -55,8 +61,14 @@ struct URI
         scheme.clear();
         userinfo.clear();
         host.clear();
+        hostIPv4 = 0;
+        hostIPv6.clear();
+        hostId = 0;
+        internedHost.clear();
+        registrableDomain.clear();
         port = 0;
         portStr.clear();
+        invalidPortStr.clear();
         path.clear();
         pathSegments.clear();
         query.clear();
@@ -75,7 +87,12 @@ extern "C"
     int scheme(void* userData, const char* scheme, size_t schemeLen);
     int userinfo(void* userData, const char* userinfo, size_t userinfoLen);
     int host(void* userData, const char* host, size_t hostLen);
+    int hostIPv4(void* userData, unsigned long address);
+    int hostIPv6(void* userData, const unsigned char* address);
+    int hostId(void* userData, unsigned int hostId, const char* host, size_t hostLen);
+    int registrableDomain(void* userData, const char* domain, size_t domainLen);
     int portStr(void* userData, const char* port, size_t portLen);
+    int invalidPortStr(void* userData, const char* port, size_t portLen);
     int path(void* userData, const char* path, size_t pathLen);
     int pathSegment(void* userData, const char* pathSegment, size_t pathSegmentLen);
     int query(void* userData, const char* query, size_t queryLen);
@@ -92,10 +109,22 @@ extern "C"
     {
         return 0;
     }
+    inline int cancellingCallbackBytes(void* userData, const unsigned char* bytes)
+    {
+        return 0;
+    }
+    inline int cancellingCallbackUlong(void* userData, unsigned long ulong)
+    {
+        return 0;
+    }
     inline int cancellingCallbackUint(void* userData, unsigned int uint)
     {
         return 0;
     }
+    inline int cancellingCallbackSizeT(void* userData, size_t sizeT)
+    {
+        return 0;
+    }
     inline int cancellingCallbackStrLongInt(void* userData, const char* str, size_t strLen, long int longint)
     {
         return 0;
@@ -142,6 +171,36 @@ inline int host(void* userData, const char* host, size_t hostLen)
     return 1;
 }
 
+inline int hostIPv4(void* userData, unsigned long address)
+{
+    CAPTURE(address);
+    static_cast<URI*>(userData)->hostIPv4 = address;
+    return 1;
+}
+
+inline int hostIPv6(void* userData, const unsigned char* address)
+{
+    static_cast<URI*>(userData)->hostIPv6.assign(address, address + 16);
+    return 1;
+}
+
+inline int hostId(void* userData, unsigned int hostId, const char* host, size_t hostLen)
+{
+    CAPTURE(hostId);
+    CAPTURE(host);
+    static_cast<URI*>(userData)->hostId = hostId;
+    static_cast<URI*>(userData)->internedHost.assign(host,hostLen);
+    return 1;
+}
+
+inline int registrableDomain(void* userData, const char* domain, size_t domainLen)
+{
+    CAPTURE(domain);
+    CAPTURE(domainLen);
+    static_cast<URI*>(userData)->registrableDomain.assign(domain,domainLen);
+    return 1;
+}
+
 inline int port(void* userData, unsigned int port)
 {
     CAPTURE(port);
@@ -157,6 +216,14 @@ inline int portStr(void* userData, const char* portStr, size_t portStrLen)
     return 1;
 }
 
+inline int invalidPortStr(void* userData, const char* portStr, size_t portStrLen)
+{
+    CAPTURE(portStr);
+    CAPTURE(portStrLen);
+    static_cast<URI*>(userData)->invalidPortStr.assign(portStr,portStrLen);
+    return 1;
+}
+
 inline int path(void* userData, const char* path, size_t pathLen)
 {
     CAPTURE(path);
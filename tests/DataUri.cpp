@@ -0,0 +1,276 @@
+// Copyright (c) 2013 Clodéric Mars
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "Common.h"
+
+#include <curi.h>
+
+#include <cstring>
+
+static std::string str(const char* s, size_t len)
+{
+    return s ? std::string(s, len) : std::string();
+}
+
+TEST_CASE("DataUri/Parse", "Elements of data URIs")
+{
+    curi_data_uri dataUri;
+
+    SECTION("Base64", "")
+    {
+        const std::string uri("data:image/png;base64,iVBORw0KGgo=");
+
+        CHECK(curi_status_success == curi_parse_data_uri(uri.c_str(), uri.length(), &dataUri, 0, 0, 0));
+
+        CHECK(str(dataUri.mediaType, dataUri.mediaTypeLen) == "image/png");
+        CHECK(dataUri.parametersLen == 0);
+        CHECK(dataUri.base64);
+        CHECK(str(dataUri.data, dataUri.dataLen) == "iVBORw0KGgo=");
+    }
+
+    SECTION("Parameters", "")
+    {
+        const std::string uri("DATA:text/plain;charset=iso-8859-7;name=greek;BASE64,vOzl");
+
+        CHECK(curi_status_success == curi_parse_data_uri(uri.c_str(), uri.length(), &dataUri, 0, 0, 0));
+
+        CHECK(str(dataUri.mediaType, dataUri.mediaTypeLen) == "text/plain");
+        CHECK(str(dataUri.parameters, dataUri.parametersLen) == "charset=iso-8859-7;name=greek");
+        CHECK(dataUri.base64);
+        CHECK(str(dataUri.data, dataUri.dataLen) == "vOzl");
+
+        curi_settings settings;
+        curi_default_settings(&settings);
+        settings.query_item_separator = ';';
+
+        curi_query_iter iter;
+        curi_query_item item;
+        curi_query_iter_init(&iter, dataUri.parameters, dataUri.parametersLen, &settings);
+
+        REQUIRE(curi_query_iter_next(&iter, &item));
+        CHECK(str(item.key, item.keyLen) == "charset");
+        CHECK(str(item.value, item.valueLen) == "iso-8859-7");
+        REQUIRE(curi_query_iter_next(&iter, &item));
+        CHECK(str(item.key, item.keyLen) == "name");
+        CHECK(str(item.value, item.valueLen) == "greek");
+        CHECK(!curi_query_iter_next(&iter, &item));
+    }
+
+    SECTION("NoMediaType", "")
+    {
+        const std::string uri("data:,A%20brief%20note");
+
+        CHECK(curi_status_success == curi_parse_data_uri(uri.c_str(), uri.length(), &dataUri, 0, 0, 0));
+
+        CHECK(dataUri.mediaTypeLen == 0);
+        CHECK(dataUri.parametersLen == 0);
+        CHECK(!dataUri.base64);
+        CHECK(str(dataUri.data, dataUri.dataLen) == "A%20brief%20note");
+    }
+
+    SECTION("ParametersOnly", "")
+    {
+        const std::string uri("data:;charset=utf-8,hello");
+
+        CHECK(curi_status_success == curi_parse_data_uri(uri.c_str(), uri.length(), &dataUri, 0, 0, 0));
+
+        CHECK(dataUri.mediaTypeLen == 0);
+        CHECK(str(dataUri.parameters, dataUri.parametersLen) == "charset=utf-8");
+    }
+
+    SECTION("Errors", "")
+    {
+        const char* uris[] = {
+            "http:,hello",
+            "dat",
+            "data:text,hello",
+            "data:text/,hello",
+            "data:text/plain;charset,hello",
+            "data:text/plain;charset=,hello",
+            "data:text/plain;base64;charset=utf-8,aGVsbG8=",
+            "data:text/plain"
+        };
+        size_t i;
+
+        for (i = 0 ; i < sizeof(uris) / sizeof(uris[0]) ; ++i)
+        {
+            INFO(uris[i]);
+            CHECK(curi_status_error == curi_parse_data_uri(uris[i], SIZE_MAX, &dataUri, 0, 0, 0));
+        }
+    }
+}
+
+TEST_CASE("DataUri/Decode", "Decoding the data of data URIs")
+{
+    char output[256];
+    size_t outputLen = 0;
+
+    SECTION("Base64", "")
+    {
+        const char* encoded[] = {"data:;base64,", "data:;base64,Zg==", "data:;base64,Zm8=", "data:;base64,Zm9v", "data:;base64,Zm9vYg==", "data:;base64,Zm9vYmE=", "data:;base64,Zm9vYmFy"};
+        const char* decoded[] = {"", "f", "fo", "foo", "foob", "fooba", "foobar"};
+        size_t i;
+
+        for (i = 0 ; i < sizeof(encoded) / sizeof(encoded[0]) ; ++i)
+        {
+            INFO(encoded[i]);
+            CHECK(curi_status_success == curi_parse_data_uri(encoded[i], strlen(encoded[i]), 0, output, sizeof(output), &outputLen));
+            CHECK(std::string(output, outputLen) == decoded[i]);
+        }
+    }
+
+    SECTION("Base64Unpadded", "")
+    {
+        const std::string uri("data:;base64,Zm9vYg");
+
+        CHECK(curi_status_success == curi_parse_data_uri(uri.c_str(), uri.length(), 0, output, sizeof(output), &outputLen));
+
+        CHECK(std::string(output, outputLen) == "foob");
+    }
+
+    SECTION("Base64Binary", "")
+    {
+        const std::string uri("data:application/octet-stream;base64,AP8Qf4A=");
+
+        CHECK(curi_status_success == curi_parse_data_uri(uri.c_str(), uri.length(), 0, output, sizeof(output), &outputLen));
+
+        REQUIRE(outputLen == 5);
+        CHECK((unsigned char)output[0] == 0x00);
+        CHECK((unsigned char)output[1] == 0xFF);
+        CHECK((unsigned char)output[2] == 0x10);
+        CHECK((unsigned char)output[3] == 0x7F);
+        CHECK((unsigned char)output[4] == 0x80);
+    }
+
+    SECTION("Base64Errors", "")
+    {
+        const char* uris[] = {"data:;base64,Z", "data:;base64,Zm9vY", "data:;base64,=m9v", "data:;base64,Zg=", "data:;base64,Zg===", "data:;base64,Zg==Zg==", "data:;base64,Zm9v%20", "data:;base64,Zm-_"};
+        size_t i;
+
+        for (i = 0 ; i < sizeof(uris) / sizeof(uris[0]) ; ++i)
+        {
+            INFO(uris[i]);
+            CHECK(curi_status_error == curi_parse_data_uri(uris[i], strlen(uris[i]), 0, output, sizeof(output), &outputLen));
+        }
+    }
+
+    SECTION("Percent", "")
+    {
+        const std::string uri("data:,A%20brief%20note%00%ff");
+
+        CHECK(curi_status_success == curi_parse_data_uri(uri.c_str(), uri.length(), 0, output, sizeof(output), &outputLen));
+
+        CHECK(std::string(output, outputLen) == std::string("A brief note\0\xff", 14));
+    }
+
+    SECTION("PercentErrors", "")
+    {
+        const char* uris[] = {"data:,%", "data:,%2", "data:,%zz", "data:,a b", "data:,a#b"};
+        size_t i;
+
+        for (i = 0 ; i < sizeof(uris) / sizeof(uris[0]) ; ++i)
+        {
+            INFO(uris[i]);
+            CHECK(curi_status_error == curi_parse_data_uri(uris[i], strlen(uris[i]), 0, output, sizeof(output), &outputLen));
+        }
+    }
+
+    SECTION("OutputCapacity", "")
+    {
+        const std::string base64Uri("data:;base64,Zm9vYmFy");
+        const std::string percentUri("data:,foo%20bar");
+
+        CHECK(curi_status_error == curi_parse_data_uri(base64Uri.c_str(), base64Uri.length(), 0, output, 5, &outputLen));
+        CHECK(curi_status_success == curi_parse_data_uri(base64Uri.c_str(), base64Uri.length(), 0, output, 6, &outputLen));
+        CHECK(curi_status_error == curi_parse_data_uri(percentUri.c_str(), percentUri.length(), 0, output, 6, &outputLen));
+        CHECK(curi_status_success == curi_parse_data_uri(percentUri.c_str(), percentUri.length(), 0, output, 7, &outputLen));
+    }
+}
+
+TEST_CASE("DataUri/Stream", "Decoding the data of data URIs by chunks")
+{
+    SECTION("Base64", "")
+    {
+        const std::string data("SGVsbG8sIFdvcmxkIQ==");
+        const std::string expected("Hello, World!");
+        size_t chunkLen;
+
+        for (chunkLen = 1 ; chunkLen <= data.length() ; ++chunkLen)
+        {
+            curi_data_decoder decoder;
+            std::string decoded;
+            size_t offset;
+
+            curi_data_decoder_init(&decoder, 1);
+
+            for (offset = 0 ; offset < data.length() ; offset += chunkLen)
+            {
+                const size_t len = std::min(chunkLen, data.length() - offset);
+                char output[32];
+                size_t outputLen = 0;
+
+                REQUIRE(curi_status_success == curi_data_decoder_decode(&decoder, data.c_str() + offset, len, output, len, &outputLen));
+                decoded.append(output, outputLen);
+            }
+
+            CHECK(curi_status_success == curi_data_decoder_finish(&decoder));
+            CHECK(decoded == expected);
+        }
+    }
+
+    SECTION("Percent", "")
+    {
+        const std::string data("a%20b%2Fc%25");
+        const std::string expected("a b/c%");
+        size_t chunkLen;
+
+        for (chunkLen = 1 ; chunkLen <= data.length() ; ++chunkLen)
+        {
+            curi_data_decoder decoder;
+            std::string decoded;
+            size_t offset;
+
+            curi_data_decoder_init(&decoder, 0);
+
+            for (offset = 0 ; offset < data.length() ; offset += chunkLen)
+            {
+                const size_t len = std::min(chunkLen, data.length() - offset);
+                char output[32];
+                size_t outputLen = 0;
+
+                REQUIRE(curi_status_success == curi_data_decoder_decode(&decoder, data.c_str() + offset, len, output, len, &outputLen));
+                decoded.append(output, outputLen);
+            }
+
+            CHECK(curi_status_success == curi_data_decoder_finish(&decoder));
+            CHECK(decoded == expected);
+        }
+    }
+
+    SECTION("Incomplete", "")
+    {
+        curi_data_decoder decoder;
+        char output[8];
+
+        curi_data_decoder_init(&decoder, 0);
+        CHECK(curi_status_success == curi_data_decoder_decode(&decoder, "a%2", 3, output, sizeof(output), 0));
+        CHECK(curi_status_error == curi_data_decoder_finish(&decoder));
+    }
+}
@@ -0,0 +1,201 @@
+// Copyright (c) 2013 Clodéric Mars
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "Common.h"
+
+#include <curi.h>
+
+#include <cstdint>
+#include <thread>
+
+static int ignoredQueryItem(void* userData, const char* key, size_t keyLen, const char* value, size_t valueLen)
+{
+    return 1;
+}
+
+static curi_error parseError(const char* uri, curi_settings* settings)
+{
+    curi_error error;
+    CHECK(curi_status_error == curi_parse_full_uri_with_error(uri, SIZE_MAX, &error, settings, 0));
+    return error;
+}
+
+TEST_CASE("Errors/FullUri", "Reporting the position and reason of errors")
+{
+    curi_settings settings;
+    curi_default_settings(&settings);
+
+    SECTION("Scheme", "")
+    {
+        curi_error error = parseError("1http://example.com/", &settings);
+        CHECK(error.rule == curi_error_scheme);
+        CHECK(error.offset == 0);
+        CHECK(error.character == '1');
+
+        error = parseError("http//example.com/", &settings);
+        CHECK(error.rule == curi_error_scheme);
+        CHECK(error.offset == 4);
+        CHECK(error.character == '/');
+
+        error = parseError("http", &settings);
+        CHECK(error.rule == curi_error_scheme);
+        CHECK(error.offset == 4);
+        CHECK(error.character == '\0');
+    }
+
+    SECTION("Authority", "")
+    {
+        curi_error error = parseError("http://www.example.com:port/", &settings);
+        CHECK(error.rule == curi_error_authority);
+        CHECK(error.offset == 23);
+        CHECK(error.character == 'p');
+
+        error = parseError("http://a@b@c/", &settings);
+        CHECK(error.rule == curi_error_authority);
+        CHECK(error.offset == 10);
+        CHECK(error.character == '@');
+    }
+
+    SECTION("IPLiteral", "")
+    {
+        curi_error error = parseError("http://[::1/", &settings);
+        CHECK(error.rule == curi_error_ip_literal);
+        CHECK(error.offset == 7);
+        CHECK(error.character == '[');
+
+        error = parseError("http://user@[1::2::3]:80/", &settings);
+        CHECK(error.rule == curi_error_ip_literal);
+        CHECK(error.offset == 12);
+    }
+
+    SECTION("PercentEncoding", "")
+    {
+        curi_error error = parseError("http://example.com/a%zz", &settings);
+        CHECK(error.rule == curi_error_percent_encoding);
+        CHECK(error.offset == 20);
+        CHECK(error.character == '%');
+
+        error = parseError("http://us%er@example.com/", &settings);
+        CHECK(error.rule == curi_error_percent_encoding);
+        CHECK(error.offset == 9);
+
+        error = parseError("http://example.com/#%4", &settings);
+        CHECK(error.rule == curi_error_percent_encoding);
+        CHECK(error.offset == 20);
+
+        settings.query_item_str_callback = ignoredQueryItem;
+        error = parseError("http://example.com/?a=1&b=%g0", &settings);
+        CHECK(error.rule == curi_error_percent_encoding);
+        CHECK(error.offset == 26);
+    }
+
+    SECTION("TrailingCharacters", "")
+    {
+        curi_error error = parseError("http://example.com/a b", &settings);
+        CHECK(error.rule == curi_error_trailing_characters);
+        CHECK(error.offset == 20);
+        CHECK(error.character == ' ');
+
+        error = parseError("http://example.com/?q#f#", &settings);
+        CHECK(error.rule == curi_error_trailing_characters);
+        CHECK(error.offset == 23);
+        CHECK(error.character == '#');
+    }
+
+    SECTION("Success", "")
+    {
+        curi_error error;
+        error.rule = curi_error_scheme;
+        CHECK(curi_status_success == curi_parse_full_uri_with_error("http://user:pass@[::1]:80/a%20b?q#f", SIZE_MAX, &error, &settings, 0));
+        CHECK(error.rule == curi_error_none);
+    }
+}
+
+TEST_CASE("Errors/PathAndQuery", "Reporting errors of paths and queries")
+{
+    curi_error error;
+    curi_settings settings;
+    curi_default_settings(&settings);
+
+    CHECK(curi_status_error == curi_parse_path_with_error("//a", 3, &error, &settings, 0));
+    CHECK(error.rule == curi_error_trailing_characters);
+    CHECK(error.offset == 1);
+
+    CHECK(curi_status_error == curi_parse_path_with_error("/a/%x", 5, &error, 0, 0));
+    CHECK(error.rule == curi_error_percent_encoding);
+    CHECK(error.offset == 3);
+
+    CHECK(curi_status_error == curi_parse_query_with_error("a=1#", SIZE_MAX, &error, &settings, 0));
+    CHECK(error.rule == curi_error_trailing_characters);
+    CHECK(error.offset == 3);
+    CHECK(error.character == '#');
+}
+
+TEST_CASE("Errors/Success", "No error reported by successful parsings")
+{
+    curi_error error;
+    curi_settings settings;
+    curi_default_settings(&settings);
+
+    // Authorities followed by a space are first recorded as errors while parsing request lines
+    CHECK(curi_status_success == curi_parse_request_line_nt("CONNECT www.example.com:443 HTTP/1.1", 0, &error, &settings, 0));
+    CHECK(error.rule == curi_error_none);
+
+    CHECK(curi_status_success == curi_parse_request_line_nt("GET http://a.com HTTP/1.1", 0, &error, &settings, 0));
+    CHECK(error.rule == curi_error_none);
+
+    CHECK(curi_status_error == curi_parse_full_uri_with_error("http://a.com b", SIZE_MAX, &error, &settings, 0));
+    CHECK(error.rule == curi_error_authority);
+
+    CHECK(curi_status_success == curi_parse_uri_reference_nt("//a.com/b", 0, &error, &settings, 0));
+    CHECK(error.rule == curi_error_none);
+    CHECK(error.offset == 0);
+}
+
+TEST_CASE("Errors/Threads", "Sharing settings between threads reporting errors")
+{
+    curi_settings settings;
+    curi_default_settings(&settings);
+
+    std::vector<std::thread> threads;
+    std::vector<int> failures(4, 0);
+
+    for (size_t t = 0 ; t < failures.size() ; ++t)
+    {
+        threads.push_back(std::thread([&settings, t, &failures]()
+        {
+            // Each thread fails at a different offset
+            const std::string uri = "http://example.com/" + std::string(t, 'a') + "%zz";
+            for (int i = 0 ; i < 1000 ; ++i)
+            {
+                curi_error error;
+                if (curi_parse_full_uri_with_error(uri.c_str(), uri.length(), &error, &settings, 0) != curi_status_error
+                    || error.rule != curi_error_percent_encoding || error.offset != 19 + t)
+                    ++failures[t];
+            }
+        }));
+    }
+
+    for (size_t t = 0 ; t < threads.size() ; ++t)
+    {
+        threads[t].join();
+        CHECK(failures[t] == 0);
+    }
+}
@@ -0,0 +1,243 @@
+// Copyright (c) 2013 Clodéric Mars
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "Common.h"
+
+#include <curi.h>
+
+#include <thread>
+
+static std::string getHost(const curi_host_table* table, unsigned int hostId)
+{
+    char output[CURI_HOST_TABLE_MAX_HOST_LENGTH];
+    size_t outputLen = 0;
+    REQUIRE(curi_status_success == curi_host_table_get(table, hostId, output, sizeof(output), &outputLen));
+    return std::string(output, outputLen);
+}
+
+static unsigned int intern(curi_host_table* table, const std::string& host)
+{
+    unsigned int hostId = 0;
+    REQUIRE(curi_status_success == curi_host_table_intern(table, host.c_str(), host.length(), &hostId));
+    return hostId;
+}
+
+static std::string numberedHost(int i)
+{
+    return "host" + std::to_string(i) + ".example.com";
+}
+
+TEST_CASE("HostTable/Intern", "Host interning")
+{
+    URI uri;
+    uri.clear();
+
+    curi_settings settings;
+    curi_default_settings(&settings);
+    settings.allocate = test_allocate;
+    settings.deallocate = test_deallocate;
+
+    curi_host_table* table = curi_host_table_create(64, &settings, &uri);
+    REQUIRE(table);
+    CHECK(uri.allocatedMemory > 0);
+    CHECK(curi_host_table_capacity(table) >= 64);
+
+    SECTION("Ids", "")
+    {
+        const unsigned int exampleId = intern(table, "www.example.com");
+        const unsigned int otherId = intern(table, "other.example.com");
+
+        CHECK(exampleId != otherId);
+        CHECK(exampleId < curi_host_table_capacity(table));
+        CHECK(otherId < curi_host_table_capacity(table));
+        CHECK(intern(table, "WWW.Example.COM") == exampleId);
+        CHECK(intern(table, "www.example.com") == exampleId);
+        CHECK(getHost(table, exampleId) == "www.example.com");
+        CHECK(getHost(table, otherId) == "other.example.com");
+    }
+
+    SECTION("Errors", "")
+    {
+        unsigned int hostId;
+        char output[CURI_HOST_TABLE_MAX_HOST_LENGTH];
+        const std::string tooLong(CURI_HOST_TABLE_MAX_HOST_LENGTH + 1, 'a');
+
+        CHECK(curi_status_error == curi_host_table_intern(table, "", 0, &hostId));
+        CHECK(curi_status_error == curi_host_table_intern(table, tooLong.c_str(), tooLong.length(), &hostId));
+        CHECK(curi_status_error == curi_host_table_get(table, 0, output, sizeof(output), 0));
+        CHECK(curi_status_error == curi_host_table_get(table, (unsigned int)curi_host_table_capacity(table), output, sizeof(output), 0));
+
+        hostId = intern(table, "www.example.com");
+        CHECK(curi_status_error == curi_host_table_get(table, hostId, output, 3, 0));
+    }
+
+    SECTION("Eviction", "")
+    {
+        const size_t capacity = curi_host_table_capacity(table);
+
+        for (size_t i = 0 ; i < 10 * capacity ; ++i)
+        {
+            const std::string host = numberedHost((int)i);
+            const unsigned int hostId = intern(table, host);
+            CHECK(hostId < capacity);
+            CHECK(getHost(table, hostId) == host);
+            CHECK(intern(table, host) == hostId);
+        }
+    }
+
+    curi_host_table_destroy(table);
+    CHECK(uri.deallocatedMemory == uri.allocatedMemory);
+}
+
+TEST_CASE("HostTable/Threads", "Host interning from several threads")
+{
+    std::vector<std::thread> threads;
+    std::vector<int> failures(4, 0);
+
+    SECTION("Stable", "")
+    {
+        curi_host_table* table = curi_host_table_create(1024, 0, 0);
+        REQUIRE(table);
+
+        std::vector<std::vector<unsigned int> > hostIds(failures.size(), std::vector<unsigned int>(128, 0));
+        for (size_t t = 0 ; t < failures.size() ; ++t)
+        {
+            threads.push_back(std::thread([table, t, &failures, &hostIds]()
+            {
+                for (int i = 0 ; i < 10000 ; ++i)
+                {
+                    const std::string host = numberedHost(i % 128);
+                    unsigned int hostId;
+
+                    if (curi_host_table_intern(table, host.c_str(), host.length(), &hostId) != curi_status_success)
+                        ++failures[t];
+                    else if (i >= 128 && hostId != hostIds[t][i % 128])
+                        ++failures[t];
+                    hostIds[t][i % 128] = hostId;
+                }
+            }));
+        }
+
+        for (size_t t = 0 ; t < threads.size() ; ++t)
+        {
+            threads[t].join();
+            CHECK(failures[t] == 0);
+            CHECK(hostIds[t] == hostIds[0]);
+        }
+
+        for (int i = 0 ; i < 128 ; ++i)
+            CHECK(getHost(table, hostIds[0][i]) == numberedHost(i));
+
+        curi_host_table_destroy(table);
+    }
+
+    SECTION("Eviction", "")
+    {
+        curi_host_table* table = curi_host_table_create(64, 0, 0);
+        REQUIRE(table);
+
+        for (size_t t = 0 ; t < failures.size() ; ++t)
+        {
+            threads.push_back(std::thread([table, t, &failures]()
+            {
+                for (int i = 0 ; i < 10000 ; ++i)
+                {
+                    const std::string host = numberedHost((i * 7 + (int)t) % 1024);
+                    unsigned int hostId;
+                    char output[CURI_HOST_TABLE_MAX_HOST_LENGTH];
+                    size_t outputLen;
+
+                    if (curi_host_table_intern(table, host.c_str(), host.length(), &hostId) != curi_status_success)
+                        ++failures[t];
+                    // The host might have been evicted by another thread since, but the ID stays valid
+                    else if (curi_host_table_get(table, hostId, output, sizeof(output), &outputLen) != curi_status_success)
+                        ++failures[t];
+                }
+            }));
+        }
+
+        for (size_t t = 0 ; t < threads.size() ; ++t)
+        {
+            threads[t].join();
+            CHECK(failures[t] == 0);
+        }
+
+        curi_host_table_destroy(table);
+    }
+}
+
+TEST_CASE("HostTable/Parse", "Host interning while parsing")
+{
+    URI uri;
+    uri.clear();
+
+    curi_settings settings;
+    curi_default_settings(&settings);
+    settings.host_callback = host;
+    settings.host_id_callback = hostId;
+    settings.host_table = curi_host_table_create(16, 0, 0);
+    REQUIRE(settings.host_table);
+
+    SECTION("RegName", "")
+    {
+        CHECK(curi_status_success == curi_parse_full_uri_nt("http://WWW.Example.com/Path", &settings, &uri));
+        CHECK(uri.host == "WWW.Example.com");
+        CHECK(uri.internedHost == "www.example.com");
+        const unsigned int exampleId = uri.hostId;
+
+        CHECK(curi_status_success == curi_parse_full_uri_nt("http://www.example.COM:8080/", &settings, &uri));
+        CHECK(uri.hostId == exampleId);
+
+        CHECK(curi_status_success == curi_parse_full_uri_nt("http://other.example.com/", &settings, &uri));
+        CHECK(uri.hostId != exampleId);
+        CHECK(uri.internedHost == "other.example.com");
+    }
+
+    SECTION("Normalized", "")
+    {
+        settings.host_normalization = curi_host_to_unicode;
+        CHECK(curi_status_success == curi_parse_full_uri_nt("http://WWW.xn--bcher-kva.Example/Path", &settings, &uri));
+        CHECK(uri.internedHost == "www.b\xC3\xBC" "cher.example");
+    }
+
+    SECTION("UrlDecoded", "")
+    {
+        settings.url_decode = 1;
+        CHECK(curi_status_success == curi_parse_full_uri_nt("http://%57WW.Example/Path", &settings, &uri));
+        CHECK(uri.internedHost == "www.example");
+    }
+
+    SECTION("TooLong", "")
+    {
+        const std::string longHost(CURI_HOST_TABLE_MAX_HOST_LENGTH + 45, 'a');
+        const std::string uriStr = "http://" + longHost + "/Path";
+        CHECK(curi_status_success == curi_parse_full_uri_nt(uriStr.c_str(), &settings, &uri));
+        CHECK(uri.host == longHost);
+        CHECK(uri.internedHost.empty());
+    }
+
+    SECTION("Cancelled", "")
+    {
+        settings.host_id_callback = [](void*, unsigned int, const char*, size_t) { return 0; };
+        CHECK(curi_status_canceled == curi_parse_full_uri_nt("http://www.example.com/Path", &settings, &uri));
+    }
+
+    curi_host_table_destroy(settings.host_table);
+}
@@ -0,0 +1,181 @@
+// Copyright (c) 2013 Clodéric Mars
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "Common.h"
+
+#include <curi.h>
+
+#include <cstring>
+
+static std::vector<std::string> segments(const char* path, size_t len)
+{
+    std::vector<std::string> result;
+    curi_segment_iter iter;
+    const char* segment;
+    size_t segmentLen;
+
+    curi_segment_iter_init(&iter, path, len);
+    while (curi_segment_iter_next(&iter, &segment, &segmentLen))
+        result.push_back(std::string(segment, segmentLen));
+    return result;
+}
+
+static std::vector<std::string> segments(const char* path)
+{
+    return segments(path, strlen(path));
+}
+
+TEST_CASE("Iterators/Segments", "Iterating over path segments")
+{
+    SECTION("Absolute", "")
+    {
+        const std::vector<std::string> result = segments("/my/taylor/");
+        REQUIRE(result.size() == 3);
+        CHECK(result[0] == "my");
+        CHECK(result[1] == "taylor");
+        CHECK(result[2] == "");
+    }
+
+    SECTION("Relative", "")
+    {
+        const std::vector<std::string> result = segments("my//rich");
+        REQUIRE(result.size() == 3);
+        CHECK(result[0] == "my");
+        CHECK(result[1] == "");
+        CHECK(result[2] == "rich");
+    }
+
+    SECTION("Empty", "")
+    {
+        CHECK(segments("").empty());
+        CHECK(segments("/").empty());
+    }
+
+    SECTION("Bounds", "")
+    {
+        const std::vector<std::string> result = segments("/a/b/c", 5);
+        REQUIRE(result.size() == 3);
+        CHECK(result[0] == "a");
+        CHECK(result[1] == "b");
+        CHECK(result[2] == "");
+
+        CHECK(segments("/a/b", SIZE_MAX).size() == 2);
+    }
+
+    SECTION("Spans", "")
+    {
+        // The same segments as the ones retrieved while parsing
+        const char* path = "/a//b/c%20d/";
+        curi_span spans[8];
+        curi_path_segments pathSegments;
+        pathSegments.spans = spans;
+        pathSegments.capacity = 8;
+        REQUIRE(curi_status_success == curi_parse_path_with_spans(path, SIZE_MAX, &pathSegments, 0, 0, 0));
+
+        const std::vector<std::string> result = segments(path);
+        REQUIRE(result.size() == pathSegments.count);
+        for (size_t i = 0 ; i < pathSegments.count ; ++i)
+            CHECK(result[i] == std::string(path + spans[i].offset, spans[i].len));
+    }
+}
+
+TEST_CASE("Iterators/QueryItems", "Iterating over query items")
+{
+    curi_query_iter iter;
+    curi_query_item item;
+
+    SECTION("Default", "")
+    {
+        const char* query = "q=1&&flag&lang=fr&empty=&a=b=c";
+        curi_query_iter_init(&iter, query, strlen(query), 0);
+
+        REQUIRE(curi_query_iter_next(&iter, &item));
+        CHECK(std::string(item.key, item.keyLen) == "q");
+        REQUIRE(item.value);
+        CHECK(std::string(item.value, item.valueLen) == "1");
+
+        REQUIRE(curi_query_iter_next(&iter, &item));
+        CHECK(std::string(item.key, item.keyLen) == "flag");
+        CHECK(!item.value);
+
+        REQUIRE(curi_query_iter_next(&iter, &item));
+        CHECK(std::string(item.key, item.keyLen) == "lang");
+        CHECK(std::string(item.value, item.valueLen) == "fr");
+
+        REQUIRE(curi_query_iter_next(&iter, &item));
+        CHECK(std::string(item.key, item.keyLen) == "empty");
+        REQUIRE(item.value);
+        CHECK(item.valueLen == 0);
+
+        REQUIRE(curi_query_iter_next(&iter, &item));
+        CHECK(std::string(item.key, item.keyLen) == "a");
+        CHECK(std::string(item.value, item.valueLen) == "b=c");
+
+        CHECK(!curi_query_iter_next(&iter, &item));
+        CHECK(!curi_query_iter_next(&iter, &item));
+    }
+
+    SECTION("Lazy", "")
+    {
+        // Only the items up to the requested one are read
+        const char* query = "q=1&lang=fr&rest";
+        curi_query_iter_init(&iter, query, strlen(query), 0);
+
+        do
+            REQUIRE(curi_query_iter_next(&iter, &item));
+        while (std::string(item.key, item.keyLen) != "lang");
+
+        CHECK(std::string(item.value, item.valueLen) == "fr");
+        CHECK(iter.offset == 11);
+    }
+
+    SECTION("Separators", "")
+    {
+        const char* query = "a:1;b=2&c";
+        curi_settings settings;
+        curi_default_settings(&settings);
+        settings.query_item_separators = ";&";
+        settings.query_item_key_separators = ":=";
+        curi_query_iter_init(&iter, query, strlen(query), &settings);
+
+        REQUIRE(curi_query_iter_next(&iter, &item));
+        CHECK(std::string(item.key, item.keyLen) == "a");
+        CHECK(std::string(item.value, item.valueLen) == "1");
+
+        REQUIRE(curi_query_iter_next(&iter, &item));
+        CHECK(std::string(item.key, item.keyLen) == "b");
+        CHECK(std::string(item.value, item.valueLen) == "2");
+
+        REQUIRE(curi_query_iter_next(&iter, &item));
+        CHECK(std::string(item.key, item.keyLen) == "c");
+        CHECK(!item.value);
+
+        CHECK(!curi_query_iter_next(&iter, &item));
+    }
+
+    SECTION("Empty", "")
+    {
+        curi_query_iter_init(&iter, "&&", 2, 0);
+        CHECK(!curi_query_iter_next(&iter, &item));
+
+        curi_query_iter_init(&iter, "", 0, 0);
+        CHECK(!curi_query_iter_next(&iter, &item));
+    }
+}
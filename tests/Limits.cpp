@@ -0,0 +1,132 @@
+// Copyright (c) 2013 Clodéric Mars
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "Common.h"
+
+#include <curi.h>
+
+#include <cstring>
+
+TEST_CASE("Limits/Exceeded", "Parsing stopped by the resource limits")
+{
+    curi_limits limits;
+    memset(&limits, 0, sizeof(curi_limits));
+
+    curi_settings settings;
+    curi_default_settings(&settings);
+    settings.allocate = test_allocate;
+    settings.deallocate = test_deallocate;
+    settings.path_callback = path;
+    settings.path_segment_callback = pathSegment;
+    settings.query_item_null_callback = queryNullItem;
+    settings.query_item_str_callback = queryStrItem;
+    settings.limits = &limits;
+
+    URI uri;
+    uri.clear();
+
+    SECTION("Length", "")
+    {
+        const std::string uriStr("http://example.com/foo/bar");
+
+        limits.max_length = uriStr.length();
+        CHECK(curi_status_success == curi_parse_full_uri_nt(uriStr.c_str(), &settings, &uri));
+        CHECK(curi_status_success == curi_parse_full_uri(uriStr.c_str(), uriStr.length(), &settings, &uri));
+
+        uri.clear();
+
+        limits.max_length = uriStr.length() - 1;
+        CHECK(curi_status_limit_exceeded == curi_parse_full_uri_nt(uriStr.c_str(), &settings, &uri));
+        CHECK(curi_status_limit_exceeded == curi_parse_full_uri(uriStr.c_str(), uriStr.length(), &settings, &uri));
+        CHECK(uri.path.empty());
+        CHECK(uri.pathSegments.empty());
+    }
+
+    SECTION("PathSegments", "")
+    {
+        limits.max_path_segments = 3;
+        CHECK(curi_status_success == curi_parse_path_nt("/foo/bar/baz", &settings, &uri));
+        CHECK(uri.pathSegments.size() == 3);
+
+        uri.clear();
+
+        CHECK(curi_status_limit_exceeded == curi_parse_path_nt("/foo/bar/baz/", &settings, &uri));
+        CHECK(uri.pathSegments.size() == 3);
+        CHECK(uri.path.empty());
+
+        uri.clear();
+
+        CHECK(curi_status_limit_exceeded == curi_parse_full_uri_nt("http://example.com////", &settings, &uri));
+        CHECK(uri.path.empty());
+    }
+
+    SECTION("QueryItems", "")
+    {
+        limits.max_query_items = 2;
+        CHECK(curi_status_success == curi_parse_query_nt("foo=1&bar", &settings, &uri));
+
+        uri.clear();
+
+        CHECK(curi_status_limit_exceeded == curi_parse_query_nt("foo=1&bar&baz", &settings, &uri));
+        CHECK(uri.queryNullItems.size() == 1);
+        CHECK(uri.queryNullItems.find("baz") == uri.queryNullItems.end());
+    }
+
+    SECTION("QueryItemKeyAndValue", "")
+    {
+        limits.max_query_item_key_length = 3;
+        limits.max_query_item_value_length = 4;
+        CHECK(curi_status_success == curi_parse_query_nt("foo=abcd&bar", &settings, &uri));
+        CHECK(curi_status_limit_exceeded == curi_parse_query_nt("fooo=abcd&bar", &settings, &uri));
+        CHECK(curi_status_limit_exceeded == curi_parse_query_nt("foo=abcde&bar", &settings, &uri));
+        CHECK(curi_status_limit_exceeded == curi_parse_full_uri_nt("http://example.com/?foo=abcde", &settings, &uri));
+
+        uri.clear();
+
+        const std::string longKey = "bar=x&" + std::string(1000000, 'k');
+        CHECK(curi_status_limit_exceeded == curi_parse_query(longKey.c_str(), longKey.length(), &settings, &uri));
+        CHECK(uri.queryStrItems.size() == 1);
+        CHECK(uri.queryStrItems["bar"] == "x");
+    }
+
+    SECTION("DecodedLength", "")
+    {
+        settings.url_decode = 1;
+        limits.max_decoded_length = 6;
+        CHECK(curi_status_success == curi_parse_path_nt("/a%20b", &settings, &uri));
+        CHECK(uri.path == "/a b");
+        CHECK(uri.allocatedMemory > 0);
+
+        uri.clear();
+
+        CHECK(curi_status_limit_exceeded == curi_parse_path_nt("/a%20bc", &settings, &uri));
+        CHECK(uri.path.empty());
+        CHECK(uri.allocatedMemory == strlen("a%20bc") + 1);
+        CHECK(uri.deallocatedMemory == uri.allocatedMemory);
+
+        uri.clear();
+
+        CHECK(curi_status_limit_exceeded == curi_parse_query_nt("foo=a%20bcd", &settings, &uri));
+        CHECK(uri.allocatedMemory == strlen("foo") + 1);
+        CHECK(uri.deallocatedMemory == uri.allocatedMemory);
+    }
+
+    uri.clear();
+}
@@ -0,0 +1,201 @@
+// Copyright (c) 2013 Clodéric Mars
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "Common.h"
+
+#include <curi.h>
+
+#include <cstring>
+
+static const std::string buecher("b\xC3\xBC" "cher");
+static const std::string reiJapanese("\xE4\xBE\x8B\xE3\x81\x88"); // U+4F8B U+3048
+static const std::string testJapanese("\xE3\x83\x86\xE3\x82\xB9\xE3\x83\x88"); // U+30C6 U+30B9 U+30C8
+static const std::string rfc3492SampleL("3\xE5\xB9\xB4" "B\xE7\xB5\x84\xE9\x87\x91\xE5\x85\xAB\xE5\x85\x88\xE7\x94\x9F");
+
+static std::string punycodeEncode(const std::string& input)
+{
+    char output[256];
+    size_t outputLen = 0;
+    REQUIRE(curi_status_success == curi_punycode_encode(input.c_str(), input.length(), output, sizeof(output), &outputLen));
+    return std::string(output, outputLen);
+}
+
+static std::string punycodeDecode(const std::string& input)
+{
+    char output[256];
+    size_t outputLen = 0;
+    REQUIRE(curi_status_success == curi_punycode_decode(input.c_str(), input.length(), output, sizeof(output), &outputLen));
+    return std::string(output, outputLen);
+}
+
+static std::string normalizeHost(const std::string& input, int normalization)
+{
+    char output[256];
+    size_t outputLen = 0;
+    REQUIRE(curi_status_success == curi_normalize_host(input.c_str(), input.length(), normalization, output, sizeof(output), &outputLen));
+    return std::string(output, outputLen);
+}
+
+TEST_CASE("NormalizeHost/Punycode", "Punycode encoding and decoding")
+{
+    SECTION("Encode", "")
+    {
+        CHECK(punycodeEncode(buecher) == "bcher-kva");
+        CHECK(punycodeEncode(reiJapanese) == "r8jz45g");
+        CHECK(punycodeEncode(testJapanese) == "zckzah");
+        CHECK(punycodeEncode(rfc3492SampleL) == "3B-ww4c5e180e575a65lsy2b");
+        CHECK(punycodeEncode("-> $1.00 <-") == "-> $1.00 <--");
+    }
+
+    SECTION("Decode", "")
+    {
+        CHECK(punycodeDecode("bcher-kva") == buecher);
+        CHECK(punycodeDecode("r8jz45g") == reiJapanese);
+        CHECK(punycodeDecode("zckzah") == testJapanese);
+        CHECK(punycodeDecode("3B-ww4c5e180e575a65lsy2b") == rfc3492SampleL);
+        CHECK(punycodeDecode("-> $1.00 <--") == "-> $1.00 <-");
+    }
+
+    SECTION("Errors", "")
+    {
+        char output[256];
+        CHECK(curi_status_error == curi_punycode_decode("bcher-kv!", 9, output, sizeof(output), 0));
+        CHECK(curi_status_error == curi_punycode_decode("bcher-k", 7, output, 2, 0));
+        CHECK(curi_status_error == curi_punycode_decode("99999999999", 11, output, sizeof(output), 0));
+        CHECK(curi_status_error == curi_punycode_encode("b\xC3", 2, output, sizeof(output), 0));
+        CHECK(curi_status_error == curi_punycode_encode(buecher.c_str(), buecher.length(), output, 4, 0));
+    }
+}
+
+TEST_CASE("NormalizeHost/Host", "Host normalization")
+{
+    SECTION("Lowercase", "")
+    {
+        CHECK(normalizeHost("WWW.Example.COM", curi_host_lowercase) == "www.example.com");
+        CHECK(normalizeHost("WWW.XN--BCHER-KVA.Example", curi_host_lowercase) == "www.xn--bcher-kva.example");
+        CHECK(normalizeHost("WWW." + buecher, curi_host_lowercase) == "www." + buecher);
+    }
+
+    SECTION("ToUnicode", "")
+    {
+        CHECK(normalizeHost("www.xn--bcher-kva.example", curi_host_to_unicode) == "www." + buecher + ".example");
+        CHECK(normalizeHost("xn--r8jz45g.XN--ZCKZAH", curi_host_to_unicode | curi_host_lowercase) == reiJapanese + "." + testJapanese);
+        CHECK(normalizeHost("Example.COM", curi_host_to_unicode) == "Example.COM");
+    }
+
+    SECTION("ToAscii", "")
+    {
+        CHECK(normalizeHost("www." + buecher + ".example", curi_host_to_ascii) == "www.xn--bcher-kva.example");
+        CHECK(normalizeHost(reiJapanese + "." + testJapanese, curi_host_to_ascii) == "xn--r8jz45g.xn--zckzah");
+        CHECK(normalizeHost("B\xC3\xBC" "CHER.Example", curi_host_to_ascii | curi_host_lowercase) == "xn--bcher-kva.example");
+    }
+
+    SECTION("Errors", "")
+    {
+        char output[256];
+        CHECK(curi_status_error == curi_normalize_host("example.com", 11, curi_host_to_ascii | curi_host_to_unicode, output, sizeof(output), 0));
+        CHECK(curi_status_error == curi_normalize_host("xn--bcher-kv!.example", 21, curi_host_to_unicode, output, sizeof(output), 0));
+        CHECK(curi_status_error == curi_normalize_host("www.example.com", 15, curi_host_lowercase, output, 10, 0));
+    }
+}
+
+TEST_CASE("NormalizeHost/Cache", "Host normalization through a cache")
+{
+    curi_host_cache* cache = curi_host_cache_create(4, 0, 0);
+    REQUIRE(cache);
+
+    char output[256];
+    size_t outputLen = 0;
+
+    for (int i = 0 ; i < 3 ; ++i)
+    {
+        CHECK(curi_status_success == curi_host_cache_normalize(cache, "WWW.XN--BCHER-KVA.EXAMPLE", 25, curi_host_lowercase | curi_host_to_unicode, output, sizeof(output), &outputLen));
+        CHECK(std::string(output, outputLen) == "www." + buecher + ".example");
+
+        CHECK(curi_status_success == curi_host_cache_normalize(cache, "WWW.XN--BCHER-KVA.EXAMPLE", 25, curi_host_lowercase, output, sizeof(output), &outputLen));
+        CHECK(std::string(output, outputLen) == "www.xn--bcher-kva.example");
+
+        CHECK(curi_status_error == curi_host_cache_normalize(cache, "xn--bcher-kv!", 13, curi_host_to_unicode, output, sizeof(output), &outputLen));
+    }
+
+    for (int i = 0 ; i < 64 ; ++i)
+    {
+        char host[32];
+        sprintf(host, "HOST%d.EXAMPLE", i);
+        CHECK(curi_status_success == curi_host_cache_normalize(cache, host, strlen(host), curi_host_lowercase, output, sizeof(output), &outputLen));
+        sprintf(host, "host%d.example", i);
+        CHECK(std::string(output, outputLen) == host);
+    }
+
+    curi_host_cache_destroy(cache);
+}
+
+TEST_CASE("NormalizeHost/Parse", "Host normalization while parsing")
+{
+    curi_settings settings;
+    curi_default_settings(&settings);
+    settings.allocate = test_allocate;
+    settings.deallocate = test_deallocate;
+    settings.host_callback = host;
+    settings.host_normalization = curi_host_lowercase | curi_host_to_unicode;
+
+    URI uri;
+    uri.clear();
+
+    SECTION("RegName", "")
+    {
+        CHECK(curi_status_success == curi_parse_full_uri_nt("http://WWW.xn--bcher-kva.Example/Path", &settings, &uri));
+        CHECK(uri.host == "www." + buecher + ".example");
+    }
+
+    SECTION("Cached", "")
+    {
+        settings.host_cache = curi_host_cache_create(16, &settings, &uri);
+        CHECK(uri.allocatedMemory > 0);
+
+        CHECK(curi_status_success == curi_parse_full_uri_nt("http://WWW.xn--bcher-kva.Example/Path", &settings, &uri));
+        CHECK(uri.host == "www." + buecher + ".example");
+        uri.host.clear();
+        CHECK(curi_status_success == curi_parse_full_uri_nt("http://WWW.xn--bcher-kva.Example/Path", &settings, &uri));
+        CHECK(uri.host == "www." + buecher + ".example");
+
+        curi_host_cache_destroy(settings.host_cache);
+        CHECK(uri.deallocatedMemory == uri.allocatedMemory);
+    }
+
+    SECTION("UrlDecoded", "")
+    {
+        settings.url_decode = 1;
+        CHECK(curi_status_success == curi_parse_full_uri_nt("http://%57WW.Example/Path", &settings, &uri));
+        CHECK(uri.host == "www.example");
+        CHECK(uri.deallocatedMemory == uri.allocatedMemory);
+    }
+
+    SECTION("IPLiteral", "")
+    {
+        CHECK(curi_status_success == curi_parse_full_uri_nt("http://[::FFFF]/Path", &settings, &uri));
+        CHECK(uri.host == "[::FFFF]");
+    }
+
+    SECTION("Invalid", "")
+    {
+        CHECK(curi_status_error == curi_parse_full_uri_nt("http://xn--bcher-kv9.example/Path", &settings, &uri));
+    }
+}
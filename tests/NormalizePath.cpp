@@ -0,0 +1,153 @@
+// Copyright (c) 2013 Clodéric Mars
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "Common.h"
+
+#include <curi.h>
+
+static std::string normalizePath(const std::string& path, int normalization)
+{
+    std::string normalizedPath(path);
+    size_t normalizedPathLen = 0;
+    REQUIRE(curi_status_success == curi_normalize_path(&normalizedPath[0], normalizedPath.length(), normalization, &normalizedPathLen));
+    normalizedPath.resize(normalizedPathLen);
+    return normalizedPath;
+}
+
+TEST_CASE("NormalizePath/DotSegments", "Dot segments removal")
+{
+    const int normalization = curi_path_remove_dot_segments;
+
+    SECTION("Rfc3986", "")
+    {
+        CHECK(normalizePath("/a/b/c/./../../g", normalization) == "/a/g");
+        CHECK(normalizePath("mid/content=5/../6", normalization) == "mid/6");
+    }
+
+    SECTION("Absolute", "")
+    {
+        CHECK(normalizePath("/a/b/..", normalization) == "/a/");
+        CHECK(normalizePath("/a/b/.", normalization) == "/a/b/");
+        CHECK(normalizePath("/a/./b", normalization) == "/a/b");
+        CHECK(normalizePath("/..", normalization) == "/");
+        CHECK(normalizePath("/../../a", normalization) == "/a");
+        CHECK(normalizePath("/a//..", normalization) == "/a/");
+        CHECK(normalizePath("/a/..b/.c", normalization) == "/a/..b/.c");
+        CHECK(normalizePath("/", normalization) == "/");
+    }
+
+    SECTION("Relative", "")
+    {
+        CHECK(normalizePath("../a", normalization) == "a");
+        CHECK(normalizePath("./a/./b", normalization) == "a/b");
+        CHECK(normalizePath("a/..", normalization) == "");
+        CHECK(normalizePath("a/b/../../..", normalization) == "");
+        CHECK(normalizePath("", normalization) == "");
+    }
+
+    SECTION("NotNullTerminated", "")
+    {
+        char path[] = "/a/../b/c";
+        size_t pathLen = 0;
+        CHECK(curi_status_success == curi_normalize_path(path, 7, normalization, &pathLen));
+        CHECK(std::string(path, pathLen) == "/b");
+    }
+}
+
+TEST_CASE("NormalizePath/Slashes", "Merging slashes")
+{
+    CHECK(normalizePath("//a///b/", curi_path_merge_slashes) == "/a/b/");
+    CHECK(normalizePath("a//b//", curi_path_merge_slashes) == "a/b/");
+    CHECK(normalizePath("/a//b/../c", curi_path_merge_slashes) == "/a/b/../c");
+    CHECK(normalizePath("/a//b//..//c", curi_path_merge_slashes | curi_path_remove_dot_segments) == "/a/c");
+}
+
+TEST_CASE("NormalizePath/PercentEncoding", "Percent encoding normalization")
+{
+    const int normalization = curi_path_normalize_percent_encoding;
+
+    SECTION("Success", "")
+    {
+        CHECK(normalizePath("/%7euser/%41%62%2d%5F", normalization) == "/~user/Ab-_");
+        CHECK(normalizePath("/a%2fb/c%3F%3f", normalization) == "/a%2Fb/c%3F%3F");
+        CHECK(normalizePath("/%2E%2e/%2e", normalization) == "/../.");
+        CHECK(normalizePath("/a/b/%2E%2e/%2e", normalization | curi_path_remove_dot_segments) == "/a/");
+    }
+
+    SECTION("Error", "")
+    {
+        std::string path("/a%2");
+        CHECK(curi_status_error == curi_normalize_path(&path[0], path.length(), normalization, 0));
+        path = "/a%g0/b";
+        CHECK(curi_status_error == curi_normalize_path(&path[0], path.length(), normalization, 0));
+        path = "/a%g0/b";
+        CHECK(curi_status_success == curi_normalize_path(&path[0], path.length(), curi_path_remove_dot_segments, 0));
+    }
+}
+
+TEST_CASE("NormalizePath/Parse", "Path normalization while parsing")
+{
+    curi_settings settings;
+    curi_default_settings(&settings);
+    settings.allocate = test_allocate;
+    settings.deallocate = test_deallocate;
+    settings.path_callback = path;
+    settings.path_segment_callback = pathSegment;
+    settings.path_normalization = curi_path_remove_dot_segments | curi_path_merge_slashes | curi_path_normalize_percent_encoding;
+
+    URI uri;
+    uri.clear();
+
+    SECTION("FullUri", "")
+    {
+        CHECK(curi_status_success == curi_parse_full_uri_nt("http://example.com/a/b//%2e%2E/./%7Ec/?query", &settings, &uri));
+        CHECK(uri.path == "/a/~c/");
+        REQUIRE(uri.pathSegments.size() == 2);
+        CHECK(uri.pathSegments[0] == "a");
+        CHECK(uri.pathSegments[1] == "~c");
+        CHECK(uri.deallocatedMemory == uri.allocatedMemory);
+    }
+
+    SECTION("Path", "")
+    {
+        CHECK(curi_status_success == curi_parse_path_nt("/../etc/./passwd", &settings, &uri));
+        CHECK(uri.path == "/etc/passwd");
+        REQUIRE(uri.pathSegments.size() == 2);
+        CHECK(uri.pathSegments[0] == "etc");
+        CHECK(uri.pathSegments[1] == "passwd");
+    }
+
+    SECTION("UrlDecoded", "")
+    {
+        settings.url_decode = 1;
+        CHECK(curi_status_success == curi_parse_path_nt("/a/%2E%2E/b%20c", &settings, &uri));
+        CHECK(uri.path == "/b c");
+        REQUIRE(uri.pathSegments.size() == 1);
+        CHECK(uri.pathSegments[0] == "b c");
+        CHECK(uri.deallocatedMemory == uri.allocatedMemory);
+    }
+
+    SECTION("Cancelled", "")
+    {
+        settings.path_segment_callback = cancellingCallbackStr;
+        CHECK(curi_status_canceled == curi_parse_path_nt("/a/b", &settings, &uri));
+        CHECK(uri.deallocatedMemory == uri.allocatedMemory);
+    }
+}
@@ -499,6 +499,185 @@ TEST_CASE("ParseFullUri/Success/Query", "Valid URIs, query focus")
     }
 }
 
+TEST_CASE("ParseFullUri/Success/Port", "Valid URIs, port focus")
+{
+    curi_settings settings;
+    curi_default_settings(&settings);
+    settings.host_callback = host;
+    settings.port_callback = port;
+    settings.portStr_callback = portStr;
+    settings.invalid_port_callback = invalidPortStr;
+
+    URI uri;
+    uri.clear();
+
+    SECTION("Maximum", "")
+    {
+        const std::string uriStr("http://example.com:65535/path");
+
+        CHECK(curi_status_success == curi_parse_full_uri(uriStr.c_str(), uriStr.length(), &settings, &uri));
+
+        CHECK(uri.portStr == "65535");
+        CHECK(uri.port == 65535);
+        CHECK(uri.invalidPortStr.empty());
+    }
+
+    SECTION("LeadingZeros", "")
+    {
+        const std::string uriStr("http://example.com:00080");
+
+        CHECK(curi_status_success == curi_parse_full_uri(uriStr.c_str(), uriStr.length(), &settings, &uri));
+
+        CHECK(uri.portStr == "00080");
+        CHECK(uri.port == 80);
+    }
+
+    SECTION("AboveMaximum", "")
+    {
+        const std::string uriStr("http://example.com:65536/path");
+
+        CHECK(curi_status_success == curi_parse_full_uri(uriStr.c_str(), uriStr.length(), &settings, &uri));
+
+        CHECK(uri.portStr == "65536");
+        CHECK(uri.port == 0);
+        CHECK(uri.invalidPortStr == "65536");
+    }
+
+    SECTION("Overflow", "")
+    {
+        const std::string uriStr("http://example.com:99999999999999999999999");
+
+        CHECK(curi_status_success == curi_parse_full_uri(uriStr.c_str(), uriStr.length(), &settings, &uri));
+
+        CHECK(uri.port == 0);
+        CHECK(uri.invalidPortStr == "99999999999999999999999");
+    }
+
+    SECTION("NotNullTerminated", "")
+    {
+        const std::string uriStr("http://example.com:8042123");
+
+        CHECK(curi_status_success == curi_parse_full_uri(uriStr.c_str(), uriStr.length() - 3, &settings, &uri));
+
+        CHECK(uri.portStr == "8042");
+        CHECK(uri.port == 8042);
+    }
+
+    SECTION("Cancelled", "")
+    {
+        const std::string uriStr("http://example.com:70000/path");
+        settings.invalid_port_callback = cancellingCallbackStr;
+
+        CHECK(curi_status_canceled == curi_parse_full_uri(uriStr.c_str(), uriStr.length(), &settings, &uri));
+    }
+}
+
+TEST_CASE("ParseFullUri/Success/Components", "Valid URIs, stopping after the requested components")
+{
+    curi_settings settings;
+    curi_default_settings(&settings);
+    settings.scheme_callback = scheme;
+    settings.host_callback = host;
+    settings.path_callback = path;
+    settings.query_callback = query;
+    settings.fragment_callback = fragment;
+
+    URI uri;
+    uri.clear();
+
+    SECTION("Host", "")
+    {
+        const std::string uriStr("http://example.com/over/there?name=ferret#nose");
+        settings.components = curi_component_scheme | curi_component_host;
+
+        CHECK(curi_status_partial == curi_parse_full_uri(uriStr.c_str(), uriStr.length(), &settings, &uri));
+
+        CHECK(uri.scheme == "http");
+        CHECK(uri.host == "example.com");
+        CHECK(uri.path.empty());
+        CHECK(uri.query.empty());
+        CHECK(uri.fragment.empty());
+    }
+
+    SECTION("RestUnchecked", "")
+    {
+        const std::string uriStr("http://example.com/over/there?name=%zz");
+        settings.components = curi_component_host;
+
+        CHECK(curi_status_partial == curi_parse_full_uri(uriStr.c_str(), uriStr.length(), &settings, &uri));
+
+        CHECK(uri.host == "example.com");
+    }
+
+    SECTION("NoAuthority", "")
+    {
+        const std::string uriStr("mailto:john@example.com");
+        settings.components = curi_component_host;
+
+        CHECK(curi_status_partial == curi_parse_full_uri(uriStr.c_str(), uriStr.length(), &settings, &uri));
+
+        CHECK(uri.scheme == "mailto");
+        CHECK(uri.host.empty());
+        CHECK(uri.path.empty());
+    }
+
+    SECTION("Path", "")
+    {
+        const std::string uriStr("http://example.com/over/there?name=ferret#nose");
+        settings.components = curi_component_path;
+
+        CHECK(curi_status_partial == curi_parse_full_uri(uriStr.c_str(), uriStr.length(), &settings, &uri));
+
+        CHECK(uri.host == "example.com");
+        CHECK(uri.path == "/over/there");
+        CHECK(uri.query.empty());
+    }
+
+    SECTION("Query", "")
+    {
+        const std::string uriStr("http://example.com/over/there?name=ferret#nose");
+        settings.components = curi_component_query;
+
+        CHECK(curi_status_partial == curi_parse_full_uri(uriStr.c_str(), uriStr.length(), &settings, &uri));
+
+        CHECK(uri.query == "name=ferret");
+        CHECK(uri.fragment.empty());
+    }
+
+    SECTION("FullyConsumed", "")
+    {
+        const std::string uriStr("http://example.com/over/there");
+        settings.components = curi_component_path;
+
+        CHECK(curi_status_success == curi_parse_full_uri(uriStr.c_str(), uriStr.length(), &settings, &uri));
+
+        CHECK(uri.path == "/over/there");
+    }
+
+    SECTION("Fragment", "")
+    {
+        const std::string uriStr("http://example.com/over/there?name=ferret#nose");
+        settings.components = curi_component_fragment;
+
+        CHECK(curi_status_success == curi_parse_full_uri(uriStr.c_str(), uriStr.length(), &settings, &uri));
+
+        CHECK(uri.fragment == "nose");
+    }
+
+    SECTION("InvalidPrefix", "")
+    {
+        const std::string uriStr("http://exa[mple.com/over/there");
+        settings.components = curi_component_host;
+
+        CHECK(curi_status_error == curi_parse_full_uri(uriStr.c_str(), uriStr.length(), &settings, &uri));
+
+        const std::string otherUriStr("http://example.com/over there?name=ferret");
+        settings.components = curi_component_path;
+
+        CHECK(curi_status_error == curi_parse_full_uri(otherUriStr.c_str(), otherUriStr.length(), &settings, &uri));
+    }
+}
+
 TEST_CASE("ParseFullUri/Error/Scheme", "Bad URIs, scheme focus")
 {
     curi_settings settings;
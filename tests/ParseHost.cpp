@@ -0,0 +1,210 @@
+// Copyright (c) 2013 Clodéric Mars
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "Common.h"
+
+#include <curi.h>
+
+#include <cstring>
+
+static std::vector<unsigned char> ipv6(const char* hex)
+{
+    // hex is a string of 32 hexadecimal digits
+    std::vector<unsigned char> address;
+    for (size_t i = 0 ; i < 16 ; ++i)
+    {
+        unsigned int byte;
+        sscanf(hex + 2 * i, "%2x", &byte);
+        address.push_back(static_cast<unsigned char>(byte));
+    }
+    return address;
+}
+
+TEST_CASE("ParseHost/IPv6/Success", "Valid IPv6 hosts")
+{
+    curi_settings settings;
+    curi_default_settings(&settings);
+    settings.host_callback = host;
+    settings.host_ipv6_callback = hostIPv6;
+
+    URI uri;
+    uri.clear();
+
+    SECTION("Full", "")
+    {
+        CHECK(curi_status_success == curi_parse_full_uri_nt("http://[1:22:333:4444:a:bB:CcC:dddd]/", &settings, &uri));
+        CHECK(uri.host == "[1:22:333:4444:a:bB:CcC:dddd]");
+        CHECK(uri.hostIPv6 == ipv6("0001002203334444000a00bb0cccdddd"));
+    }
+
+    SECTION("Unspecified", "")
+    {
+        CHECK(curi_status_success == curi_parse_full_uri_nt("http://[::]/", &settings, &uri));
+        CHECK(uri.host == "[::]");
+        CHECK(uri.hostIPv6 == ipv6("00000000000000000000000000000000"));
+    }
+
+    SECTION("Loopback", "")
+    {
+        CHECK(curi_status_success == curi_parse_full_uri_nt("http://[::1]:80", &settings, &uri));
+        CHECK(uri.hostIPv6 == ipv6("00000000000000000000000000000001"));
+    }
+
+    SECTION("Compressed", "")
+    {
+        CHECK(curi_status_success == curi_parse_full_uri_nt("ldap://[2001:db8::7]/c=GB", &settings, &uri));
+        CHECK(uri.hostIPv6 == ipv6("20010db8000000000000000000000007"));
+
+        CHECK(curi_status_success == curi_parse_full_uri_nt("ldap://[1::]/c=GB", &settings, &uri));
+        CHECK(uri.hostIPv6 == ipv6("00010000000000000000000000000000"));
+
+        CHECK(curi_status_success == curi_parse_full_uri_nt("ldap://[1:2:3:4:5:6:7::]/c=GB", &settings, &uri));
+        CHECK(uri.hostIPv6 == ipv6("00010002000300040005000600070000"));
+
+        CHECK(curi_status_success == curi_parse_full_uri_nt("ldap://[::2:3:4:5:6:7:8]/c=GB", &settings, &uri));
+        CHECK(uri.hostIPv6 == ipv6("00000002000300040005000600070008"));
+    }
+
+    SECTION("IPv4Suffix", "")
+    {
+        CHECK(curi_status_success == curi_parse_full_uri_nt("http://[::ffff:192.0.2.128]/", &settings, &uri));
+        CHECK(uri.hostIPv6 == ipv6("00000000000000000000ffffc0000280"));
+
+        CHECK(curi_status_success == curi_parse_full_uri_nt("http://[1:2:3:4:5:6:10.0.0.1]/", &settings, &uri));
+        CHECK(uri.hostIPv6 == ipv6("0001000200030004000500060a000001"));
+    }
+
+    SECTION("NotIPv6", "")
+    {
+        CHECK(curi_status_success == curi_parse_full_uri_nt("http://[v7.fe80::a+en1]/", &settings, &uri));
+        CHECK(uri.host == "[v7.fe80::a+en1]");
+        CHECK(uri.hostIPv6.empty());
+
+        CHECK(curi_status_success == curi_parse_full_uri_nt("http://[v1F.fe80::a+en1]/", &settings, &uri));
+        CHECK(uri.host == "[v1F.fe80::a+en1]");
+        CHECK(uri.hostIPv6.empty());
+
+        CHECK(curi_status_success == curi_parse_full_uri_nt("http://example.com/", &settings, &uri));
+        CHECK(uri.hostIPv6.empty());
+    }
+}
+
+TEST_CASE("ParseHost/IPv6/Error", "Bad IPv6 hosts")
+{
+    curi_settings settings;
+    curi_default_settings(&settings);
+    settings.host_ipv6_callback = hostIPv6;
+
+    URI uri;
+    uri.clear();
+
+    CHECK(curi_status_error == curi_parse_full_uri_nt("http://[1:2:3:4:5:6:7]/", &settings, &uri));
+    CHECK(curi_status_error == curi_parse_full_uri_nt("http://[1:2:3:4:5:6:7:8:9]/", &settings, &uri));
+    CHECK(curi_status_error == curi_parse_full_uri_nt("http://[1:2:3:4:5:6:7:8::]/", &settings, &uri));
+    CHECK(curi_status_error == curi_parse_full_uri_nt("http://[::1:2:3:4:5:6:7:8]/", &settings, &uri));
+    CHECK(curi_status_error == curi_parse_full_uri_nt("http://[1::2::3]/", &settings, &uri));
+    CHECK(curi_status_error == curi_parse_full_uri_nt("http://[:1:2:3:4:5:6:7]/", &settings, &uri));
+    CHECK(curi_status_error == curi_parse_full_uri_nt("http://[1:2:3:4:5:6:7:]/", &settings, &uri));
+    CHECK(curi_status_error == curi_parse_full_uri_nt("http://[:::]/", &settings, &uri));
+    CHECK(curi_status_error == curi_parse_full_uri_nt("http://[12345::]/", &settings, &uri));
+    CHECK(curi_status_error == curi_parse_full_uri_nt("http://[1:2:3:4:5:6:7:1.2.3.4]/", &settings, &uri));
+    CHECK(curi_status_error == curi_parse_full_uri_nt("http://[::1.2.3.4:5]/", &settings, &uri));
+    CHECK(curi_status_error == curi_parse_full_uri_nt("http://[::1.2.3]/", &settings, &uri));
+    CHECK(curi_status_error == curi_parse_full_uri_nt("http://[::1.2.3.256]/", &settings, &uri));
+    CHECK(curi_status_error == curi_parse_full_uri_nt("http://[::g]/", &settings, &uri));
+    CHECK(curi_status_error == curi_parse_full_uri_nt("http://[::1/", &settings, &uri));
+    CHECK(uri.hostIPv6.empty());
+}
+
+TEST_CASE("ParseHost/IPv6/Cancelled", "Canceled parsing of IPv6 host")
+{
+    curi_settings settings;
+    curi_default_settings(&settings);
+    settings.host_ipv6_callback = cancellingCallbackBytes;
+
+    CHECK(curi_status_canceled == curi_parse_full_uri_nt("http://[::1]/", &settings, 0));
+    CHECK(curi_status_success == curi_parse_full_uri_nt("http://127.0.0.1/", &settings, 0));
+}
+
+TEST_CASE("ParseHost/IPv4/Success", "Valid IPv4 hosts")
+{
+    curi_settings settings;
+    curi_default_settings(&settings);
+    settings.host_callback = host;
+    settings.host_ipv4_callback = hostIPv4;
+    settings.port_callback = port;
+
+    URI uri;
+    uri.clear();
+
+    SECTION("Loopback", "")
+    {
+        CHECK(curi_status_success == curi_parse_full_uri_nt("http://127.0.0.1:8080/", &settings, &uri));
+        CHECK(uri.host == "127.0.0.1");
+        CHECK(uri.hostIPv4 == 0x7F000001UL);
+        CHECK(uri.port == 8080);
+    }
+
+    SECTION("Bounds", "")
+    {
+        CHECK(curi_status_success == curi_parse_full_uri_nt("http://255.255.255.255", &settings, &uri));
+        CHECK(uri.hostIPv4 == 0xFFFFFFFFUL);
+
+        CHECK(curi_status_success == curi_parse_full_uri_nt("http://0.10.199.249/", &settings, &uri));
+        CHECK(uri.hostIPv4 == 0x000AC7F9UL);
+    }
+
+    SECTION("RegName", "")
+    {
+        const char* regNames[] = {
+            "1.2.3.4.5",
+            "1.2.3.4a",
+            "1.2.3",
+            "1..2.3",
+            "01.2.3.4",
+            "1.2.3.256",
+            "1234.1.1.1",
+            "1.2.3.4~",
+            "1.2.3.4%20"
+        };
+
+        for (size_t i = 0 ; i < sizeof(regNames) / sizeof(regNames[0]) ; ++i)
+        {
+            const std::string uriStr = std::string("http://") + regNames[i] + "/foo";
+            CAPTURE(uriStr);
+
+            uri.clear();
+            CHECK(curi_status_success == curi_parse_full_uri_nt(uriStr.c_str(), &settings, &uri));
+            CHECK(uri.host == regNames[i]);
+            CHECK(uri.hostIPv4 == 0);
+        }
+    }
+}
+
+TEST_CASE("ParseHost/IPv4/Cancelled", "Canceled parsing of IPv4 host")
+{
+    curi_settings settings;
+    curi_default_settings(&settings);
+    settings.host_ipv4_callback = cancellingCallbackUlong;
+
+    CHECK(curi_status_canceled == curi_parse_full_uri_nt("http://127.0.0.1/", &settings, 0));
+    CHECK(curi_status_success == curi_parse_full_uri_nt("http://127.0.0.1.example.com/", &settings, 0));
+    CHECK(curi_status_success == curi_parse_full_uri_nt("http://[::127.0.0.1]/", &settings, 0));
+}
@@ -191,6 +191,108 @@ TEST_CASE("ParsePath/RetrieveOnlySegments", "Valid pathes")
      uri.clear();
 }
 
+TEST_CASE("ParsePath/Spans", "Retrieving the spans of the segments")
+{
+    curi_span spans[3];
+    curi_path_segments segments;
+    segments.spans = spans;
+    segments.capacity = 3;
+    segments.count = 42;
+
+    curi_settings settings;
+    curi_default_settings(&settings);
+
+    SECTION("Absolute", "")
+    {
+        const std::string pathStr("/my/taylor/");
+
+        CHECK(curi_status_success == curi_parse_path_with_spans(pathStr.c_str(), pathStr.length(), &segments, 0, &settings, 0));
+
+        REQUIRE(segments.count == 3);
+        CHECK(pathStr.substr(spans[0].offset, spans[0].len) == "my");
+        CHECK(pathStr.substr(spans[1].offset, spans[1].len) == "taylor");
+        CHECK(spans[2].offset == pathStr.length());
+        CHECK(spans[2].len == 0);
+    }
+
+    SECTION("Relative", "")
+    {
+        const std::string pathStr("my//rich");
+
+        CHECK(curi_status_success == curi_parse_path_with_spans(pathStr.c_str(), pathStr.length(), &segments, 0, &settings, 0));
+
+        REQUIRE(segments.count == 3);
+        CHECK(pathStr.substr(spans[0].offset, spans[0].len) == "my");
+        CHECK(spans[1].len == 0);
+        CHECK(pathStr.substr(spans[2].offset, spans[2].len) == "rich");
+    }
+
+    SECTION("Empty", "")
+    {
+        CHECK(curi_status_success == curi_parse_path_with_spans("", 0, &segments, 0, &settings, 0));
+        CHECK(segments.count == 0);
+
+        CHECK(curi_status_success == curi_parse_path_with_spans("/", 1, &segments, 0, 0, 0));
+        CHECK(segments.count == 0);
+    }
+
+    SECTION("Overflow", "")
+    {
+        const std::string pathStr("/my/taylor/is/rich");
+
+        CHECK(curi_status_success == curi_parse_path_with_spans(pathStr.c_str(), pathStr.length(), &segments, 0, &settings, 0));
+
+        CHECK(segments.count == 4);
+        CHECK(pathStr.substr(spans[2].offset, spans[2].len) == "is");
+    }
+
+    SECTION("CountOnly", "")
+    {
+        segments.spans = 0;
+
+        CHECK(curi_status_success == curi_parse_path_with_spans("/my/taylor/is/rich", 18, &segments, 0, &settings, 0));
+        CHECK(segments.count == 4);
+    }
+
+    SECTION("NoSegments", "")
+    {
+        CHECK(curi_status_success == curi_parse_path_with_spans("/my/taylor", 10, 0, 0, &settings, 0));
+        CHECK(curi_status_success == curi_parse_path("/my/taylor", 10, &settings, 0));
+        CHECK(segments.count == 42);
+    }
+
+    SECTION("SharedSettings", "")
+    {
+        // The same settings, each call filling its own segments
+        curi_span otherSpans[3];
+        curi_path_segments otherSegments;
+        otherSegments.spans = otherSpans;
+        otherSegments.capacity = 3;
+
+        CHECK(curi_status_success == curi_parse_path_with_spans("/my/taylor", 10, &segments, 0, &settings, 0));
+        CHECK(curi_status_success == curi_parse_path_with_spans("/is", 3, &otherSegments, 0, &settings, 0));
+
+        CHECK(segments.count == 2);
+        CHECK(otherSegments.count == 1);
+        CHECK(otherSpans[0].offset == 1);
+        CHECK(otherSpans[0].len == 2);
+    }
+
+    SECTION("FullUri", "")
+    {
+        const std::string uriStr("http://example.com/my/taylor?is=rich");
+
+        CHECK(curi_status_success == curi_parse_full_uri_with_spans(uriStr.c_str(), uriStr.length(), &segments, 0, &settings, 0));
+
+        REQUIRE(segments.count == 2);
+        CHECK(uriStr.substr(spans[0].offset, spans[0].len) == "my");
+        CHECK(uriStr.substr(spans[1].offset, spans[1].len) == "taylor");
+
+        CHECK(curi_status_success == curi_parse_full_uri_with_spans("http://example.com", SIZE_MAX, &segments, 0, &settings, 0));
+        CHECK(segments.count == 0);
+    }
+}
+
 TEST_CASE("ParsePath/Cancelled", "Canceled parsing of path")
 {
     const std::string pathStr("/foo/bar/baz");
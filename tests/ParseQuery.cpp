@@ -97,6 +97,94 @@ TEST_CASE("ParseQuery/Success", "Valid pathes")
         CHECK(uri.deallocatedMemory == 0);
     }
 
+    SECTION("SeparatorSets", "")
+    {
+        const std::string pathStr("foo:2;bar&baz:baz=Value;foobar=.5");
+
+        settings.query_item_separators = "&;";
+        settings.query_item_key_separators = ":";
+
+        CHECK(curi_status_success == curi_parse_query_nt(pathStr.c_str(), &settings, &uri));
+
+        CHECK(uri.query == "foo:2;bar&baz:baz=Value;foobar=.5");
+        CHECK(uri.queryNullItems.size() == 2);
+        CHECK(uri.queryNullItems.find("bar") != uri.queryNullItems.end());
+        CHECK(uri.queryNullItems.find("foobar=.5") != uri.queryNullItems.end());
+        CHECK(uri.queryStrItems.size() == 1);
+        CHECK(uri.queryStrItems["baz"] == "baz=Value");
+        CHECK(uri.queryIntItems.size() == 1);
+        CHECK(uri.queryIntItems["foo"] == 2);
+        CHECK(uri.queryDoubleItems.empty());
+
+        settings.query_item_separators = 0;
+        settings.query_item_key_separators = 0;
+    }
+
+    SECTION("CompiledGrammar", "")
+    {
+        const std::string pathStr("foo:2;bar&baz:baz=Value;foobar=.5");
+
+        curi_query_grammar grammar;
+        settings.query_item_separators = "&;";
+        settings.query_item_key_separators = ":";
+        curi_compile_query_grammar(&grammar, &settings);
+        settings.query_item_separators = 0;
+        settings.query_item_key_separators = 0;
+        settings.query_grammar = &grammar;
+
+        CHECK(curi_status_success == curi_parse_query_nt(pathStr.c_str(), &settings, &uri));
+
+        CHECK(uri.queryNullItems.size() == 2);
+        CHECK(uri.queryNullItems.find("bar") != uri.queryNullItems.end());
+        CHECK(uri.queryNullItems.find("foobar=.5") != uri.queryNullItems.end());
+        CHECK(uri.queryStrItems.size() == 1);
+        CHECK(uri.queryStrItems["baz"] == "baz=Value");
+        CHECK(uri.queryIntItems.size() == 1);
+        CHECK(uri.queryIntItems["foo"] == 2);
+
+        settings.query_grammar = 0;
+    }
+
+    SECTION("DefaultGrammar", "")
+    {
+        const std::string pathStr("a=%41&b=c=d&e");
+
+        curi_query_grammar grammar;
+        curi_query_grammar defaultGrammar;
+        settings.query_item_separators = "&";
+        settings.query_item_key_separators = "=";
+        curi_compile_query_grammar(&grammar, &settings);
+        settings.query_item_separators = 0;
+        settings.query_item_key_separators = 0;
+        curi_compile_query_grammar(&defaultGrammar, &settings);
+
+        CHECK(std::memcmp(grammar.classes, defaultGrammar.classes, sizeof(grammar.classes)) == 0);
+
+        CHECK(curi_status_success == curi_parse_query_nt(pathStr.c_str(), &settings, &uri));
+
+        CHECK(uri.queryStrItems.size() == 2);
+        CHECK(uri.queryStrItems["a"] == "%41");
+        CHECK(uri.queryStrItems["b"] == "c=d");
+        CHECK(uri.queryNullItems.size() == 1);
+    }
+
+    SECTION("PercentSeparator", "")
+    {
+        const std::string pathStr("foo%bar%baz=%41");
+
+        settings.query_item_separator = '%';
+
+        CHECK(curi_status_success == curi_parse_query_nt(pathStr.c_str(), &settings, &uri));
+
+        CHECK(uri.queryNullItems.size() == 4);
+        CHECK(uri.queryNullItems.find("foo") != uri.queryNullItems.end());
+        CHECK(uri.queryNullItems.find("bar") != uri.queryNullItems.end());
+        CHECK(uri.queryNullItems.find("baz") != uri.queryNullItems.end());
+        CHECK(uri.queryNullItems.find("41") != uri.queryNullItems.end());
+
+        settings.query_item_separator = '&';
+    }
+
     uri.clear();
 }
 
@@ -0,0 +1,219 @@
+// Copyright (c) 2013 Clodéric Mars
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "Common.h"
+
+#include <curi.h>
+
+#include <cstring>
+
+TEST_CASE("ParseUriReference/Success", "Valid URI references")
+{
+    curi_settings settings;
+    curi_default_settings(&settings);
+    settings.scheme_callback = scheme;
+    settings.userinfo_callback = userinfo;
+    settings.host_callback = host;
+    settings.portStr_callback = portStr;
+    settings.path_callback = path;
+    settings.query_callback = query;
+    settings.fragment_callback = fragment;
+
+    URI uri;
+    uri.clear();
+
+    curi_reference_form form = curi_reference_relative_path;
+
+    SECTION("Uri", "")
+    {
+        const std::string uriStr("foo://bar@example.com:8042/over/there?name=ferret#nose");
+
+        CHECK(curi_status_success == curi_parse_uri_reference(uriStr.c_str(), uriStr.length(), &form, 0, &settings, &uri));
+
+        CHECK(form == curi_reference_uri);
+        CHECK(uri.scheme == "foo");
+        CHECK(uri.userinfo == "bar");
+        CHECK(uri.host == "example.com");
+        CHECK(uri.portStr == "8042");
+        CHECK(uri.path == "/over/there");
+        CHECK(uri.query == "name=ferret");
+        CHECK(uri.fragment == "nose");
+    }
+
+    SECTION("UriWithoutAuthority", "")
+    {
+        const std::string uriStr("mailto:John.Doe@example.com");
+
+        CHECK(curi_status_success == curi_parse_uri_reference_nt(uriStr.c_str(), &form, 0, &settings, &uri));
+
+        CHECK(form == curi_reference_uri);
+        CHECK(uri.scheme == "mailto");
+        CHECK(uri.path == "John.Doe@example.com");
+    }
+
+    SECTION("NetworkPath", "")
+    {
+        const std::string uriStr("//cdn.example.com:8080/x.js?v=2");
+
+        CHECK(curi_status_success == curi_parse_uri_reference(uriStr.c_str(), uriStr.length(), &form, 0, &settings, &uri));
+
+        CHECK(form == curi_reference_network_path);
+        CHECK(uri.scheme.empty());
+        CHECK(uri.host == "cdn.example.com");
+        CHECK(uri.portStr == "8080");
+        CHECK(uri.path == "/x.js");
+        CHECK(uri.query == "v=2");
+    }
+
+    SECTION("AbsolutePath", "")
+    {
+        const std::string uriStr("/a/b?c#d");
+
+        CHECK(curi_status_success == curi_parse_uri_reference(uriStr.c_str(), uriStr.length(), &form, 0, &settings, &uri));
+
+        CHECK(form == curi_reference_absolute_path);
+        CHECK(uri.host.empty());
+        CHECK(uri.path == "/a/b");
+        CHECK(uri.query == "c");
+        CHECK(uri.fragment == "d");
+    }
+
+    SECTION("RelativePath", "")
+    {
+        const std::string uriStr("../img.png");
+
+        CHECK(curi_status_success == curi_parse_uri_reference(uriStr.c_str(), uriStr.length(), &form, 0, &settings, &uri));
+
+        CHECK(form == curi_reference_relative_path);
+        CHECK(uri.path == "../img.png");
+    }
+
+    SECTION("ColonAfterFirstSegment", "")
+    {
+        const std::string uriStr("a-b/c:d");
+
+        CHECK(curi_status_success == curi_parse_uri_reference(uriStr.c_str(), uriStr.length(), &form, 0, &settings, &uri));
+
+        CHECK(form == curi_reference_relative_path);
+        CHECK(uri.path == "a-b/c:d");
+    }
+
+    SECTION("SchemeCharactersInPath", "")
+    {
+        const std::string uriStr("a+b.c-d@e/f?g");
+
+        CHECK(curi_status_success == curi_parse_uri_reference(uriStr.c_str(), uriStr.length(), &form, 0, &settings, &uri));
+
+        CHECK(form == curi_reference_relative_path);
+        CHECK(uri.scheme.empty());
+        CHECK(uri.path == "a+b.c-d@e/f");
+        CHECK(uri.query == "g");
+    }
+
+    SECTION("UppercaseScheme", "")
+    {
+        const std::string uriStr("HTTP://example.com/a");
+
+        CHECK(curi_status_success == curi_parse_uri_reference(uriStr.c_str(), uriStr.length(), &form, 0, &settings, &uri));
+
+        CHECK(form == curi_reference_uri);
+        CHECK(uri.scheme == "HTTP");
+        CHECK(uri.host == "example.com");
+        CHECK(uri.path == "/a");
+    }
+
+    SECTION("QueryOnly", "")
+    {
+        const std::string uriStr("?name=ferret");
+
+        CHECK(curi_status_success == curi_parse_uri_reference(uriStr.c_str(), uriStr.length(), &form, 0, &settings, &uri));
+
+        CHECK(form == curi_reference_relative_path);
+        CHECK(uri.path.empty());
+        CHECK(uri.query == "name=ferret");
+    }
+
+    SECTION("Empty", "")
+    {
+        CHECK(curi_status_success == curi_parse_uri_reference("", 0, &form, 0, &settings, &uri));
+
+        CHECK(form == curi_reference_relative_path);
+    }
+
+    SECTION("NoForm", "")
+    {
+        const std::string uriStr("/a/b");
+
+        CHECK(curi_status_success == curi_parse_uri_reference(uriStr.c_str(), uriStr.length(), 0, 0, 0, 0));
+    }
+}
+
+TEST_CASE("ParseUriReference/Error", "Invalid URI references")
+{
+    curi_settings settings;
+    curi_default_settings(&settings);
+    settings.path_callback = path;
+
+    curi_error error;
+
+    URI uri;
+    uri.clear();
+
+    SECTION("ColonInFirstSegment", "")
+    {
+        const std::string uriStr("1a:b/c");
+
+        CHECK(curi_status_error == curi_parse_uri_reference(uriStr.c_str(), uriStr.length(), 0, &error, &settings, &uri));
+
+        CHECK(error.rule == curi_error_scheme);
+        CHECK(error.offset == 2);
+        CHECK(uri.path.empty());
+    }
+
+    SECTION("ColonAfterSchemeCharacters", "")
+    {
+        const std::string uriStr("a%20b:c");
+
+        CHECK(curi_status_error == curi_parse_uri_reference(uriStr.c_str(), uriStr.length(), 0, &error, &settings, &uri));
+
+        CHECK(error.rule == curi_error_scheme);
+        CHECK(error.offset == 5);
+    }
+
+    SECTION("LeadingColon", "")
+    {
+        const std::string uriStr(":b");
+
+        CHECK(curi_status_error == curi_parse_uri_reference(uriStr.c_str(), uriStr.length(), 0, &error, &settings, &uri));
+
+        CHECK(error.rule == curi_error_scheme);
+        CHECK(error.offset == 0);
+    }
+
+    SECTION("TrailingCharacters", "")
+    {
+        const std::string uriStr("/a b");
+
+        CHECK(curi_status_error == curi_parse_uri_reference(uriStr.c_str(), uriStr.length(), 0, &error, &settings, &uri));
+
+        CHECK(error.rule == curi_error_trailing_characters);
+        CHECK(error.offset == 2);
+    }
+}
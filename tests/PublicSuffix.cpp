@@ -0,0 +1,188 @@
+// Copyright (c) 2013 Clodéric Mars
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "Common.h"
+
+#include <curi.h>
+
+#include <cstring>
+
+static const char* const publicSuffixList =
+    "// ===BEGIN ICANN DOMAINS===\n"
+    "\n"
+    "com\n"
+    "uk\n"
+    "co.uk // United Kingdom\n"
+    "jp\n"
+    "ac.jp\n"
+    "*.kobe.jp\n"
+    "!city.kobe.jp\n"
+    "*.ck\r\n"
+    "!www.ck\r\n"
+    "us\n"
+    "k12.ak.us\n";
+
+static std::string registrableDomain(const curi_public_suffix_list* list, const std::string& host)
+{
+    size_t domainOffset = 0;
+    size_t domainLen = 0;
+    REQUIRE(curi_status_success == curi_registrable_domain(list, host.c_str(), host.length(), &domainOffset, &domainLen));
+    return host.substr(domainOffset, domainLen);
+}
+
+static curi_status registrableDomainStatus(const curi_public_suffix_list* list, const std::string& host)
+{
+    size_t domainOffset = 0;
+    return curi_registrable_domain(list, host.c_str(), host.length(), &domainOffset, 0);
+}
+
+TEST_CASE("PublicSuffix/RegistrableDomain", "Registrable domain of hosts")
+{
+    URI uri;
+    uri.clear();
+
+    curi_settings settings;
+    curi_default_settings(&settings);
+    settings.allocate = test_allocate;
+    settings.deallocate = test_deallocate;
+
+    curi_public_suffix_list* list = curi_public_suffix_list_create(publicSuffixList, strlen(publicSuffixList), &settings, &uri);
+    REQUIRE(list);
+
+    SECTION("Rules", "")
+    {
+        CHECK(registrableDomain(list, "example.com") == "example.com");
+        CHECK(registrableDomain(list, "a.b.example.com") == "example.com");
+        CHECK(registrableDomain(list, "a.b.example.co.uk") == "example.co.uk");
+        CHECK(registrableDomain(list, "example.uk") == "example.uk");
+        CHECK(registrableDomain(list, "test.ac.jp") == "test.ac.jp");
+        CHECK(registrableDomain(list, "www.test.k12.ak.us") == "test.k12.ak.us");
+        CHECK(registrableDomain(list, "ak.us") == "ak.us");
+    }
+
+    SECTION("Implicit", "")
+    {
+        CHECK(registrableDomain(list, "example.example") == "example.example");
+        CHECK(registrableDomain(list, "b.example.example") == "example.example");
+    }
+
+    SECTION("Wildcard", "")
+    {
+        CHECK(registrableDomain(list, "b.c.kobe.jp") == "b.c.kobe.jp");
+        CHECK(registrableDomain(list, "a.b.c.kobe.jp") == "b.c.kobe.jp");
+        CHECK(registrableDomain(list, "b.test.ck") == "b.test.ck");
+        CHECK(curi_status_error == registrableDomainStatus(list, "c.kobe.jp"));
+        CHECK(curi_status_error == registrableDomainStatus(list, "test.ck"));
+    }
+
+    SECTION("Exception", "")
+    {
+        CHECK(registrableDomain(list, "city.kobe.jp") == "city.kobe.jp");
+        CHECK(registrableDomain(list, "www.city.kobe.jp") == "city.kobe.jp");
+        CHECK(registrableDomain(list, "www.ck") == "www.ck");
+        CHECK(registrableDomain(list, "www.www.ck") == "www.ck");
+    }
+
+    SECTION("Case", "")
+    {
+        CHECK(registrableDomain(list, "WWW.Example.CO.UK") == "Example.CO.UK");
+        CHECK(registrableDomain(list, "www.City.Kobe.JP") == "City.Kobe.JP");
+    }
+
+    SECTION("TrailingDot", "")
+    {
+        CHECK(registrableDomain(list, "www.example.com.") == "example.com");
+    }
+
+    SECTION("Errors", "")
+    {
+        CHECK(curi_status_error == registrableDomainStatus(list, ""));
+        CHECK(curi_status_error == registrableDomainStatus(list, "."));
+        CHECK(curi_status_error == registrableDomainStatus(list, "com"));
+        CHECK(curi_status_error == registrableDomainStatus(list, "co.uk"));
+        CHECK(curi_status_error == registrableDomainStatus(list, "example"));
+        CHECK(curi_status_error == registrableDomainStatus(list, ".com"));
+        CHECK(curi_status_error == registrableDomainStatus(list, "example..com"));
+        CHECK(curi_status_error == registrableDomainStatus(list, "k12.ak.us"));
+    }
+
+    curi_public_suffix_list_destroy(list);
+    CHECK(uri.deallocatedMemory == uri.allocatedMemory);
+}
+
+TEST_CASE("PublicSuffix/InvalidList", "Compiling invalid public suffix lists")
+{
+    URI uri;
+    uri.clear();
+
+    curi_settings settings;
+    curi_default_settings(&settings);
+    settings.allocate = test_allocate;
+    settings.deallocate = test_deallocate;
+
+    CHECK(!curi_public_suffix_list_create("com\nexample..com\n", 17, &settings, &uri));
+    CHECK(!curi_public_suffix_list_create("com.\n", 5, &settings, &uri));
+    CHECK(!curi_public_suffix_list_create(".com\n", 5, &settings, &uri));
+    CHECK(!curi_public_suffix_list_create(".a.com\n", 7, &settings, &uri));
+    CHECK(!curi_public_suffix_list_create("com\n!.a.com\n", 12, &settings, &uri));
+    CHECK(!curi_public_suffix_list_create("!\n", 2, &settings, &uri));
+    CHECK(uri.deallocatedMemory == uri.allocatedMemory);
+}
+
+TEST_CASE("PublicSuffix/Parse", "Registrable domain while parsing")
+{
+    URI uri;
+    uri.clear();
+
+    curi_settings settings;
+    curi_default_settings(&settings);
+    settings.host_callback = host;
+    settings.registrable_domain_callback = registrableDomain;
+    settings.public_suffix_list = curi_public_suffix_list_create(publicSuffixList, strlen(publicSuffixList), 0, 0);
+    REQUIRE(settings.public_suffix_list);
+
+    SECTION("RegName", "")
+    {
+        CHECK(curi_status_success == curi_parse_full_uri_nt("http://a.b.example.co.uk:8080/path", &settings, &uri));
+        CHECK(uri.host == "a.b.example.co.uk");
+        CHECK(uri.registrableDomain == "example.co.uk");
+    }
+
+    SECTION("PublicSuffix", "")
+    {
+        CHECK(curi_status_success == curi_parse_full_uri_nt("http://co.uk/path", &settings, &uri));
+        CHECK(uri.host == "co.uk");
+        CHECK(uri.registrableDomain == "");
+    }
+
+    SECTION("IP", "")
+    {
+        CHECK(curi_status_success == curi_parse_full_uri_nt("http://192.168.0.1/path", &settings, &uri));
+        CHECK(uri.registrableDomain == "");
+    }
+
+    SECTION("Cancelled", "")
+    {
+        settings.registrable_domain_callback = cancellingCallbackStr;
+        CHECK(curi_status_canceled == curi_parse_full_uri_nt("http://www.example.com/path", &settings, &uri));
+    }
+
+    curi_public_suffix_list_destroy((curi_public_suffix_list*)settings.public_suffix_list);
+}
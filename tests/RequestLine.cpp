@@ -0,0 +1,271 @@
+// Copyright (c) 2013 Clodéric Mars
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "Common.h"
+
+#include <curi.h>
+
+#include <cstring>
+
+TEST_CASE("RequestLine/Success", "Valid request lines")
+{
+    curi_settings settings;
+    curi_default_settings(&settings);
+    settings.scheme_callback = scheme;
+    settings.host_callback = host;
+    settings.portStr_callback = portStr;
+    settings.path_callback = path;
+    settings.query_callback = query;
+
+    URI uri;
+    uri.clear();
+
+    curi_request_line requestLine;
+
+    SECTION("OriginForm", "")
+    {
+        const std::string line("GET /where?q=now HTTP/1.1");
+
+        CHECK(curi_status_success == curi_parse_request_line(line.c_str(), line.length(), &requestLine, 0, &settings, &uri));
+
+        CHECK(requestLine.method == curi_method_get);
+        CHECK(std::string(requestLine.methodName, requestLine.methodNameLen) == "GET");
+        CHECK(requestLine.targetForm == curi_request_target_origin);
+        CHECK(std::string(requestLine.target, requestLine.targetLen) == "/where?q=now");
+        CHECK(requestLine.versionMajor == 1);
+        CHECK(requestLine.versionMinor == 1);
+        CHECK(uri.path == "/where");
+        CHECK(uri.query == "q=now");
+    }
+
+    SECTION("AbsoluteForm", "")
+    {
+        const std::string line("POST http://www.example.org:8080/pub/WWW/TheProject.html HTTP/1.0\r\n");
+
+        CHECK(curi_status_success == curi_parse_request_line_nt(line.c_str(), &requestLine, 0, &settings, &uri));
+
+        CHECK(requestLine.method == curi_method_post);
+        CHECK(requestLine.targetForm == curi_request_target_absolute);
+        CHECK(std::string(requestLine.target, requestLine.targetLen) == "http://www.example.org:8080/pub/WWW/TheProject.html");
+        CHECK(requestLine.versionMajor == 1);
+        CHECK(requestLine.versionMinor == 0);
+        CHECK(uri.scheme == "http");
+        CHECK(uri.host == "www.example.org");
+        CHECK(uri.portStr == "8080");
+        CHECK(uri.path == "/pub/WWW/TheProject.html");
+    }
+
+    SECTION("AuthorityForm", "")
+    {
+        const std::string line("CONNECT www.example.com:443 HTTP/1.1");
+
+        CHECK(curi_status_success == curi_parse_request_line(line.c_str(), line.length(), &requestLine, 0, &settings, &uri));
+
+        CHECK(requestLine.method == curi_method_connect);
+        CHECK(requestLine.targetForm == curi_request_target_authority);
+        CHECK(uri.scheme.empty());
+        CHECK(uri.host == "www.example.com");
+        CHECK(uri.portStr == "443");
+        CHECK(uri.path.empty());
+    }
+
+    SECTION("AsteriskForm", "")
+    {
+        const std::string line("OPTIONS * HTTP/1.1");
+
+        CHECK(curi_status_success == curi_parse_request_line(line.c_str(), line.length(), &requestLine, 0, &settings, &uri));
+
+        CHECK(requestLine.method == curi_method_options);
+        CHECK(requestLine.targetForm == curi_request_target_asterisk);
+        CHECK(std::string(requestLine.target, requestLine.targetLen) == "*");
+    }
+
+    SECTION("KnownMethods", "")
+    {
+        const char* methods[] = {"GET", "HEAD", "POST", "PUT", "DELETE", "OPTIONS", "TRACE", "PATCH"};
+        const curi_method expected[] = {curi_method_get, curi_method_head, curi_method_post, curi_method_put, curi_method_delete, curi_method_options, curi_method_trace, curi_method_patch};
+        size_t i;
+
+        for (i = 0 ; i < sizeof(methods) / sizeof(methods[0]) ; ++i)
+        {
+            const std::string line(std::string(methods[i]) + " / HTTP/1.1");
+
+            CHECK(curi_status_success == curi_parse_request_line(line.c_str(), line.length(), &requestLine, 0, 0, 0));
+            CHECK(requestLine.method == expected[i]);
+        }
+    }
+
+    SECTION("UnknownMethod", "")
+    {
+        const std::string line("PROPFIND /dav/ HTTP/1.1");
+
+        CHECK(curi_status_success == curi_parse_request_line(line.c_str(), line.length(), &requestLine, 0, 0, 0));
+
+        CHECK(requestLine.method == curi_method_unknown);
+        CHECK(std::string(requestLine.methodName, requestLine.methodNameLen) == "PROPFIND");
+    }
+
+    SECTION("CaseSensitiveMethod", "")
+    {
+        const std::string line("get / HTTP/1.1");
+
+        CHECK(curi_status_success == curi_parse_request_line(line.c_str(), line.length(), &requestLine, 0, 0, 0));
+
+        CHECK(requestLine.method == curi_method_unknown);
+    }
+
+    SECTION("Components", "")
+    {
+        const std::string line("GET http://example.com/over/there?name=ferret HTTP/1.1");
+        settings.components = curi_component_host;
+
+        CHECK(curi_status_partial == curi_parse_request_line(line.c_str(), line.length(), &requestLine, 0, &settings, &uri));
+
+        CHECK(uri.host == "example.com");
+        CHECK(uri.path.empty());
+    }
+
+    SECTION("OriginFormComponents", "")
+    {
+        const std::string line("GET /where?q=now HTTP/1.1");
+        settings.components = curi_component_path;
+
+        CHECK(curi_status_partial == curi_parse_request_line(line.c_str(), line.length(), &requestLine, 0, &settings, &uri));
+
+        CHECK(requestLine.targetForm == curi_request_target_origin);
+        CHECK(std::string(requestLine.target, requestLine.targetLen) == "/where");
+        CHECK(uri.path == "/where");
+        CHECK(uri.query.empty());
+    }
+
+    SECTION("OriginFormQueryComponent", "")
+    {
+        const std::string line("GET /where?q=now HTTP/1.1");
+        settings.components = curi_component_query;
+
+        CHECK(curi_status_partial == curi_parse_request_line(line.c_str(), line.length(), &requestLine, 0, &settings, &uri));
+
+        CHECK(uri.path == "/where");
+        CHECK(uri.query == "q=now");
+    }
+
+    SECTION("SuccessWithError", "")
+    {
+        const char* lines[] = {"CONNECT www.example.com:443 HTTP/1.1", "GET http://a.com HTTP/1.1", "GET /a?b HTTP/1.1"};
+        curi_error error;
+        size_t i;
+
+        for (i = 0 ; i < sizeof(lines) / sizeof(lines[0]) ; ++i)
+        {
+            CHECK(curi_status_success == curi_parse_request_line_nt(lines[i], &requestLine, &error, 0, 0));
+            CHECK(error.rule == curi_error_none);
+        }
+    }
+}
+
+TEST_CASE("RequestLine/Error", "Invalid request lines")
+{
+    curi_settings settings;
+    curi_default_settings(&settings);
+
+    curi_error error;
+
+    SECTION("EmptyMethod", "")
+    {
+        const std::string line(" / HTTP/1.1");
+
+        CHECK(curi_status_error == curi_parse_request_line(line.c_str(), line.length(), 0, &error, &settings, 0));
+
+        CHECK(error.rule == curi_error_method);
+        CHECK(error.offset == 0);
+    }
+
+    SECTION("BadMethod", "")
+    {
+        const std::string line("GE(T / HTTP/1.1");
+
+        CHECK(curi_status_error == curi_parse_request_line(line.c_str(), line.length(), 0, &error, &settings, 0));
+
+        CHECK(error.rule == curi_error_method);
+        CHECK(error.offset == 2);
+    }
+
+    SECTION("BadTarget", "")
+    {
+        const std::string line("GET /a\"b HTTP/1.1");
+
+        CHECK(curi_status_error == curi_parse_request_line(line.c_str(), line.length(), 0, &error, &settings, 0));
+
+        CHECK(error.rule == curi_error_trailing_characters);
+        CHECK(error.offset == 6);
+    }
+
+    SECTION("Fragment", "")
+    {
+        const std::string line("GET /a#b HTTP/1.1");
+
+        CHECK(curi_status_error == curi_parse_request_line(line.c_str(), line.length(), 0, &error, &settings, 0));
+
+        CHECK(error.rule == curi_error_trailing_characters);
+        CHECK(error.offset == 6);
+    }
+
+    SECTION("ConnectWithoutHost", "")
+    {
+        const std::string line("CONNECT :443 HTTP/1.1");
+
+        CHECK(curi_status_error == curi_parse_request_line(line.c_str(), line.length(), 0, &error, &settings, 0));
+
+        CHECK(error.rule == curi_error_authority);
+        CHECK(error.offset == 8);
+    }
+
+    SECTION("BadVersion", "")
+    {
+        const char* lines[] = {"GET / HTTP/1", "GET / HTTP/1.", "GET / HTTP/a.1", "GET / http/1.1", "GET / HTTP/11"};
+        size_t i;
+
+        for (i = 0 ; i < sizeof(lines) / sizeof(lines[0]) ; ++i)
+        {
+            CHECK(curi_status_error == curi_parse_request_line_nt(lines[i], 0, &error, &settings, 0));
+            CHECK(error.rule == curi_error_http_version);
+            CHECK(error.offset == 6);
+        }
+    }
+
+    SECTION("MissingVersion", "")
+    {
+        const std::string line("GET /");
+
+        CHECK(curi_status_error == curi_parse_request_line(line.c_str(), line.length(), 0, &error, &settings, 0));
+
+        CHECK(error.rule == curi_error_trailing_characters);
+    }
+
+    SECTION("TrailingCharacters", "")
+    {
+        const std::string line("GET / HTTP/1.1 ");
+
+        CHECK(curi_status_error == curi_parse_request_line(line.c_str(), line.length(), 0, &error, &settings, 0));
+
+        CHECK(error.rule == curi_error_trailing_characters);
+        CHECK(error.offset == 14);
+    }
+}
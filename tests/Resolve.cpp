@@ -0,0 +1,123 @@
+// Copyright (c) 2013 Clodéric Mars
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "Common.h"
+
+#include <curi.h>
+
+static const std::string base("http://a/b/c/d;p?q");
+
+static std::string resolve(const std::string& base, const std::string& reference)
+{
+    char output[256];
+    size_t outputLen = 0;
+    REQUIRE(curi_status_success == curi_resolve(base.c_str(), base.length(), reference.c_str(), reference.length(), output, sizeof(output), &outputLen));
+    return std::string(output, outputLen);
+}
+
+TEST_CASE("Resolve/Normal", "RFC-3986 normal examples")
+{
+    CHECK(resolve(base, "g:h") == "g:h");
+    CHECK(resolve(base, "g") == "http://a/b/c/g");
+    CHECK(resolve(base, "./g") == "http://a/b/c/g");
+    CHECK(resolve(base, "g/") == "http://a/b/c/g/");
+    CHECK(resolve(base, "/g") == "http://a/g");
+    CHECK(resolve(base, "//g") == "http://g");
+    CHECK(resolve(base, "?y") == "http://a/b/c/d;p?y");
+    CHECK(resolve(base, "g?y") == "http://a/b/c/g?y");
+    CHECK(resolve(base, "#s") == "http://a/b/c/d;p?q#s");
+    CHECK(resolve(base, "g#s") == "http://a/b/c/g#s");
+    CHECK(resolve(base, "g?y#s") == "http://a/b/c/g?y#s");
+    CHECK(resolve(base, ";x") == "http://a/b/c/;x");
+    CHECK(resolve(base, "g;x") == "http://a/b/c/g;x");
+    CHECK(resolve(base, "g;x?y#s") == "http://a/b/c/g;x?y#s");
+    CHECK(resolve(base, "") == "http://a/b/c/d;p?q");
+    CHECK(resolve(base, ".") == "http://a/b/c/");
+    CHECK(resolve(base, "./") == "http://a/b/c/");
+    CHECK(resolve(base, "..") == "http://a/b/");
+    CHECK(resolve(base, "../") == "http://a/b/");
+    CHECK(resolve(base, "../g") == "http://a/b/g");
+    CHECK(resolve(base, "../..") == "http://a/");
+    CHECK(resolve(base, "../../") == "http://a/");
+    CHECK(resolve(base, "../../g") == "http://a/g");
+}
+
+TEST_CASE("Resolve/Abnormal", "RFC-3986 abnormal examples")
+{
+    CHECK(resolve(base, "../../../g") == "http://a/g");
+    CHECK(resolve(base, "../../../../g") == "http://a/g");
+    CHECK(resolve(base, "/./g") == "http://a/g");
+    CHECK(resolve(base, "/../g") == "http://a/g");
+    CHECK(resolve(base, "g.") == "http://a/b/c/g.");
+    CHECK(resolve(base, ".g") == "http://a/b/c/.g");
+    CHECK(resolve(base, "g..") == "http://a/b/c/g..");
+    CHECK(resolve(base, "..g") == "http://a/b/c/..g");
+    CHECK(resolve(base, "./../g") == "http://a/b/g");
+    CHECK(resolve(base, "./g/.") == "http://a/b/c/g/");
+    CHECK(resolve(base, "g/./h") == "http://a/b/c/g/h");
+    CHECK(resolve(base, "g/../h") == "http://a/b/c/h");
+    CHECK(resolve(base, "g;x=1/./y") == "http://a/b/c/g;x=1/y");
+    CHECK(resolve(base, "g;x=1/../y") == "http://a/b/c/y");
+    CHECK(resolve(base, "g?y/./x") == "http://a/b/c/g?y/./x");
+    CHECK(resolve(base, "g?y/../x") == "http://a/b/c/g?y/../x");
+    CHECK(resolve(base, "g#s/./x") == "http://a/b/c/g#s/./x");
+    CHECK(resolve(base, "g#s/../x") == "http://a/b/c/g#s/../x");
+    CHECK(resolve(base, "http:g") == "http:g");
+}
+
+TEST_CASE("Resolve/Base", "Resolution against various bases")
+{
+    CHECK(resolve("http://example.com", "a/b") == "http://example.com/a/b");
+    CHECK(resolve("http://example.com?q", "") == "http://example.com?q");
+    CHECK(resolve("http://user@example.com:8080/a/b#frag", "c") == "http://user@example.com:8080/a/c");
+    CHECK(resolve("http://[::1]/a/b", "../c?x#y") == "http://[::1]/c?x#y");
+    CHECK(resolve("mailto:a/b", "c") == "mailto:a/c");
+    CHECK(resolve("file:///etc/hosts", "passwd") == "file:///etc/passwd");
+}
+
+TEST_CASE("Resolve/Error", "Resolution errors")
+{
+    char output[256];
+
+    SECTION("RelativeBase", "")
+    {
+        CHECK(curi_status_error == curi_resolve("/a/b", 4, "c", 1, output, sizeof(output), 0));
+    }
+
+    SECTION("InvalidReference", "")
+    {
+        CHECK(curi_status_error == curi_resolve(base.c_str(), base.length(), "a b", 3, output, sizeof(output), 0));
+        CHECK(curi_status_error == curi_resolve(base.c_str(), base.length(), "1a:b", 4, output, sizeof(output), 0));
+    }
+
+    SECTION("OutputTooSmall", "")
+    {
+        CHECK(curi_status_error == curi_resolve(base.c_str(), base.length(), "g", 1, output, 10, 0));
+        CHECK(curi_status_error == curi_resolve(base.c_str(), base.length(), "g?y#s", 5, output, 17, 0));
+        CHECK(curi_status_success == curi_resolve(base.c_str(), base.length(), "g?y#s", 5, output, 18, 0));
+    }
+
+    SECTION("NotNullTerminated", "")
+    {
+        size_t outputLen = 0;
+        CHECK(curi_status_success == curi_resolve("http://a/b/c#d", 10, "../x?y", 4, output, sizeof(output), &outputLen));
+        CHECK(std::string(output, outputLen) == "http://a/x");
+    }
+}
@@ -0,0 +1,206 @@
+// Copyright (c) 2013 Clodéric Mars
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "Common.h"
+
+#include <curi.h>
+
+#include <cstring>
+
+enum
+{
+    GET = 1,
+    POST = 2,
+    DELETE = 4
+};
+
+static const char* const routes[] = {
+    "/",
+    "/users",
+    "/users",
+    "/users/new",
+    "/users/{id}",
+    "/users/{id}/posts/{post}",
+    "/users/{id}/edit",
+    "/static/*",
+    "/users/new/edit"
+};
+
+static const unsigned int routeMethods[] = {
+    GET,
+    GET,
+    POST,
+    GET,
+    GET | DELETE,
+    GET,
+    GET | POST,
+    GET,
+    GET
+};
+
+static const size_t routeCount = sizeof(routes) / sizeof(routes[0]);
+
+static std::string capture(const curi_route_match& match, size_t i)
+{
+    REQUIRE(i < match.captureCount);
+    return std::string(match.captures[i].str ? match.captures[i].str : "", match.captures[i].len);
+}
+
+static size_t route(const curi_router* router, const char* path, unsigned int methods, curi_route_match& match)
+{
+    size_t routeId = routeCount;
+    REQUIRE(curi_status_success == curi_route_path(router, path, strlen(path), methods, &match, &routeId));
+    return routeId;
+}
+
+TEST_CASE("Route/Match", "Matching paths against routes")
+{
+    URI uri;
+    uri.clear();
+
+    curi_settings settings;
+    curi_default_settings(&settings);
+    settings.allocate = test_allocate;
+    settings.deallocate = test_deallocate;
+
+    curi_router* router = curi_router_create(routes, routeMethods, routeCount, &settings, &uri);
+    REQUIRE(router);
+
+    curi_route_match match;
+
+    SECTION("Static", "")
+    {
+        CHECK(route(router, "/", GET, match) == 0);
+        CHECK(route(router, "/users", GET, match) == 1);
+        CHECK(route(router, "/users/", GET, match) == 1);
+        CHECK(route(router, "/users/new", GET, match) == 3);
+        CHECK(match.captureCount == 0);
+    }
+
+    SECTION("Methods", "")
+    {
+        CHECK(route(router, "/users", POST, match) == 2);
+        CHECK(route(router, "/users/12", DELETE, match) == 4);
+
+        size_t routeId;
+        CHECK(curi_status_error == curi_route_path(router, "/users", 6, DELETE, &match, &routeId));
+        CHECK(match.allowedMethods == (GET | POST));
+    }
+
+    SECTION("Parameters", "")
+    {
+        CHECK(route(router, "/users/12", GET, match) == 4);
+        CHECK(capture(match, 0) == "12");
+
+        CHECK(route(router, "/users/12/posts/hello-world", GET, match) == 5);
+        CHECK(match.captureCount == 2);
+        CHECK(capture(match, 0) == "12");
+        CHECK(capture(match, 1) == "hello-world");
+    }
+
+    SECTION("Backtracking", "")
+    {
+        CHECK(route(router, "/users/new/posts/1", GET, match) == 5);
+        CHECK(capture(match, 0) == "new");
+        CHECK(capture(match, 1) == "1");
+
+        CHECK(route(router, "/users/new/edit", POST, match) == 6);
+        CHECK(capture(match, 0) == "new");
+
+        CHECK(route(router, "/users/new/edit", GET, match) == 8);
+        CHECK(match.captureCount == 0);
+    }
+
+    SECTION("Wildcard", "")
+    {
+        CHECK(route(router, "/static/css/main.css", GET, match) == 7);
+        CHECK(capture(match, 0) == "css/main.css");
+
+        CHECK(route(router, "/static", GET, match) == 7);
+        CHECK(capture(match, 0) == "");
+    }
+
+    SECTION("NotFound", "")
+    {
+        size_t routeId;
+        CHECK(curi_status_error == curi_route_path(router, "/posts", 6, GET, &match, &routeId));
+        CHECK(match.allowedMethods == 0);
+        CHECK(curi_status_error == curi_route_path(router, "/users/1/posts", 14, GET, &match, &routeId));
+        CHECK(curi_status_error == curi_route_path(router, "/users/1/edit/2", 15, GET, &match, &routeId));
+    }
+
+    SECTION("TooManySegments", "")
+    {
+        std::string path;
+        for (int i = 0 ; i <= CURI_ROUTE_MAX_SEGMENTS ; ++i)
+            path += "/static";
+
+        size_t routeId;
+        CHECK(curi_status_limit_exceeded == curi_route_path(router, path.c_str(), path.length(), GET, &match, &routeId));
+    }
+
+    curi_router_destroy(router);
+    CHECK(uri.deallocatedMemory == uri.allocatedMemory);
+}
+
+TEST_CASE("Route/Parse", "Matching paths while parsing URIs")
+{
+    curi_router* router = curi_router_create(routes, 0, routeCount, 0, 0);
+    REQUIRE(router);
+
+    curi_route_match match;
+    curi_route_match_init(&match, router, GET);
+
+    curi_settings settings;
+    curi_default_settings(&settings);
+    settings.path_segment_callback = curi_route_match_segment;
+
+    CHECK(curi_status_success == curi_parse_full_uri_nt("http://example.com/users/42/posts/7?x=1#top", &settings, &match));
+
+    size_t routeId;
+    CHECK(curi_status_success == curi_route_match_end(&match, &routeId));
+    CHECK(routeId == 5);
+    CHECK(capture(match, 0) == "42");
+    CHECK(capture(match, 1) == "7");
+
+    curi_router_destroy(router);
+}
+
+TEST_CASE("Route/InvalidRoutes", "Compiling invalid routes")
+{
+    URI uri;
+    uri.clear();
+
+    curi_settings settings;
+    curi_default_settings(&settings);
+    settings.allocate = test_allocate;
+    settings.deallocate = test_deallocate;
+
+    const char* wildcardNotLast[] = { "/a/*/b" };
+    CHECK(!curi_router_create(wildcardNotLast, 0, 1, &settings, &uri));
+
+    std::string manyParameters;
+    for (int i = 0 ; i <= CURI_ROUTE_MAX_CAPTURES ; ++i)
+        manyParameters += "/{p}";
+    const char* tooManyCaptures[] = { "/a", manyParameters.c_str() };
+    CHECK(!curi_router_create(tooManyCaptures, 0, 2, &settings, &uri));
+
+    CHECK(uri.deallocatedMemory == uri.allocatedMemory);
+}
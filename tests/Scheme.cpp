@@ -0,0 +1,203 @@
+// Copyright (c) 2013 Clodéric Mars
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "Common.h"
+
+#include <curi.h>
+
+#include <cstring>
+
+namespace
+{
+    struct SchemeURI : URI
+    {
+        curi_scheme_id schemeId;
+        int schemeIdCalls;
+    };
+
+    int schemeId(void* userData, curi_scheme_id schemeId)
+    {
+        SchemeURI* uri = static_cast<SchemeURI*>(static_cast<URI*>(userData));
+        uri->schemeId = schemeId;
+        ++uri->schemeIdCalls;
+        return 1;
+    }
+
+    int cancellingSchemeId(void* userData, curi_scheme_id schemeId)
+    {
+        return 0;
+    }
+}
+
+TEST_CASE("Scheme/Lookup", "Well-known schemes")
+{
+    CHECK(curi_scheme_lookup("http", 4) == curi_scheme_http);
+    CHECK(curi_scheme_lookup("https", 5) == curi_scheme_https);
+    CHECK(curi_scheme_lookup("ws", 2) == curi_scheme_ws);
+    CHECK(curi_scheme_lookup("wss", 3) == curi_scheme_wss);
+    CHECK(curi_scheme_lookup("HTTPS", 5) == curi_scheme_https);
+    CHECK(curi_scheme_lookup("http", 3) == curi_scheme_unknown);
+    CHECK(curi_scheme_lookup("httpss", 6) == curi_scheme_unknown);
+    CHECK(curi_scheme_lookup("ftp", 3) == curi_scheme_unknown);
+    CHECK(curi_scheme_lookup("", 0) == curi_scheme_unknown);
+
+    CHECK(curi_scheme_default_port(curi_scheme_http) == 80);
+    CHECK(curi_scheme_default_port(curi_scheme_https) == 443);
+    CHECK(curi_scheme_default_port(curi_scheme_ws) == 80);
+    CHECK(curi_scheme_default_port(curi_scheme_wss) == 443);
+    CHECK(curi_scheme_default_port(curi_scheme_unknown) == 0);
+    CHECK(curi_scheme_default_port((curi_scheme_id)(curi_scheme_wss + 1)) == 0);
+    CHECK(curi_scheme_default_port((curi_scheme_id)-1) == 0);
+}
+
+TEST_CASE("Scheme/Parse", "Parsing URIs with well-known schemes")
+{
+    curi_settings settings;
+    curi_default_settings(&settings);
+    settings.scheme_callback = scheme;
+    settings.scheme_id_callback = schemeId;
+    settings.userinfo_callback = userinfo;
+    settings.host_callback = host;
+    settings.portStr_callback = portStr;
+    settings.path_callback = path;
+    settings.query_callback = query;
+    settings.fragment_callback = fragment;
+
+    SchemeURI uri;
+    uri.clear();
+    uri.schemeId = curi_scheme_unknown;
+    uri.schemeIdCalls = 0;
+
+    SECTION("Known", "")
+    {
+        const char* uris[] = {"http://example.com/a?b#c", "https://example.com/a?b#c", "ws://example.com/a?b#c", "wss://example.com/a?b#c"};
+        const curi_scheme_id ids[] = {curi_scheme_http, curi_scheme_https, curi_scheme_ws, curi_scheme_wss};
+        const char* schemes[] = {"http", "https", "ws", "wss"};
+        size_t i;
+
+        for (i = 0 ; i < sizeof(uris) / sizeof(uris[0]) ; ++i)
+        {
+            INFO(uris[i]);
+            uri.clear();
+
+            CHECK(curi_status_success == curi_parse_full_uri_nt(uris[i], &settings, static_cast<URI*>(&uri)));
+
+            CHECK(uri.schemeId == ids[i]);
+            CHECK(uri.scheme == schemes[i]);
+            CHECK(uri.host == "example.com");
+            CHECK(uri.path == "/a");
+            CHECK(uri.query == "b");
+            CHECK(uri.fragment == "c");
+        }
+    }
+
+    SECTION("Full", "")
+    {
+        const std::string uriStr("https://user@example.com:8443");
+
+        CHECK(curi_status_success == curi_parse_full_uri(uriStr.c_str(), uriStr.length(), &settings, static_cast<URI*>(&uri)));
+
+        CHECK(uri.schemeId == curi_scheme_https);
+        CHECK(uri.schemeIdCalls == 1);
+        CHECK(uri.userinfo == "user");
+        CHECK(uri.host == "example.com");
+        CHECK(uri.portStr == "8443");
+        CHECK(uri.path.empty());
+    }
+
+    SECTION("Uppercase", "")
+    {
+        const std::string uriStr("HTTP://example.com/");
+
+        CHECK(curi_status_success == curi_parse_full_uri(uriStr.c_str(), uriStr.length(), &settings, static_cast<URI*>(&uri)));
+
+        CHECK(uri.schemeId == curi_scheme_http);
+        CHECK(uri.scheme == "HTTP");
+        CHECK(uri.host == "example.com");
+    }
+
+    SECTION("Unknown", "")
+    {
+        const std::string uriStr("ftp://example.com/");
+
+        CHECK(curi_status_success == curi_parse_full_uri(uriStr.c_str(), uriStr.length(), &settings, static_cast<URI*>(&uri)));
+
+        CHECK(uri.schemeId == curi_scheme_unknown);
+        CHECK(uri.schemeIdCalls == 1);
+        CHECK(uri.scheme == "ftp");
+    }
+
+    SECTION("KnownWithoutAuthority", "")
+    {
+        const std::string uriStr("http:/over/there");
+
+        CHECK(curi_status_success == curi_parse_full_uri(uriStr.c_str(), uriStr.length(), &settings, static_cast<URI*>(&uri)));
+
+        CHECK(uri.schemeId == curi_scheme_http);
+        CHECK(uri.host.empty());
+        CHECK(uri.path == "/over/there");
+    }
+
+    SECTION("PrefixOfKnown", "")
+    {
+        const std::string uriStr("httpx://example.com/");
+
+        CHECK(curi_status_success == curi_parse_full_uri(uriStr.c_str(), uriStr.length(), &settings, static_cast<URI*>(&uri)));
+
+        CHECK(uri.schemeId == curi_scheme_unknown);
+        CHECK(uri.scheme == "httpx");
+    }
+
+    SECTION("Truncated", "")
+    {
+        CHECK(curi_status_error == curi_parse_full_uri("https://example.com/", 5, &settings, static_cast<URI*>(&uri)));
+        CHECK(curi_status_success == curi_parse_full_uri("https://example.com/", 8, &settings, static_cast<URI*>(&uri)));
+        CHECK(uri.schemeId == curi_scheme_https);
+        CHECK(uri.host.empty());
+        CHECK(uri.path.empty());
+    }
+
+    SECTION("Components", "")
+    {
+        const std::string uriStr("https://example.com/over/there?name=%zz");
+        settings.components = curi_component_host;
+
+        CHECK(curi_status_partial == curi_parse_full_uri(uriStr.c_str(), uriStr.length(), &settings, static_cast<URI*>(&uri)));
+
+        CHECK(uri.host == "example.com");
+        CHECK(uri.path.empty());
+    }
+
+    SECTION("InvalidAuthority", "")
+    {
+        const std::string uriStr("http://exa[mple.com/");
+
+        CHECK(curi_status_error == curi_parse_full_uri(uriStr.c_str(), uriStr.length(), &settings, static_cast<URI*>(&uri)));
+    }
+
+    SECTION("Cancelled", "")
+    {
+        const std::string uriStr("https://example.com/");
+        settings.scheme_id_callback = cancellingSchemeId;
+
+        CHECK(curi_status_canceled == curi_parse_full_uri(uriStr.c_str(), uriStr.length(), &settings, static_cast<URI*>(&uri)));
+        CHECK(uri.host.empty());
+    }
+}
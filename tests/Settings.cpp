@@ -39,15 +39,32 @@ TEST_CASE("Settings/Default", "default settings")
     CHECK(settings.allocate);
     CHECK(settings.deallocate);
     CHECK(!settings.scheme_callback);
+    CHECK(!settings.scheme_id_callback);
     CHECK(!settings.userinfo_callback);
     CHECK(!settings.host_callback);
     CHECK(!settings.portStr_callback);
+    CHECK(!settings.port_callback);
+    CHECK(!settings.invalid_port_callback);
     CHECK(!settings.path_callback);
     CHECK(!settings.path_segment_callback);
+    CHECK(settings.path_normalization == 0);
     CHECK(!settings.query_callback);
     CHECK(!settings.query_item_str_callback);
     CHECK(settings.query_item_separator == '&');
     CHECK(settings.query_item_key_separator == '=');
+    CHECK(!settings.query_item_separators);
+    CHECK(!settings.query_item_key_separators);
+    CHECK(!settings.query_grammar);
     CHECK(!settings.fragment_callback);
+    CHECK(!settings.url_matcher);
+    CHECK(!settings.url_rule_callback);
     CHECK(settings.url_decode == 0);
+    CHECK(!settings.limits);
+    CHECK(settings.components == 0);
+    CHECK(settings.host_normalization == 0);
+    CHECK(!settings.host_cache);
+    CHECK(!settings.host_table);
+    CHECK(!settings.host_id_callback);
+    CHECK(!settings.public_suffix_list);
+    CHECK(!settings.registrable_domain_callback);
 }
\ No newline at end of file
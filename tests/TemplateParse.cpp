@@ -0,0 +1,117 @@
+// Copyright (c) 2013 Clodéric Mars
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "Common.h"
+
+#include <curi.hpp>
+
+#include <string>
+
+namespace
+{
+    struct HostHandler
+    {
+        void host(std::string_view str) { host_ = str; }
+
+        std::string_view host_;
+    };
+
+    struct FullHandler
+    {
+        void scheme(std::string_view str) { uri.scheme = std::string(str); }
+        void userinfo(std::string_view str) { uri.userinfo = std::string(str); }
+        void host(std::string_view str) { uri.host = std::string(str); }
+        void host_ipv4(std::uint32_t address) { uri.hostIPv4 = address; }
+        void host_ipv6(const std::array<unsigned char, 16>& address) { uri.hostIPv6.assign(address.begin(), address.end()); }
+        void port(std::string_view str) { uri.portStr = std::string(str); }
+        void port_number(std::uint16_t number) { uri.port = number; }
+        void path_segment(std::string_view str) { uri.pathSegments.push_back(std::string(str)); }
+        void path(std::string_view str) { uri.path = std::string(str); }
+        void query(std::string_view str) { uri.query = std::string(str); }
+        void fragment(std::string_view str) { uri.fragment = std::string(str); }
+
+        URI uri;
+    };
+
+    struct CancellingHandler
+    {
+        bool path_segment(std::string_view str)
+        {
+            ++segmentCount;
+            return str != "stop";
+        }
+
+        int segmentCount = 0;
+    };
+}
+
+TEST_CASE("TemplateParse/Handler", "Parsing with statically called handler methods")
+{
+    SECTION("Narrow", "")
+    {
+        HostHandler handler;
+        CHECK(curi::parse("http://user@www.example.com:8080/path?query#fragment", handler) == curi_status_success);
+        CHECK(handler.host_ == "www.example.com");
+
+        CHECK(curi::parse("http://www.example.org:port/", handler) == curi_status_error);
+    }
+
+    SECTION("Empty", "")
+    {
+        struct {} handler;
+        CHECK(curi::parse("http://www.example.com/", handler) == curi_status_success);
+        CHECK(curi::parse("http://www.example.com/%zz", handler) == curi_status_error);
+    }
+
+    SECTION("Full", "")
+    {
+        FullHandler handler;
+        handler.uri.clear();
+        CHECK(curi::parse("http://user@192.168.0.1:8080/a//b?q=1#top", handler) == curi_status_success);
+        CHECK(handler.uri.scheme == "http");
+        CHECK(handler.uri.userinfo == "user");
+        CHECK(handler.uri.host == "192.168.0.1");
+        CHECK(handler.uri.hostIPv4 == 0xC0A80001);
+        CHECK(handler.uri.portStr == "8080");
+        CHECK(handler.uri.port == 8080);
+        CHECK(handler.uri.path == "/a//b");
+        REQUIRE(handler.uri.pathSegments.size() == 3);
+        CHECK(handler.uri.pathSegments[0] == "a");
+        CHECK(handler.uri.pathSegments[1] == "");
+        CHECK(handler.uri.pathSegments[2] == "b");
+        CHECK(handler.uri.query == "q=1");
+        CHECK(handler.uri.fragment == "top");
+
+        handler.uri.clear();
+        CHECK(curi::parse("http://[::1]:99999", handler) == curi_status_success);
+        CHECK(handler.uri.host == "[::1]");
+        REQUIRE(handler.uri.hostIPv6.size() == 16);
+        CHECK(handler.uri.hostIPv6[15] == 1);
+        CHECK(handler.uri.portStr == "99999");
+        CHECK(handler.uri.port == 0);
+    }
+
+    SECTION("Canceled", "")
+    {
+        CancellingHandler handler;
+        CHECK(curi::parse("http://www.example.com/go/stop/never", handler) == curi_status_canceled);
+        CHECK(handler.segmentCount == 2);
+    }
+}
@@ -0,0 +1,184 @@
+// Copyright (c) 2013 Clodéric Mars
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "Common.h"
+
+#include <curi.h>
+
+#include <cstring>
+
+static const curi_url_rule rules[] = {
+    { "example.com", 0 },
+    { "example.com", "/admin" },
+    { 0, "/.git" },
+    { "ads.example.com", "/" },
+    { "Tracker.NET", "" },
+    { "com", "/login" },
+    { "example.com", "/admin/public" }
+};
+
+static const size_t ruleCount = sizeof(rules) / sizeof(rules[0]);
+
+static std::vector<size_t> match(const curi_url_matcher* matcher, const char* host, const char* path)
+{
+    size_t ruleIds[16];
+    size_t matchCount = 0;
+    curi_url_matcher_match(matcher, host, strlen(host), path, strlen(path), ruleIds, 16, &matchCount);
+    return std::vector<size_t>(ruleIds, ruleIds + matchCount);
+}
+
+static std::vector<size_t> ids(size_t id0 = (size_t)-1, size_t id1 = (size_t)-1, size_t id2 = (size_t)-1)
+{
+    std::vector<size_t> result;
+    if (id0 != (size_t)-1)
+        result.push_back(id0);
+    if (id1 != (size_t)-1)
+        result.push_back(id1);
+    if (id2 != (size_t)-1)
+        result.push_back(id2);
+    return result;
+}
+
+TEST_CASE("UrlMatcher/Match", "Matching hosts and paths against rules")
+{
+    URI uri;
+    uri.clear();
+
+    curi_settings settings;
+    curi_default_settings(&settings);
+    settings.allocate = test_allocate;
+    settings.deallocate = test_deallocate;
+
+    curi_url_matcher* matcher = curi_url_matcher_create(rules, ruleCount, &settings, &uri);
+    REQUIRE(matcher);
+
+    SECTION("HostSuffix", "")
+    {
+        CHECK(match(matcher, "example.com", "/") == ids(0));
+        CHECK(match(matcher, "www.example.com", "/index.html") == ids(0));
+        CHECK(match(matcher, "WWW.EXAMPLE.COM.", "") == ids(0));
+        CHECK(match(matcher, "badexample.com", "/") == ids());
+        CHECK(match(matcher, "example.org", "/") == ids());
+        CHECK(match(matcher, "cdn.tracker.net", "/pixel") == ids(4));
+    }
+
+    SECTION("PathPrefix", "")
+    {
+        CHECK(match(matcher, "example.org", "/.git/config") == ids(2));
+        CHECK(match(matcher, "", "/.git") == ids(2));
+        CHECK(match(matcher, "example.org", "/.gi") == ids());
+        CHECK(match(matcher, "other.com", "/login/form") == ids(5));
+    }
+
+    SECTION("Both", "")
+    {
+        CHECK(match(matcher, "example.com", "/administrator") == ids(0, 1));
+        CHECK(match(matcher, "example.com", "/admin/public/x") == ids(0, 1, 6));
+        CHECK(match(matcher, "ads.example.com", "/banner") == ids(0, 3));
+        CHECK(match(matcher, "example.com", "/.git") == ids(2, 0));
+    }
+
+    SECTION("First", "")
+    {
+        size_t ruleId = 42;
+        CHECK(curi_status_success == curi_url_matcher_first(matcher, "example.com", 11, "/.git", 5, &ruleId));
+        CHECK(ruleId == 0);
+        CHECK(curi_status_success == curi_url_matcher_first(matcher, "ads.example.com", 15, "/admin", 6, &ruleId));
+        CHECK(ruleId == 0);
+        CHECK(curi_status_success == curi_url_matcher_first(matcher, "a.com", 5, "/login", 6, &ruleId));
+        CHECK(ruleId == 5);
+        CHECK(curi_status_error == curi_url_matcher_first(matcher, "example.org", 11, "/", 1, &ruleId));
+    }
+
+    SECTION("Capacity", "")
+    {
+        size_t ruleId = 42;
+        size_t matchCount = 0;
+        CHECK(curi_status_success == curi_url_matcher_match(matcher, "example.com", 11, "/admin/public", 13, &ruleId, 1, &matchCount));
+        CHECK(matchCount == 3);
+        CHECK(ruleId == 0);
+        CHECK(curi_status_error == curi_url_matcher_match(matcher, "example.org", 11, "/", 1, &ruleId, 1, &matchCount));
+        CHECK(matchCount == 0);
+    }
+
+    curi_url_matcher_destroy(matcher);
+    CHECK(uri.deallocatedMemory == uri.allocatedMemory);
+}
+
+TEST_CASE("UrlMatcher/InvalidRules", "Compiling invalid rules")
+{
+    URI uri;
+    uri.clear();
+
+    curi_settings settings;
+    curi_default_settings(&settings);
+    settings.allocate = test_allocate;
+    settings.deallocate = test_deallocate;
+
+    const curi_url_rule emptyLabel[] = { { "example..com", 0 } };
+    CHECK(!curi_url_matcher_create(emptyLabel, 1, &settings, &uri));
+    const curi_url_rule leadingDot[] = { { ".example.com", 0 } };
+    CHECK(!curi_url_matcher_create(leadingDot, 1, &settings, &uri));
+    CHECK(uri.deallocatedMemory == uri.allocatedMemory);
+}
+
+static int collectRule(void* userData, size_t ruleId)
+{
+    static_cast<std::vector<size_t>*>(userData)->push_back(ruleId);
+    return 1;
+}
+
+TEST_CASE("UrlMatcher/Parse", "Matching rules while parsing")
+{
+    curi_settings settings;
+    curi_default_settings(&settings);
+    settings.url_matcher = curi_url_matcher_create(rules, ruleCount, 0, 0);
+    settings.url_rule_callback = collectRule;
+    REQUIRE(settings.url_matcher);
+
+    std::vector<size_t> ruleIds;
+
+    SECTION("Authority", "")
+    {
+        CHECK(curi_status_success == curi_parse_full_uri_nt("https://user@ads.example.com:8080/admin?q#f", &settings, &ruleIds));
+        CHECK(ruleIds == ids(0, 1, 3));
+    }
+
+    SECTION("NoAuthority", "")
+    {
+        CHECK(curi_status_success == curi_parse_full_uri_nt("file:/.git/config", &settings, &ruleIds));
+        CHECK(ruleIds == ids(2));
+    }
+
+    SECTION("NoMatch", "")
+    {
+        CHECK(curi_status_success == curi_parse_full_uri_nt("http://example.org/", &settings, &ruleIds));
+        CHECK(ruleIds.empty());
+    }
+
+    SECTION("Cancelled", "")
+    {
+        settings.url_rule_callback = cancellingCallbackSizeT;
+        CHECK(curi_status_canceled == curi_parse_full_uri_nt("http://example.com/", &settings, &ruleIds));
+        CHECK(curi_status_success == curi_parse_full_uri_nt("http://example.org/", &settings, &ruleIds));
+    }
+
+    curi_url_matcher_destroy((curi_url_matcher*)settings.url_matcher);
+}